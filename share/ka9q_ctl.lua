@@ -2,7 +2,7 @@
 -- UDP port: 5006
 --
 -- Wire format:
---   u8 msg_class  (0=STATUS, 1=CMD)
+--   u8 msg_class  (0=STATUS, 1=CMD, 2=STATUS_DELTA, 3=HISTORY, 4=SIGNALS)
 --   repeated TLVs:
 --     u8  tlv_type
 --     len (BER-style):
@@ -26,7 +26,7 @@ ka9q.prefs.show_raw_packet     = Pref.bool("Show raw packet bytes (debug)", fals
 
 -- Fields
 local f = ka9q.fields
-f.msg_class = ProtoField.uint8("ka9qctl.class", "Packet Type", base.DEC, { [0]="STATUS", [1]="CMD" })
+f.msg_class = ProtoField.uint8("ka9qctl.class", "Packet Type", base.DEC, { [0]="STATUS", [1]="CMD", [2]="STATUS_DELTA", [3]="HISTORY", [4]="SIGNALS" })
 f.raw_packet = ProtoField.bytes("ka9qctl.raw", "Raw Packet Data")
 
 f.tlv_type  = ProtoField.uint8("ka9qctl.tlv.type", "TLV Type", base.DEC)
@@ -165,7 +165,38 @@ local STATUS_TYPE_NAME = {
   [114] = "OPUS_FEC",
   [115] = "SPECTRUM_STEP",
   [116] = "SPECTRUM_OVERLAP",
-  [117] = "LIFETIME"
+  [117] = "LIFETIME",
+  [118] = "FE_XFER_QUEUE",
+  [119] = "FE_XFER_SIZE",
+  [120] = "FE_XFER_FAILURES",
+  [121] = "FE_XFER_LATENCY",
+  [122] = "OUTPUT_DROPS",
+  [123] = "OPUS_LATENCY",
+  [124] = "OPUS_BACKLOG",
+  [125] = "STATUS_REFRESH",
+  [126] = "COMMAND_DROPS",
+  [127] = "COMMANDS_COALESCED",
+  [128] = "BIN_COMPRESSION",
+  [129] = "BIN_RICE_DATA",
+  [130] = "SPECTRUM_LATENCY",
+  [131] = "SPECTRUM_TAP",
+  [132] = "SPECTRUM_HISTORY",
+  [133] = "HISTORY_START",
+  [134] = "HISTORY_END",
+  [135] = "HISTORY_REMAINING",
+  [136] = "SPECTRUM_DETECTOR",
+  [137] = "SPECTRUM_PERCENTILE",
+  [138] = "BIN_SEQUENCE",
+  [139] = "BIN_OFFSET",
+  [140] = "SPECTRUM_DIRECT",
+  [141] = "OCCUPANCY_THRESHOLD",
+  [142] = "OCCUPANCY_INTERVAL",
+  [143] = "SIGNAL_COUNT",
+  [144] = "SIGNAL_FREQUENCY",
+  [145] = "SIGNAL_BANDWIDTH",
+  [146] = "SIGNAL_SNR",
+  [147] = "SIGNAL_FIRST",
+  [148] = "SIGNAL_LAST"
 }
 
 -- Reverse lookup: name -> type ID
@@ -294,7 +325,38 @@ local TLV_KIND = {
   [114] = "uint",
   [115] = "f32_db",
   [116] = "f32",
-  [117] = "uint"
+  [117] = "uint",
+  [118] = "uint",
+  [119] = "uint",
+  [120] = "uint",
+  [121] = "f32_list",
+  [122] = "uint",
+  [123] = "f32",
+  [124] = "uint",
+  [125] = "uint",
+  [126] = "uint",
+  [127] = "uint",
+  [128] = "uint",
+  [129] = "",
+  [130] = "f32",
+  [131] = "bool",
+  [132] = "uint",
+  [133] = "gps_ns",
+  [134] = "gps_ns",
+  [135] = "uint",
+  [136] = "uint",
+  [137] = "f32",
+  [138] = "uint",
+  [139] = "uint",
+  [140] = "bool",
+  [141] = "f32_db",
+  [142] = "f32_s",
+  [143] = "uint",
+  [144] = "f64_hz",
+  [145] = "f32_hz",
+  [146] = "f32_db",
+  [147] = "gps_ns",
+  [148] = "gps_ns"
 }
 
 -- ---- Helpers ----
@@ -983,7 +1045,7 @@ function ka9q.dissector(tvb, pinfo, tree)
   offset = offset + 1
 
   local info_parts = {}
-  if ka9q.prefs.add_info_column then
+    table.insert(info_parts, (msg_class == 1) and "CMD " or (msg_class == 3) and "HIST" or (msg_class == 4) and "SIGS" or "STAT")
     table.insert(info_parts, (msg_class == 1) and "CMD " or "STAT")
   end
 
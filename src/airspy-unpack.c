@@ -127,3 +127,17 @@ int airspy_unpack(float *restrict wptr, uint32_t const *restrict up,
   }
   return over;
 }
+
+// Pack signed 12-bit codes the way the device does, for fe-bench mock transfers
+void airspy_pack(uint32_t *restrict up, int const *restrict codes, int sampcount){
+  for(int i=0; i < sampcount; i += 8){ // assumes multiple of 8
+    uint32_t s[8];
+    for(int j=0; j < 8; j++)
+      s[j] = (uint32_t)(codes[j] + 2048) & 0xfff;
+    up[0] = s[0] << 20 | s[1] << 8 | s[2] >> 4;
+    up[1] = s[2] << 28 | s[3] << 16 | s[4] << 4 | s[5] >> 8;
+    up[2] = s[5] << 24 | s[6] << 12 | s[7];
+    codes += 8;
+    up += 3;
+  }
+}
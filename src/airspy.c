@@ -107,6 +107,7 @@ static int rx_callback(airspy_transfer *transfer);
 static void *airspy_monitor(void *p);
 static double true_freq(uint64_t freq);
 static void set_gain(struct sdrstate *sdr,int gainstep);
+static void set_format(struct sdrstate *sdr,dictionary *Dictionary,char const *section,double default_samprate);
 
 int airspy_setup(struct frontend * const frontend,dictionary * const Dictionary,char const * const section){
   assert(Dictionary != NULL);
@@ -224,18 +225,7 @@ int airspy_setup(struct frontend * const frontend,dictionary * const Dictionary,
     fprintf(stderr,"\n");
     funlockfile(stderr);
   }
-  {
-    frontend->samprate = sdr->sample_rates[0];  // Default to first (highest) sample rate on list
-    char const *p = config_getstring(Dictionary,section,"samprate",NULL);
-    if(p != NULL)
-      frontend->samprate = parse_frequency(p,false);
-  }
-  frontend->isreal = true;
-  frontend->bitspersample = 12;
-  sdr->offset = frontend->samprate/4;
-  sdr->converter = config_getdouble(Dictionary,section,"converter",0);
-  frontend->calibrate = config_getdouble(Dictionary,section,"calibrate",0);
-  frontend->rf_level_cal = NAN; // varies wildly with frequency; uncalibrated
+  set_format(sdr,Dictionary,section,sdr->sample_rates[0]); // Default to first (highest) sample rate on list
 
   fprintf(stderr,"Set sample rate %'lf Hz, offset %'lf Hz\n",frontend->samprate,sdr->offset);
   {
@@ -243,9 +233,6 @@ int airspy_setup(struct frontend * const frontend,dictionary * const Dictionary,
     ret = airspy_set_samplerate(sdr->device,(uint32_t)frontend->samprate);
     assert(ret == AIRSPY_SUCCESS);
   }
-  frontend->max_IF = -600000;
-  frontend->min_IF = -0.47 * frontend->samprate;
-
   sdr->gainstep = -1; // Force update first time
 
   // Hardware device settings
@@ -325,6 +312,65 @@ int airspy_setup(struct frontend * const frontend,dictionary * const Dictionary,
   }
   return 0;
 }
+// Sample rate and everything derived from it, shared by airspy_setup() and airspy_mock_setup()
+static void set_format(struct sdrstate * const sdr,dictionary * const Dictionary,char const * const section,double const default_samprate){
+  struct frontend * const frontend = sdr->frontend;
+  frontend->samprate = default_samprate;
+  {
+    char const *p = config_getstring(Dictionary,section,"samprate",NULL);
+    if(p != NULL)
+      frontend->samprate = parse_frequency(p,false);
+  }
+  frontend->isreal = true;
+  frontend->bitspersample = 12;
+  sdr->offset = frontend->samprate/4;
+  sdr->converter = config_getdouble(Dictionary,section,"converter",0);
+  frontend->calibrate = config_getdouble(Dictionary,section,"calibrate",0);
+  frontend->rf_level_cal = NAN; // varies wildly with frequency; uncalibrated
+  frontend->max_IF = -600000;
+  frontend->min_IF = -0.47 * frontend->samprate;
+}
+
+// fe-bench -m: the driver with libairspy's transport replaced by canned transfers
+// No device, so the gains stay at zero and the software AGC stays off
+int airspy_mock_setup(struct frontend * const frontend,dictionary * const Dictionary,char const * const section){
+  assert(Dictionary != NULL);
+  struct sdrstate * const sdr = calloc(1,sizeof(struct sdrstate));
+  assert(sdr != NULL);
+  sdr->frontend = frontend;
+  frontend->context = sdr;
+  set_format(sdr,Dictionary,section,20e6); // R2 A/D rate
+  sdr->software_agc = false;
+  strlcpy(frontend->description,"airspy mock",sizeof(frontend->description));
+  sdr->scale = scale_AD(frontend);
+  return 0;
+}
+
+// Pack 'count' samples (+/-1 = full scale, count a multiple of 8) into one raw transfer as libairspy would deliver it
+// libairspy has no failed transfers, so samples == NULL gives NULL. Transfer and samples are one block; free() it
+void *airspy_mock_transfer(struct frontend * const frontend,float const * const samples,int const count){
+  if(samples == NULL)
+    return NULL;
+  assert((count % 8) == 0);
+  airspy_transfer * const transfer = calloc(1,sizeof(*transfer) + count * 3 / 2); // 12 bits/sample
+  assert(transfer != NULL);
+  transfer->ctx = frontend->context;
+  transfer->samples = transfer + 1;
+  transfer->sample_count = count;
+  transfer->sample_type = AIRSPY_SAMPLE_RAW;
+  int * const codes = malloc(count * sizeof(int));
+  assert(codes != NULL);
+  for(int i=0; i < count; i++)
+    codes[i] = mock_ad_code(samples[i],12);
+  airspy_pack(transfer->samples,codes,count);
+  free(codes);
+  return transfer;
+}
+
+void airspy_mock_callback(void * const transfer){
+  rx_callback((airspy_transfer *)transfer);
+}
+
 int airspy_startup(struct frontend * const frontend){
   struct sdrstate * const sdr = (struct sdrstate *)frontend->context;
   while(true){
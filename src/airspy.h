@@ -5,4 +5,5 @@ int airspy_unpack_avx2(float *restrict wptr, uint32_t const *restrict up,
 #endif
 int airspy_unpack(float *restrict wptr, uint32_t const *restrict up,
 		  int sampcount, float scale, uint64_t *energy);
-
+// Inverse of airspy_unpack(), for fe-bench mock transfers: codes are signed, -2048 to +2047
+void airspy_pack(uint32_t *restrict up, int const *restrict codes, int sampcount);
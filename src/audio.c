@@ -14,6 +14,16 @@
 #include <stdint.h>
 #include <errno.h>
 #include <stdatomic.h>
+#include <pthread.h>
+#ifdef __linux__
+#include <semaphore.h>
+#endif
+#include <sys/socket.h>
+#include <netinet/udp.h>
+#include <time.h>
+#ifdef __linux__
+#include <linux/net_tstamp.h> // struct sock_txtime
+#endif
 #include <opus/opus.h>
 
 #include "misc.h"
@@ -33,9 +43,191 @@ int Fec_percent = 0;               // Use forward error correction percentage, 0
 
 static atomic_flag Opus_version_logged = ATOMIC_FLAG_INIT;
 
+/* Optional batched transmit path ("batch-output = yes" in [global])
+   Instead of calling sendto() for every packet, the demod threads queue finished packets
+   and one sender thread drains the queues with sendmmsg(). With thousands of channels this
+   turns 100k+ syscalls/sec into a few hundred.
+
+   The queues are bounded multi-producer, single consumer rings (Vyukov's algorithm). A channel
+   always uses the same ring, so its packets go out in order. They're sharded by channel rather
+   than by CPU because demod threads migrate between cores.
+*/
+bool Batch_output = false;
+
+#define OUTQ_SHARDS 8      // Rings, to spread producer contention
+#define OUTQ_SLOTS 1024    // Packets per ring, power of 2
+#define OUTQ_PKTSIZE 1500  // Inline packet buffer; anything bigger (e.g., long Opus frames) is copied to the heap
+#define OUTQ_BATCH 64      // Packets per sendmmsg() call
+
+#ifndef __linux__
+// No sendmmsg() elsewhere; flush_batch() sends each packet of a batch with its own sendmsg()
+struct mmsghdr {
+  struct msghdr msg_hdr;
+  unsigned int msg_len;
+};
+#endif
+
+struct outq_slot {
+  _Atomic size_t seq;
+  chan_t *chan;         // for error counting. Channel_list entries are never freed
+  int fd;
+  socklen_t slen;
+  struct sockaddr_storage dest;
+  int len;
+  uint8_t *data;        // == buf unless the packet didn't fit
+  uint8_t buf[OUTQ_PKTSIZE];
+};
+
+struct outq {
+  _Alignas(64) _Atomic size_t head; // next slot to fill, shared by producers
+  _Alignas(64) size_t tail;         // next slot to send, owned by the sender thread
+  struct outq_slot *slots;
+};
+
+static struct outq Outq[OUTQ_SHARDS];
+#ifdef __linux__
+static sem_t Outq_sem;              // Posted by producers after queuing packets
+#else
+// macOS doesn't have unnamed semaphores
+static pthread_mutex_t Outq_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t Outq_cond = PTHREAD_COND_INITIALIZER;
+static int Outq_posts;              // Posted by producers after queuing packets
+#endif
+static pthread_t Output_sender_thread;
+static atomic_flag Outq_full_logged = ATOMIC_FLAG_INIT;
+
+/* UDP generic segmentation offload (Linux 4.18+)
+   A wideband PCM channel emits thousands of equal-size packets per second. With GSO we build a run of
+   them back to back in one buffer, each with its own RTP header, and hand the lot to the kernel in one
+   sendmsg(). It splits the buffer into datagrams of the first packet's size; only the last may be shorter.
+*/
+#define GSO_MAXSEGS 64       // UDP_MAX_SEGMENTS in the kernel
+#define GSO_MAXBYTES 65000   // Keep under the 64 KiB IP datagram limit
+static atomic_bool Gso_available = true; // Cleared the first time the kernel rejects it
+
+// Our internal sample format. Sent as is, without conversion, when it's also the output encoding
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define F32_NATIVE F32LE
+#else
+#define F32_NATIVE F32BE
+#endif
+
+/* Optional Opus encoder pool ("opus-threads = N" in [global])
+   Opus at high complexity can cost more than the demodulation itself, and a burst of speech across
+   a big FM raster can then make the demod threads late for their next block. With a pool, send_output()
+   just copies each block into a small per-channel queue and a pool thread does the rest: aggregation,
+   encoding and sending. Each channel keeps its own encoder, and is handled by one pool thread at a time,
+   so its packets stay in order. The queues are single producer (the demod thread), single consumer
+   (whichever pool thread holds the channel), so need no locks; only the run queue of channels with
+   work waiting has one.
+*/
+int Opus_threads = 0;
+
+#define OPUS_JOBS 8   // blocks queued per channel before we start dropping
+
+struct opus_job {
+  float *samples;
+  int size;           // floats allocated
+  int frames;
+  int channels;       // chan->output.channels when queued
+  int gap;            // frames dropped before this block, for the RTP timestamp
+  bool mute;
+  int64_t queued;     // gps_time_ns()
+};
+
+struct opus_queue {
+  _Atomic unsigned head;   // next job to fill, written only by the demod thread
+  _Atomic unsigned tail;   // next job to encode, written only by the pool
+  _Atomic bool scheduled;  // on the run queue or being worked on
+  int gap;                 // frames dropped since the last job queued; demod thread only
+  struct opus_job jobs[OPUS_JOBS];
+};
+
+/* Output pacing (per-channel "pacing = yes")
+   A wideband channel produces a whole frame's worth of packets at once. Sent back to back they can overrun
+   a switch port or a receiver with a small socket buffer. Instead each packet gets a launch time from its RTP
+   timestamp, so the packets of each frame are spread evenly across the frame time, and the demod thread goes
+   straight on without sleeping.
+
+   With "txtime = tai" (ETF qdisc) or "txtime = monotonic" (fq qdisc) in [global] the kernel holds each packet
+   until its launch time (SO_TXTIME, Linux 4.19+). Otherwise a pacer thread keeps copies of the packets in a
+   heap ordered by launch time and sends each one when it comes due.
+*/
+#define PACE_SLOTS 4096      // Packets waiting in the pacer, all channels
+
+struct pace_slot {
+  int64_t when;         // launch time, ns on CLOCK_MONOTONIC
+  uint64_t order;       // tie breaker, so a channel's packets due at the same time stay in order
+  chan_t *chan;
+  int fd;
+  socklen_t slen;
+  struct sockaddr_storage dest;
+  int len;
+  uint8_t *data;        // == buf unless the packet didn't fit
+  uint8_t buf[OUTQ_PKTSIZE];
+};
+
+static clockid_t Pace_clock = CLOCK_MONOTONIC;
+static int Txtime_fd = -1;   // Copies of Output_fd and Output_fd0 with SO_TXTIME enabled, when in use
+static int Txtime_fd0 = -1;
+static pthread_once_t Pacer_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t Pace_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t Pace_cond;
+static struct pace_slot *Pace_pool;
+static struct pace_slot **Pace_heap;  // min-heap on (when, order)
+static struct pace_slot **Pace_free;  // stack of unused slots
+static int Pace_count;
+static int Pace_nfree;
+static uint64_t Pace_order;
+static atomic_flag Pace_full_logged = ATOMIC_FLAG_INIT;
+
+/* Bundled output (per-channel "bundle = yes")
+   A big raster of narrow channels sends one small packet per channel per block, and the packet rate
+   rather than the bit rate is what swamps switches and receivers. Bundled channels with the same destination
+   share a datagram that carries their complete RTP packets (format in rtp.h). It goes out when the next
+   packet won't fit, or when its oldest packet has waited a quarter block.
+*/
+int Bundle_size = 8972;  // Max bundle, "bundle-size" in [global]. Default fits a 9000-byte jumbo frame
+#define BUNDLES 64       // Destinations
+
+struct bundle {
+  pthread_mutex_t lock;
+  int fd;
+  socklen_t slen;
+  struct sockaddr_storage dest;
+  chan_t *chan;          // last channel to add a packet, for error counting
+  int len;               // bytes so far, including the bundle header
+  int count;             // packets
+  int64_t first;         // when the oldest packet was added, gps_time_ns()
+  uint8_t *buf;          // Bundle_size bytes
+};
+
+static struct bundle Bundles[BUNDLES]; // Never freed, so channels can cache pointers to them
+static _Atomic int Nbundles;
+static pthread_mutex_t Bundles_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t Bundler_once = PTHREAD_ONCE_INIT;
+static atomic_flag Bundles_full_logged = ATOMIC_FLAG_INIT;
+
+static pthread_mutex_t Opus_runq_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t Opus_runq_cond = PTHREAD_COND_INITIALIZER;
+static chan_t *Opus_runq[Nchannels]; // A channel is never on it more than once
+static int Opus_runq_head;
+static int Opus_runq_count;
+
 static inline void sanity_check(float const *buf, int count);
+static int output_frames(chan_t * restrict const chan, float const * restrict buffer, int frames, bool const mute);
+static int queue_opus(chan_t *chan,float const *buffer,int frames,bool mute);
 static int setup_opus(chan_t *chan);
 static int max_frames(chan_t *chan);
+static int setup_queue(chan_t *chan,int size);
+static void send_error(chan_t *chan,int err);
+static bool enqueue_output(chan_t *chan,int fd,uint8_t const *packet,int bytes);
+static void send_gso(chan_t *chan,int fd,uint8_t const *buffer,int len,int segsize,int count);
+static void *output_sender(void *arg);
+static void outq_post(void);
+static int64_t launch_time(chan_t *chan,uint32_t timestamp);
+static void send_paced(chan_t *chan,int fd,struct msghdr *msg,int64_t when);
+static void bundle_packet(chan_t *chan,int fd,struct iovec const *iov,int iovcnt);
 
 // Send PCM output on stream; # of channels implicit in chan->output.channels
 int send_output(chan_t * restrict const chan, float const * restrict buffer, int frames, bool const mute){
@@ -43,6 +235,20 @@ int send_output(chan_t * restrict const chan, float const * restrict buffer, int
   if(chan == NULL || frames <= 0 || chan->output.channels == 0 || chan->output.samprate == 0)
     return 0;
 
+  if(Opus_threads > 0 && (chan->output.encoding == OPUS || chan->output.encoding == OPUS_VOIP))
+    return queue_opus(chan,buffer,frames,mute);
+
+  if(chan->opus.queue != NULL)
+    opus_release(chan); // Encoding just changed; let the pool finish with this channel first
+  return output_frames(chan,buffer,frames,mute);
+}
+
+// Aggregate, encode and send. Called by the demod thread, or by an Opus pool thread
+static int output_frames(chan_t * restrict const chan, float const * restrict buffer, int frames, bool const mute){
+  assert(chan != NULL);
+  if(chan == NULL || frames <= 0 || chan->output.channels == 0 || chan->output.samprate == 0)
+    return 0;
+
   if(mute || buffer == NULL){
     // Still increment timestamp
     if(chan->output.encoding == OPUS || chan->output.encoding == OPUS_VOIP)
@@ -58,8 +264,25 @@ int send_output(chan_t * restrict const chan, float const * restrict buffer, int
     return 0;
 
   int const max_frames_per_pkt = max_frames(chan); // depends on coding
-  useconds_t const pacing = chan->output.pacing ? 1000 : 0; // fix it at a millisecond for now
+  if(setup_queue(chan,max_frames_per_pkt) != 0)
+    return 0;
   int frames_sent = 0;
+  bool queued = false;
+  // Opus packets vary in size so they can't be segmented
+  bool const gso = chan->output.gso && !chan->output.pacing && !chan->output.bundle
+    && atomic_load_explicit(&Gso_available,memory_order_relaxed)
+    && chan->output.encoding != OPUS && chan->output.encoding != OPUS_VOIP;
+  bool const batch = Batch_output && !chan->output.pacing && !chan->output.bundle;
+  int const outsock = chan->output.ttl != 0 ? Output_fd : Output_fd0;
+  // On the direct path, a packet goes out as two pieces: header and payload. Native floats need no conversion,
+  // so the payload can then come straight from the queue or the caller's buffer
+  bool const direct = !gso && !batch;
+  bool const zerocopy = direct && chan->output.encoding == F32_NATIVE;
+  // When gso is set, successive packets are built one after the other in here
+  uint8_t packet[PKTSIZE];
+  int gso_len = 0;     // bytes
+  int gso_count = 0;   // packets
+  int gso_segsize = 0; // size of the first packet
   int available_frames = chan->output.queue_length + frames;
   while(available_frames >= max_frames_per_pkt
 	|| (available_frames > 0 && chan->output.queue_age >= chan->output.maxdelay)){
@@ -74,8 +297,12 @@ int send_output(chan_t * restrict const chan, float const * restrict buffer, int
     };
     chan->output.silent = false;
 
-    uint8_t packet[PKTSIZE];
-    uint8_t * const dp = (uint8_t *)hton_rtp(packet,&rtp); // First byte after RTP header to be written
+    if(gso && gso_count > 0 && (gso_count == GSO_MAXSEGS || gso_len + gso_segsize > GSO_MAXBYTES)){
+      send_gso(chan,outsock,packet,gso_len,gso_segsize,gso_count);
+      gso_len = gso_count = 0;
+    }
+    uint8_t * const pkt = packet + gso_len;
+    uint8_t * const dp = (uint8_t *)hton_rtp(pkt,&rtp); // First byte after RTP header to be written
     int chunk = frames;
     float const *buf = buffer;
 
@@ -83,20 +310,12 @@ int send_output(chan_t * restrict const chan, float const * restrict buffer, int
       // There's something in the buffer, send it first
       if(chan->output.queue_length < max_frames_per_pkt){
 	// Try to fill it out with new data if available
+	// setup_queue() made sure there's room
 	int copylen = max_frames_per_pkt - chan->output.queue_length;
 	if(copylen > frames)
 	  copylen = frames; // limit to what we have
 	assert(chan->output.queue != NULL);
 	sanity_check(chan->output.queue, chan->output.queue_length * chan->output.channels);
-	{
-	  // Use a temp so a realloc failure doesn't leak the old queue.
-	  float *tmp = realloc(chan->output.queue, (chan->output.queue_length + copylen) * chan->output.channels * sizeof(float));
-	  chan->output.queue = tmp;
-	}
-	assert(chan->output.queue != NULL);
-	if(chan->output.queue == NULL)
-	  return frames_sent; // Not sure recovery is really possible
-	sanity_check(chan->output.queue, chan->output.queue_length * chan->output.channels);
 	memcpy(chan->output.queue + chan->output.channels * chan->output.queue_length,
 	       buffer, copylen * chan->output.channels * sizeof(float));
 	chan->output.queue_length += copylen;
@@ -112,31 +331,34 @@ int send_output(chan_t * restrict const chan, float const * restrict buffer, int
 
     uint8_t *ndp = NULL; // pointer to first unwritten byte after export call
     int const samples = chunk * chan->output.channels;
-    switch(chan->output.encoding){
+    switch(zerocopy ? -1 : (int)chan->output.encoding){
+    case -1:
+      ndp = dp + samples * sizeof(float); // payload is buf itself
+      break;
     case MULAW:
-      ndp = export_mulaw(dp,buf,samples);
+      ndp = export_mulaw_vec(dp,buf,samples);
       break;
     case ALAW:
-      ndp = export_alaw(dp,buf,samples);
+      ndp = export_alaw_vec(dp,buf,samples);
       break;
     case S16BE:
-      ndp = export_s16_be(dp,buf,samples);
+      ndp = export_s16_be_vec(dp,buf,samples);
       break;
     case S16LE:
-      ndp = export_s16_le(dp,buf,samples);
+      ndp = export_s16_le_vec(dp,buf,samples);
       break;
     case F32BE:
-      ndp = export_f32_be(dp,buf,samples);
+      ndp = export_f32_be_vec(dp,buf,samples);
       break;
     case F32LE:
-      ndp = export_f32_le(dp,buf,samples);
+      ndp = export_f32_le_vec(dp,buf,samples);
       break;
 #ifdef HAS_FLOAT16
     case F16LE:
-      ndp = export_f16_le(dp,buf,samples);
+      ndp = export_f16_le_vec(dp,buf,samples);
       break;
     case F16BE:
-      ndp = export_f16_be(dp,buf,samples);
+      ndp = export_f16_be_vec(dp,buf,samples);
       break;
 #endif
     case OPUS_VOIP:
@@ -171,7 +393,7 @@ int send_output(chan_t * restrict const chan, float const * restrict buffer, int
     }
     if(ndp == NULL)
       break; // No valid encoding
-    int const bytes = ndp - packet;
+    int const bytes = ndp - pkt;
 
     if(chan->output.encoding == OPUS || chan->output.encoding == OPUS_VOIP)
       chan->output.rtp.timestamp += chunk * OPUS_SAMPRATE / chan->output.samprate; // Always increases at 48 kHz
@@ -185,6 +407,7 @@ int send_output(chan_t * restrict const chan, float const * restrict buffer, int
       chan->output.queue_length -= chunk;
       assert(chan->output.queue_length >= 0);
       if(chan->output.queue_length > 0){
+	// Only when Opus shortened the frame, so never more than one packet's worth
 	memmove(chan->output.queue,
 		chan->output.queue + chunk * chan->output.channels,
 		chan->output.queue_length * chan->output.channels * sizeof(float));
@@ -200,35 +423,58 @@ int send_output(chan_t * restrict const chan, float const * restrict buffer, int
     frames_sent += chunk;
 
     if(bytes > 0){ // Suppress Opus DTX frames (bytes == 0)
-      int const outsock = chan->output.ttl != 0 ? Output_fd : Output_fd0;
-      socklen_t const slen = chan->output.dest_socket.ss_family == AF_INET ? sizeof(struct sockaddr_in) : sizeof(struct sockaddr_in6);
-      ssize_t const r = sendto(outsock, &packet, bytes, 0, (struct sockaddr *)&chan->output.dest_socket, slen);
       chan->output.rtp.bytes += bytes;
       chan->output.rtp.packets++;
       chan->output.rtp.seq++;
-      if(r < 0){
-	chan->output.errors++;
-	if(errno == EAGAIN){
-	  if(!atomic_flag_test_and_set_explicit(&TempSendFailure,memory_order_relaxed)){
-	    fprintf(stderr,"%s Temporary send failure, suggest increased buffering (see sysctl net.core.wmem_max, net.core.wmem_default\n",
-		    chan->name);
-	    fprintf(stderr,"Additional messages suppressed\n");
-	  }
-	} else {
-	  if(!atomic_flag_test_and_set_explicit(&TempSendFailure,memory_order_relaxed)){
-	    fprintf(stderr,"%s audio send failure: %s (any additional messages suppressed)\n",chan->name,strerror(errno));
-	  }
+      if(gso){
+	if(gso_count > 0 && bytes > gso_segsize){
+	  // Can't follow a shorter packet; send those and start over with this one
+	  send_gso(chan,outsock,packet,gso_len,gso_segsize,gso_count);
+	  memmove(packet,pkt,bytes);
+	  gso_len = gso_count = 0;
 	}
+	if(gso_count == 0)
+	  gso_segsize = bytes;
+	gso_len += bytes;
+	gso_count++;
+	if(bytes < gso_segsize){
+	  // A short packet has to be the last
+	  send_gso(chan,outsock,packet,gso_len,gso_segsize,gso_count);
+	  gso_len = gso_count = 0;
+	}
+      } else if(batch){
+	queued = enqueue_output(chan,outsock,pkt,bytes) || queued;
+      } else {
+	// buf stays valid until the next pass; we only refill the queue after it's empty
+	struct iovec iov[2] = {
+	  { .iov_base = pkt, .iov_len = dp - pkt },
+	  { .iov_base = zerocopy ? (void *)buf : dp, .iov_len = ndp - dp }
+	};
+	struct msghdr msg = {
+	  .msg_name = &chan->output.dest_socket,
+	  .msg_namelen = chan->output.dest_socket.ss_family == AF_INET ? sizeof(struct sockaddr_in) : sizeof(struct sockaddr_in6),
+	  .msg_iov = iov,
+	  .msg_iovlen = 2
+	};
+	if(chan->output.bundle)
+	  bundle_packet(chan,outsock,iov,2);
+	else if(chan->output.pacing)
+	  send_paced(chan,outsock,&msg,launch_time(chan,rtp.timestamp));
+	else if(sendmsg(outsock, &msg, 0) < 0)
+	  send_error(chan,errno);
       }
-      if(chan->output.pacing && available_frames > 0)
-	usleep(pacing);
     }
   }
  quit:
+  if(gso_count > 0)
+    send_gso(chan,outsock,packet,gso_len,gso_segsize,gso_count);
+  if(queued)
+    outq_post(); // Once per call, not per packet
   // Any left that we must buffer?
+  // Normally fewer than a packet's worth. More only after an encoder failure; drop the excess
+  if(frames > chan->output.queue_size - chan->output.queue_length)
+    frames = chan->output.queue_size - chan->output.queue_length;
   if(frames > 0){
-    assert(chan->output.queue != NULL || chan->output.queue_length == 0);
-    chan->output.queue = realloc(chan->output.queue, (chan->output.queue_length + frames) * chan->output.channels * sizeof(float));
     assert(chan->output.queue != NULL);
     memcpy(chan->output.queue + chan->output.channels * chan->output.queue_length,
 	   buffer,
@@ -242,6 +488,679 @@ int send_output(chan_t * restrict const chan, float const * restrict buffer, int
   return frames_sent;
 }
 
+// Hand a block to the Opus pool. Called from the demod thread
+static int queue_opus(chan_t *chan,float const *buffer,int frames,bool mute){
+  struct opus_queue *q = chan->opus.queue;
+  if(q == NULL){
+    q = calloc(1,sizeof *q);
+    if(q == NULL)
+      return output_frames(chan,buffer,frames,mute);
+    chan->opus.queue = q;
+  }
+  unsigned const head = atomic_load_explicit(&q->head,memory_order_relaxed);
+  if(head - atomic_load_explicit(&q->tail,memory_order_acquire) >= OPUS_JOBS){
+    // Pool has fallen behind. Drop the block but keep the timestamps right
+    q->gap += frames;
+    chan->output.drops++;
+    return 0;
+  }
+  struct opus_job * const job = &q->jobs[head % OPUS_JOBS];
+  job->frames = frames;
+  job->channels = chan->output.channels;
+  job->gap = q->gap;
+  q->gap = 0;
+  job->mute = mute || buffer == NULL;
+  if(!job->mute){
+    int const n = frames * job->channels;
+    if(job->size < n){
+      // Only until the block size settles down
+      FREE(job->samples);
+      job->samples = malloc(n * sizeof *job->samples);
+      job->size = job->samples != NULL ? n : 0;
+    }
+    if(job->samples != NULL)
+      memcpy(job->samples,buffer,n * sizeof *job->samples);
+    else
+      job->mute = true;
+  }
+  job->queued = gps_time_ns();
+  atomic_store_explicit(&q->head,head + 1,memory_order_release);
+
+  if(!atomic_exchange(&q->scheduled,true)){
+    pthread_mutex_lock(&Opus_runq_mutex);
+    assert(Opus_runq_count < Nchannels);
+    Opus_runq[(Opus_runq_head + Opus_runq_count++) % Nchannels] = chan;
+    pthread_cond_signal(&Opus_runq_cond);
+    pthread_mutex_unlock(&Opus_runq_mutex);
+  }
+  return frames;
+}
+
+static void *opus_worker(void *arg){
+  char name[16];
+  snprintf(name,sizeof name,"opus%d",(int)(intptr_t)arg);
+  pthread_setname(name);
+
+  while(true){
+    pthread_mutex_lock(&Opus_runq_mutex);
+    while(Opus_runq_count == 0)
+      pthread_cond_wait(&Opus_runq_cond,&Opus_runq_mutex);
+    chan_t * const chan = Opus_runq[Opus_runq_head];
+    Opus_runq_head = (Opus_runq_head + 1) % Nchannels;
+    Opus_runq_count--;
+    pthread_mutex_unlock(&Opus_runq_mutex);
+
+    struct opus_queue * const q = chan->opus.queue;
+    do {
+      unsigned tail = atomic_load_explicit(&q->tail,memory_order_relaxed);
+      while(tail != atomic_load_explicit(&q->head,memory_order_acquire)){
+	struct opus_job * const job = &q->jobs[tail % OPUS_JOBS];
+	if(job->gap > 0)
+	  output_frames(chan,NULL,job->gap,true);
+	if(job->channels != chan->output.channels)
+	  job->mute = true; // Changed while queued; the samples are no good
+	output_frames(chan,job->mute ? NULL : job->samples,job->frames,job->mute);
+	double const latency = 1e-9 * (gps_time_ns() - job->queued);
+	chan->opus.latency += 0.1 * (latency - chan->opus.latency);
+	atomic_store_explicit(&q->tail,++tail,memory_order_release);
+      }
+      atomic_store(&q->scheduled,false);
+      // Anything queued after we looked, and nobody else picked it up?
+    } while(atomic_load(&q->head) != atomic_load(&q->tail) && !atomic_exchange(&q->scheduled,true));
+  }
+  return NULL;
+}
+
+// Start the Opus pool. Call once, from loadconfig()
+int start_opus_pool(int nthreads){
+  for(int i=0; i < nthreads; i++){
+    pthread_t t;
+    if(pthread_create(&t,NULL,opus_worker,(void *)(intptr_t)i) != 0)
+      return -1;
+    pthread_detach(t);
+  }
+  Opus_threads = nthreads;
+  return 0;
+}
+
+// Wait for the pool to finish with a channel, then free its queue. Called from the demod thread
+void opus_release(chan_t *chan){
+  struct opus_queue * const q = chan->opus.queue;
+  if(q == NULL)
+    return;
+  while(atomic_load(&q->scheduled) || atomic_load(&q->head) != atomic_load(&q->tail))
+    usleep(1000);
+  for(int i=0; i < OPUS_JOBS; i++)
+    FREE(q->jobs[i].samples);
+  FREE(chan->opus.queue);
+}
+
+// Blocks waiting in the pool for this channel
+int opus_backlog(chan_t const *chan){
+  struct opus_queue const * const q = chan->opus.queue;
+  if(q == NULL)
+    return 0;
+  return atomic_load_explicit(&q->head,memory_order_relaxed) - atomic_load_explicit(&q->tail,memory_order_relaxed);
+}
+
+// Count and (once) report a failed send
+static void send_error(chan_t *chan,int err){
+  chan->output.errors++;
+  if(err == EAGAIN || err == EWOULDBLOCK || err == ENOBUFS){
+    chan->output.drops++;
+    if(!atomic_flag_test_and_set_explicit(&TempSendFailure,memory_order_relaxed)){
+      fprintf(stderr,"%s Temporary send failure, suggest increased buffering (see sysctl net.core.wmem_max, net.core.wmem_default\n",
+	      chan->name);
+      fprintf(stderr,"Additional messages suppressed\n");
+    }
+  } else {
+    if(!atomic_flag_test_and_set_explicit(&TempSendFailure,memory_order_relaxed)){
+      fprintf(stderr,"%s audio send failure: %s (any additional messages suppressed)\n",chan->name,strerror(err));
+    }
+  }
+}
+
+// Send count packets, each segsize bytes except maybe the last, in one call if the kernel can split them
+static void send_gso(chan_t *chan,int fd,uint8_t const *buffer,int len,int segsize,int count){
+  socklen_t const slen = chan->output.dest_socket.ss_family == AF_INET ? sizeof(struct sockaddr_in) : sizeof(struct sockaddr_in6);
+#ifdef UDP_SEGMENT
+  if(count > 1 && atomic_load_explicit(&Gso_available,memory_order_relaxed)){
+    struct iovec iov = {
+      .iov_base = (void *)buffer,
+      .iov_len = len
+    };
+    union {
+      uint8_t buf[CMSG_SPACE(sizeof(uint16_t))];
+      struct cmsghdr align;
+    } control;
+    struct msghdr msg = {
+      .msg_name = &chan->output.dest_socket,
+      .msg_namelen = slen,
+      .msg_iov = &iov,
+      .msg_iovlen = 1,
+      .msg_control = control.buf,
+      .msg_controllen = sizeof control.buf
+    };
+    struct cmsghdr * const cm = CMSG_FIRSTHDR(&msg);
+    cm->cmsg_level = SOL_UDP;
+    cm->cmsg_type = UDP_SEGMENT;
+    cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+    uint16_t const gso_size = segsize;
+    memcpy(CMSG_DATA(cm),&gso_size,sizeof gso_size);
+
+    if(sendmsg(fd,&msg,0) >= 0)
+      return;
+    if(errno != EIO && errno != EINVAL && errno != ENOPROTOOPT && errno != EOPNOTSUPP && errno != EMSGSIZE){
+      send_error(chan,errno);
+      return;
+    }
+    // Old kernel, an output interface without checksum offload, or packets bigger than its MTU
+    // (which sendto() would fragment but GSO won't). Don't try again
+    if(atomic_exchange_explicit(&Gso_available,false,memory_order_relaxed))
+      fprintf(stderr,"UDP GSO unavailable (%s), sending packets individually\n",strerror(errno));
+  }
+#endif
+  // One at a time
+  for(int i = 0; i < count; i++){
+    int const size = min(segsize,len);
+    if(sendto(fd, buffer, size, 0, (struct sockaddr *)&chan->output.dest_socket, slen) < 0)
+      send_error(chan,errno);
+    buffer += size;
+    len -= size;
+  }
+}
+
+// Nanoseconds on the pacing clock
+static inline int64_t pace_now(void){
+  struct timespec ts;
+  clock_gettime(Pace_clock,&ts);
+  return (int64_t)ts.tv_sec * BILLION + ts.tv_nsec;
+}
+
+/* When to send the packet with this RTP timestamp
+   Launch times follow the RTP clock from an anchor, which is reset whenever we've fallen behind it
+   (a late block, or the first one) or gotten too far ahead (a gap in the timestamps) */
+static int64_t launch_time(chan_t *chan,uint32_t timestamp){
+  // The kernel drops packets that reach an ETF qdisc after their launch time, so allow for getting there
+  int64_t const now = pace_now() + (Txtime_fd >= 0 ? 1000000 : 0);
+  int const rate = (chan->output.encoding == OPUS || chan->output.encoding == OPUS_VOIP) ? OPUS_SAMPRATE : chan->output.samprate;
+  int64_t when = chan->output.pace_time + (int64_t)(int32_t)(timestamp - chan->output.pace_ts) * BILLION / rate;
+  if(chan->output.pace_time == 0 || when < now || when > now + (int64_t)(2 * Blocktime * BILLION)){
+    chan->output.pace_time = now;
+    chan->output.pace_ts = timestamp;
+    when = now;
+  }
+  return when;
+}
+
+static bool pace_before(struct pace_slot const *a,struct pace_slot const *b){
+  return a->when < b->when || (a->when == b->when && a->order < b->order);
+}
+
+static void *pacer(void *arg){
+  (void)arg;
+  pthread_setname("pacer");
+  pthread_mutex_lock(&Pace_mutex);
+  while(true){
+    if(Pace_count == 0){
+      pthread_cond_wait(&Pace_cond,&Pace_mutex);
+      continue;
+    }
+    struct pace_slot * const slot = Pace_heap[0];
+    if(slot->when > pace_now()){
+      int64_t when = slot->when;
+#ifndef __linux__
+      // No pthread_condattr_setclock() on macOS, so the wait is timed on CLOCK_REALTIME
+      struct timespec rt;
+      clock_gettime(CLOCK_REALTIME,&rt);
+      when += (int64_t)rt.tv_sec * BILLION + rt.tv_nsec - pace_now();
+#endif
+      struct timespec const ts = {
+	.tv_sec = when / BILLION,
+	.tv_nsec = when % BILLION
+      };
+      pthread_cond_timedwait(&Pace_cond,&Pace_mutex,&ts);
+      continue; // Something earlier may have been queued meanwhile
+    }
+    // Remove the root
+    struct pace_slot * const last = Pace_heap[--Pace_count];
+    int i = 0;
+    while(true){
+      int c = 2*i + 1;
+      if(c >= Pace_count)
+	break;
+      if(c + 1 < Pace_count && pace_before(Pace_heap[c+1],Pace_heap[c]))
+	c++;
+      if(!pace_before(Pace_heap[c],last))
+	break;
+      Pace_heap[i] = Pace_heap[c];
+      i = c;
+    }
+    Pace_heap[i] = last;
+    pthread_mutex_unlock(&Pace_mutex);
+
+    if(slot->len > 0 && sendto(slot->fd,slot->data,slot->len,0,(struct sockaddr *)&slot->dest,slot->slen) < 0)
+      send_error(slot->chan,errno);
+    if(slot->data != slot->buf)
+      FREE(slot->data);
+
+    pthread_mutex_lock(&Pace_mutex);
+    Pace_free[Pace_nfree++] = slot;
+  }
+  return NULL;
+}
+
+// First use of the pacer thread. On failure Pace_pool stays NULL and paced packets go out at once
+static void start_pacer(void){
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+#ifdef __linux__
+  pthread_condattr_setclock(&attr,CLOCK_MONOTONIC);
+#endif
+  pthread_cond_init(&Pace_cond,&attr);
+  pthread_condattr_destroy(&attr);
+
+  struct pace_slot * const pool = calloc(PACE_SLOTS,sizeof *pool);
+  Pace_heap = calloc(PACE_SLOTS,sizeof *Pace_heap);
+  Pace_free = calloc(PACE_SLOTS,sizeof *Pace_free);
+  if(pool == NULL || Pace_heap == NULL || Pace_free == NULL){
+    fprintf(stderr,"can't allocate output pacer\n");
+    return;
+  }
+  for(int i=0; i < PACE_SLOTS; i++)
+    Pace_free[i] = &pool[i];
+  Pace_nfree = PACE_SLOTS;
+  pthread_t t;
+  if(pthread_create(&t,NULL,pacer,NULL) != 0){
+    fprintf(stderr,"can't start output pacer\n");
+    return;
+  }
+  pthread_detach(t);
+  Pace_pool = pool;
+}
+
+// Send a packet at the given time (on Pace_clock), without waiting for it
+static void send_paced(chan_t *chan,int fd,struct msghdr *msg,int64_t when){
+#ifdef SO_TXTIME
+  if(Txtime_fd >= 0){
+    union {
+      uint8_t buf[CMSG_SPACE(sizeof(uint64_t))];
+      struct cmsghdr align;
+    } control;
+    msg->msg_control = control.buf;
+    msg->msg_controllen = sizeof control.buf;
+    struct cmsghdr * const cm = CMSG_FIRSTHDR(msg);
+    cm->cmsg_level = SOL_SOCKET;
+    cm->cmsg_type = SCM_TXTIME;
+    cm->cmsg_len = CMSG_LEN(sizeof(uint64_t));
+    uint64_t const txtime = when;
+    memcpy(CMSG_DATA(cm),&txtime,sizeof txtime);
+    if(sendmsg(fd == Output_fd ? Txtime_fd : Txtime_fd0,msg,0) < 0)
+      send_error(chan,errno);
+    return;
+  }
+#endif
+  pthread_once(&Pacer_once,start_pacer);
+  if(Pace_pool == NULL){
+    if(sendmsg(fd,msg,0) < 0)
+      send_error(chan,errno);
+    return;
+  }
+  int len = 0;
+  for(size_t i=0; i < msg->msg_iovlen; i++)
+    len += msg->msg_iov[i].iov_len;
+
+  pthread_mutex_lock(&Pace_mutex);
+  if(Pace_nfree == 0){
+    pthread_mutex_unlock(&Pace_mutex);
+    chan->output.drops++;
+    if(!atomic_flag_test_and_set_explicit(&Pace_full_logged,memory_order_relaxed))
+      fprintf(stderr,"%s output pacer full, packets dropped (additional messages suppressed)\n",chan->name);
+    return;
+  }
+  struct pace_slot * const slot = Pace_free[--Pace_nfree];
+  slot->when = when;
+  slot->order = Pace_order++;
+  slot->chan = chan;
+  slot->fd = fd;
+  slot->slen = msg->msg_namelen;
+  memcpy(&slot->dest,msg->msg_name,msg->msg_namelen);
+  slot->data = len <= (int)sizeof slot->buf ? slot->buf : malloc(len);
+  slot->len = slot->data != NULL ? len : 0; // pacer will skip it
+  uint8_t *dp = slot->data;
+  for(size_t i=0; slot->len > 0 && i < msg->msg_iovlen; i++){
+    memcpy(dp,msg->msg_iov[i].iov_base,msg->msg_iov[i].iov_len);
+    dp += msg->msg_iov[i].iov_len;
+  }
+  // Sift up
+  int i = Pace_count++;
+  while(i > 0 && pace_before(slot,Pace_heap[(i-1)/2])){
+    Pace_heap[i] = Pace_heap[(i-1)/2];
+    i = (i-1)/2;
+  }
+  Pace_heap[i] = slot;
+  if(i == 0)
+    pthread_cond_signal(&Pace_cond); // New earliest packet
+  pthread_mutex_unlock(&Pace_mutex);
+}
+
+// Have the kernel pace output with SO_TXTIME. fd and fd0 are spare sockets like Output_fd and Output_fd0
+// clockname is "tai" for the ETF qdisc or "monotonic" for fq
+int setup_txtime(int fd,int fd0,char const *clockname){
+#ifdef SO_TXTIME
+  clockid_t clock;
+  if(strcasecmp(clockname,"tai") == 0 || strcasecmp(clockname,"etf") == 0)
+    clock = CLOCK_TAI;
+  else if(strcasecmp(clockname,"monotonic") == 0 || strcasecmp(clockname,"fq") == 0)
+    clock = CLOCK_MONOTONIC;
+  else {
+    errno = EINVAL;
+    return -1;
+  }
+  struct sock_txtime const txtime = {
+    .clockid = clock,
+    .flags = 0
+  };
+  if(setsockopt(fd,SOL_SOCKET,SO_TXTIME,&txtime,sizeof txtime) != 0
+     || setsockopt(fd0,SOL_SOCKET,SO_TXTIME,&txtime,sizeof txtime) != 0)
+    return -1;
+  Pace_clock = clock;
+  Txtime_fd = fd;
+  Txtime_fd0 = fd0;
+  return 0;
+#else
+  (void)fd; (void)fd0; (void)clockname;
+  errno = ENOPROTOOPT;
+  return -1;
+#endif
+}
+
+// Send a bundle and empty it. Caller holds its lock
+static void send_bundle(struct bundle *b){
+  b->buf[0] = RTP_BUNDLE_MAGIC0;
+  b->buf[1] = RTP_BUNDLE_MAGIC1;
+  b->buf[2] = b->count >> 8;
+  b->buf[3] = b->count;
+  if(sendto(b->fd,b->buf,b->len,0,(struct sockaddr *)&b->dest,b->slen) < 0)
+    send_error(b->chan,errno);
+  b->len = RTP_BUNDLE_HDR;
+  b->count = 0;
+}
+
+// Send bundles that have waited long enough
+static void *bundler(void *arg){
+  (void)arg;
+  pthread_setname("bundler");
+  while(true){
+    int64_t maxage = (int64_t)(Blocktime * BILLION / 4);
+    if(maxage <= 0)
+      maxage = 5000000; // Shouldn't happen
+    struct timespec const ts = {
+      .tv_sec = 0,
+      .tv_nsec = maxage / 2
+    };
+    nanosleep(&ts,NULL);
+    int64_t const now = gps_time_ns();
+    int const n = atomic_load_explicit(&Nbundles,memory_order_acquire);
+    for(int i=0; i < n; i++){
+      struct bundle * const b = &Bundles[i];
+      pthread_mutex_lock(&b->lock);
+      if(b->count > 0 && now - b->first >= maxage)
+	send_bundle(b);
+      pthread_mutex_unlock(&b->lock);
+    }
+  }
+  return NULL;
+}
+
+static void start_bundler(void){
+  pthread_t t;
+  if(pthread_create(&t,NULL,bundler,NULL) == 0)
+    pthread_detach(t);
+  else
+    fprintf(stderr,"can't start output bundler\n");
+}
+
+// Find or create the bundle for a channel's destination
+static struct bundle *find_bundle(chan_t *chan,int fd,socklen_t slen){
+  pthread_mutex_lock(&Bundles_mutex);
+  int const n = atomic_load_explicit(&Nbundles,memory_order_relaxed);
+  struct bundle *b = NULL;
+  for(int i=0; i < n; i++){
+    if(Bundles[i].fd == fd && Bundles[i].slen == slen && memcmp(&Bundles[i].dest,&chan->output.dest_socket,slen) == 0){
+      b = &Bundles[i];
+      break;
+    }
+  }
+  if(b == NULL && n < BUNDLES){
+    uint8_t * const buf = malloc(Bundle_size);
+    if(buf != NULL){
+      b = &Bundles[n];
+      pthread_mutex_init(&b->lock,NULL);
+      b->fd = fd;
+      b->slen = slen;
+      memcpy(&b->dest,&chan->output.dest_socket,slen);
+      b->len = RTP_BUNDLE_HDR;
+      b->count = 0;
+      b->buf = buf;
+      atomic_store_explicit(&Nbundles,n+1,memory_order_release);
+      pthread_once(&Bundler_once,start_bundler);
+    }
+  }
+  pthread_mutex_unlock(&Bundles_mutex);
+  if(b == NULL && !atomic_flag_test_and_set_explicit(&Bundles_full_logged,memory_order_relaxed))
+    fprintf(stderr,"%s: too many bundle destinations, sending unbundled (additional messages suppressed)\n",chan->name);
+  return b;
+}
+
+// Add a packet to the channel's bundle, sending the bundle first if it won't fit
+static void bundle_packet(chan_t *chan,int fd,struct iovec const *iov,int iovcnt){
+  int len = 0;
+  for(int i=0; i < iovcnt; i++)
+    len += iov[i].iov_len;
+  socklen_t const slen = chan->output.dest_socket.ss_family == AF_INET ? sizeof(struct sockaddr_in) : sizeof(struct sockaddr_in6);
+  struct bundle *b = chan->output.bundler;
+  if(b == NULL || b->fd != fd || b->slen != slen || memcmp(&b->dest,&chan->output.dest_socket,slen) != 0)
+    b = chan->output.bundler = find_bundle(chan,fd,slen); // First time, or the destination changed
+  int const space = RTP_BUNDLE_PKTHDR + ((len + 3) & ~3);
+  if(b == NULL || RTP_BUNDLE_HDR + space > Bundle_size){
+    // Send it alone
+    struct msghdr msg = {
+      .msg_name = &chan->output.dest_socket,
+      .msg_namelen = slen,
+      .msg_iov = (struct iovec *)iov,
+      .msg_iovlen = iovcnt
+    };
+    if(sendmsg(fd,&msg,0) < 0)
+      send_error(chan,errno);
+    return;
+  }
+  pthread_mutex_lock(&b->lock);
+  if(b->len + space > Bundle_size)
+    send_bundle(b);
+  if(b->count == 0)
+    b->first = gps_time_ns();
+  uint8_t *dp = b->buf + b->len;
+  *dp++ = len >> 8;
+  *dp++ = len;
+  *dp++ = 0;
+  *dp++ = 0;
+  for(int i=0; i < iovcnt; i++){
+    memcpy(dp,iov[i].iov_base,iov[i].iov_len);
+    dp += iov[i].iov_len;
+  }
+  memset(dp,0,space - RTP_BUNDLE_PKTHDR - len); // pad
+  b->len += space;
+  b->count++;
+  b->chan = chan;
+  pthread_mutex_unlock(&b->lock);
+}
+
+// Create the output rings and start the sender thread. Call once, after the output sockets exist
+int start_output_sender(void){
+  for(int i=0; i < OUTQ_SHARDS; i++){
+    struct outq * const q = &Outq[i];
+    q->slots = calloc(OUTQ_SLOTS,sizeof *q->slots);
+    if(q->slots == NULL)
+      return -1;
+    for(size_t j=0; j < OUTQ_SLOTS; j++)
+      atomic_init(&q->slots[j].seq,j);
+    atomic_init(&q->head,0);
+    q->tail = 0;
+  }
+#ifdef __linux__
+  sem_init(&Outq_sem,0,0);
+#endif
+  pthread_create(&Output_sender_thread,NULL,output_sender,NULL);
+  return 0;
+}
+
+// Wake the sender after queuing packets
+static void outq_post(void){
+#ifdef __linux__
+  sem_post(&Outq_sem);
+#else
+  pthread_mutex_lock(&Outq_mutex);
+  Outq_posts++;
+  pthread_cond_signal(&Outq_cond);
+  pthread_mutex_unlock(&Outq_mutex);
+#endif
+}
+
+// Wait for at least one post, and take every post so far; one pass of the sender handles them all
+static void outq_wait(void){
+#ifdef __linux__
+  while(sem_wait(&Outq_sem) != 0)
+    ;
+  while(sem_trywait(&Outq_sem) == 0)
+    ;
+#else
+  pthread_mutex_lock(&Outq_mutex);
+  while(Outq_posts == 0)
+    pthread_cond_wait(&Outq_cond,&Outq_mutex);
+  Outq_posts = 0;
+  pthread_mutex_unlock(&Outq_mutex);
+#endif
+}
+
+// Copy a finished packet into the channel's ring. Called from the channel's demod thread
+static bool enqueue_output(chan_t *chan,int fd,uint8_t const *packet,int bytes){
+  struct outq * const q = &Outq[(chan - Channel_list) % OUTQ_SHARDS];
+  struct outq_slot *slot;
+  size_t pos = atomic_load_explicit(&q->head,memory_order_relaxed);
+  while(true){
+    slot = &q->slots[pos & (OUTQ_SLOTS-1)];
+    size_t const seq = atomic_load_explicit(&slot->seq,memory_order_acquire);
+    intptr_t const dif = (intptr_t)seq - (intptr_t)pos;
+    if(dif == 0){
+      if(atomic_compare_exchange_weak_explicit(&q->head,&pos,pos+1,memory_order_relaxed,memory_order_relaxed))
+	break; // slot is ours
+    } else if(dif < 0){
+      // Full; the sender has fallen a whole ring behind
+      chan->output.drops++;
+      if(!atomic_flag_test_and_set_explicit(&Outq_full_logged,memory_order_relaxed))
+	fprintf(stderr,"%s output queue full, packets dropped (additional messages suppressed)\n",chan->name);
+      return false;
+    } else
+      pos = atomic_load_explicit(&q->head,memory_order_relaxed);
+  }
+  slot->chan = chan;
+  slot->fd = fd;
+  slot->slen = chan->output.dest_socket.ss_family == AF_INET ? sizeof(struct sockaddr_in) : sizeof(struct sockaddr_in6);
+  memcpy(&slot->dest,&chan->output.dest_socket,slot->slen);
+  slot->len = bytes;
+  slot->data = bytes <= (int)sizeof slot->buf ? slot->buf : malloc(bytes);
+  if(slot->data == NULL)
+    slot->len = 0; // sender will skip it
+  else
+    memcpy(slot->data,packet,bytes);
+  atomic_store_explicit(&slot->seq,pos+1,memory_order_release);
+  return true;
+}
+
+// Send a batch on one socket and release its slots
+static void flush_batch(int fd,struct mmsghdr *msgs,struct outq_slot **slots,int count){
+  int i = 0;
+  while(i < count){
+#ifdef __linux__
+    int const r = sendmmsg(fd,msgs + i,count - i,0);
+#else
+    int const r = sendmsg(fd,&msgs[i].msg_hdr,0) < 0 ? -1 : 1;
+#endif
+    if(r < 0){
+      // Message i failed. Skip it and carry on with the rest
+      if(errno == EINTR)
+	continue;
+      send_error(slots[i]->chan,errno);
+      i++;
+    } else
+      i += r;
+  }
+  for(i=0; i < count; i++){
+    struct outq_slot * const slot = slots[i];
+    if(slot->data != slot->buf)
+      FREE(slot->data);
+    // Free the slot for the producers. Slots in a ring are released in the order they were filled
+    size_t const pos = atomic_load_explicit(&slot->seq,memory_order_relaxed) - 1;
+    atomic_store_explicit(&slot->seq,pos + OUTQ_SLOTS,memory_order_release);
+  }
+}
+
+// Drain all the rings whenever somebody posts, batching by output socket
+static void *output_sender(void *arg){
+  (void)arg;
+  pthread_setname("outsend");
+  // Output_fd and Output_fd0
+  struct mmsghdr msgs[2][OUTQ_BATCH];
+  struct iovec iovs[2][OUTQ_BATCH];
+  struct outq_slot *slots[2][OUTQ_BATCH];
+  int count[2] = {0};
+  memset(msgs,0,sizeof msgs);
+
+  while(true){
+    outq_wait();
+    bool more;
+    do {
+      more = false;
+      for(int shard = 0; shard < OUTQ_SHARDS; shard++){
+	struct outq * const q = &Outq[shard];
+	// Take up to a batch's worth from each ring in turn so one busy ring can't starve the rest
+	for(int n = 0; n < OUTQ_BATCH; n++){
+	  struct outq_slot * const slot = &q->slots[q->tail & (OUTQ_SLOTS-1)];
+	  if(atomic_load_explicit(&slot->seq,memory_order_acquire) != q->tail + 1)
+	    break; // empty, or next slot still being filled
+	  q->tail++;
+	  more = true;
+	  if(slot->len == 0){
+	    atomic_store_explicit(&slot->seq,q->tail - 1 + OUTQ_SLOTS,memory_order_release);
+	    continue;
+	  }
+	  int const s = slot->fd == Output_fd ? 0 : 1;
+	  int const k = count[s]++;
+	  iovs[s][k].iov_base = slot->data;
+	  iovs[s][k].iov_len = slot->len;
+	  msgs[s][k].msg_hdr.msg_name = &slot->dest;
+	  msgs[s][k].msg_hdr.msg_namelen = slot->slen;
+	  msgs[s][k].msg_hdr.msg_iov = &iovs[s][k];
+	  msgs[s][k].msg_hdr.msg_iovlen = 1;
+	  slots[s][k] = slot;
+	  if(count[s] == OUTQ_BATCH){
+	    flush_batch(slot->fd,msgs[s],slots[s],count[s]);
+	    count[s] = 0;
+	  }
+	}
+      }
+      // Don't hold packets back waiting for a full batch
+      if(count[0] > 0)
+	flush_batch(Output_fd,msgs[0],slots[0],count[0]);
+      if(count[1] > 0)
+	flush_batch(Output_fd0,msgs[1],slots[1],count[1]);
+      count[0] = count[1] = 0;
+    } while(more);
+  }
+  return NULL;
+}
+
 static int setup_opus(chan_t *chan){
   if(chan->opus.encoder != NULL){
     // There doesn't seem to be any way to read back the channel count, so we save that explicitly
@@ -368,6 +1287,30 @@ static int setup_opus(chan_t *chan){
   }
   return 0;
 }
+/* Make sure the aggregation queue can hold a full packet
+   The queue never holds more than one packet's worth: as soon as there's that much, it goes out.
+   So it only needs to be allocated once, or again if the encoding, sample rate or channel count change,
+   and the realtime path never touches the heap
+*/
+static int setup_queue(chan_t *chan,int size){
+  if(size <= 0 || (chan->output.queue_size >= size && chan->output.queue_channels == chan->output.channels))
+    return 0;
+
+  float *queue = malloc(size * chan->output.channels * sizeof(float));
+  if(queue == NULL)
+    return -1;
+  // Keep what's there if we can, otherwise start over
+  if(chan->output.queue_channels == chan->output.channels && chan->output.queue_length > 0)
+    memcpy(queue,chan->output.queue,chan->output.queue_length * chan->output.channels * sizeof(float));
+  else
+    chan->output.queue_length = 0;
+  FREE(chan->output.queue);
+  chan->output.queue = queue;
+  chan->output.queue_size = size;
+  chan->output.queue_channels = chan->output.channels;
+  return 0;
+}
+
 static int max_frames(chan_t *chan){
   // The PCM modes are limited by the Ethenet MTU
   // Opus is essentially unlimited as it should never fill an ethernet (?)
@@ -390,6 +1333,7 @@ static int max_frames(chan_t *chan){
     break;
 #endif
   case OPUS:
+  case OPUS_VOIP:
     max_frames_per_pkt = lrint(chan->output.samprate * 0.12); // 120 ms is biggest Opus frame regardless of channels
     break;
   case MULAW:
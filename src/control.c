@@ -706,7 +706,7 @@ int main(int argc,char *argv[]){
       socklen_t ssize = sizeof(source_socket);
       length = recvfrom(Status_fd,buffer,sizeof(buffer),0,(struct sockaddr *)&source_socket,&ssize); // should not block
       // Ignore our own command packets and responses to other SSIDs
-      if(length < 3 || (enum pkt_type)buffer[0] != STATUS || !for_us(buffer+1,length-1,Ssrc))
+      if(length < 3 || ((enum pkt_type)buffer[0] != STATUS && (enum pkt_type)buffer[0] != STATUS_DELTA) || !for_us(buffer+1,length-1,Ssrc))
 	continue; // Can include a timeout
 
       // Process only if it's a response to our SSRC
@@ -1761,8 +1761,35 @@ static void display_demodulator(WINDOW *w,chan_t const *chan){
     }
     pprintw(w, row++, col, "Avg","%u   ",chan->spectrum.fft_avg);
     pprintw(w, row++, col, "Overlap", "%.3lf   ",chan->spectrum.overlap);
+    pprintw(w, row++, col, "Latency", "%.1lf ms",1000 * chan->spectrum.latency);
     pprintw(w, row++, col, "Min", "%.1lf dB", chan->spectrum.base);
     pprintw(w, row++, col, "Max", "%.1lf dB", chan->spectrum.base + 255 * chan->spectrum.step);
+    if(chan->spectrum.compression == BIN_RICE)
+      pprintw(w, row++, col, "Compression", "Rice");
+    if(chan->spectrum.tap)
+      pprintw(w, row++, col, "Source", "FE FFT");
+    else if(chan->spectrum.direct)
+      pprintw(w, row++, col, "Source", "Block");
+    if(chan->spectrum.history_rows > 0)
+      pprintw(w, row++, col, "History", "%d rows",chan->spectrum.history_rows);
+    if(chan->spectrum.occupancy_threshold > 0)
+      pprintw(w, row++, col, "Occupancy", "%.1f dB",chan->spectrum.occupancy_threshold);
+    switch(chan->spectrum.detector){
+    default:
+      break;
+    case DETECT_PEAK:
+      pprintw(w, row++, col, "Detector", "peak hold");
+      break;
+    case DETECT_MIN:
+      pprintw(w, row++, col, "Detector", "min hold");
+      break;
+    case DETECT_PERCENTILE:
+      pprintw(w, row++, col, "Detector", "%.0lf%%ile",chan->spectrum.percentile);
+      break;
+    case DETECT_MAX_AVERAGE:
+      pprintw(w, row++, col, "Detector", "max avg");
+      break;
+    }
 
     if(chan->spectrum.bin_data != NULL)
       pprintw(w,row++,col,"Bin 0","%.1lf   ",chan->spectrum.bin_data[0]);
@@ -1798,6 +1825,12 @@ static void display_input(WINDOW *w,chan_t const *chan){
     pprintw(w,row++,col,"Overranges","%'llu",Frontend.overranges);
     if(Frontend.overranges != 0)
       pprintw(w,row++,col,"Last overrange","%s",ftime(tmp,sizeof(tmp),(int64_t)(Frontend.samp_since_over/Frontend.samprate)));
+    if(Frontend.xfer_queue != 0){
+      pprintw(w,row++,col,"Xfer queue","%d x %'d",Frontend.xfer_queue,Frontend.xfer_size);
+      pprintw(w,row++,col,"Xfer failures","%'llu",(unsigned long long)Frontend.xfer_failures);
+      pprintw(w,row++,col,"Xfer gap p50/p99/max","%.1f/%.1f/%.1f ms",
+	      1000*Frontend.xfer_latency[0],1000*Frontend.xfer_latency[1],1000*Frontend.xfer_latency[2]);
+    }
   }
   mvwhline(w,row,0,0,1000);
   mvwaddstr(w,row++,1,"Status");
@@ -1805,9 +1838,17 @@ static void display_input(WINDOW *w,chan_t const *chan){
   pprintw(w,row++,col,"Dest","%s",formatsock(&Frontend.metadata_dest_socket,true));
   pprintw(w,row++,col,"Update interval","%'.2f sec",Refresh_rate);
   pprintw(w,row++,col,"Output status interval","%u",chan->status.output_interval);
+  if(chan->status.refresh != 0)
+    pprintw(w,row++,col,"Status refresh","%d",chan->status.refresh);
   pprintw(w,row++,col,"Status pkts","%'llu",chan->status.packets_out);
   pprintw(w,row++,col,"Control pkts","%'llu",chan->status.packets_in);
+  if(chan->status.cmd_coalesced != 0)
+    pprintw(w,row++,col,"Cmds coalesced","%'llu",(unsigned long long)chan->status.cmd_coalesced);
+  if(chan->status.cmd_drops != 0)
+    pprintw(w,row++,col,"Cmd drops","%'llu",(unsigned long long)chan->status.cmd_drops);
   pprintw(w,row++,col,"Send errors","%'llu",chan->output.errors);
+  if(chan->output.drops != 0)
+    pprintw(w,row++,col,"Send drops","%'llu",(unsigned long long)chan->output.drops);
   pprintw(w,row++,col,"Lifetime","%'u",chan->lifetime);
   if(chan->options != 0)
     pprintw(w,row++,col,"Options","0x%llx",(long long)chan->options);
@@ -1848,6 +1889,10 @@ static void display_output(WINDOW *w,chan_t const *chan){
       pprintw(w,row++,col,"Opus fec","%u%%",chan->opus.fec);
       int bw = opus_bandwidth(NULL,chan->opus.bandwidth);
       pprintw(w,row++,col,"Opus bw","%u kHz",bw/1000);
+      if(chan->opus.latency > 0){
+	pprintw(w,row++,col,"Opus latency","%.1f ms",1000*chan->opus.latency);
+	pprintw(w,row++,col,"Opus backlog","%d",chan->opus.backlog);
+      }
     }
   }
   box(w,0,0);
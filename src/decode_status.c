@@ -4,16 +4,23 @@
 // Copyright 2026 Phil Karn, KA9Q
 
 #include <string.h>
+#include <stdlib.h>
+#include "misc.h"
 #include "radio.h"
 
+static void decode_bins(chan_t *channel,enum status_type type,uint8_t const *cp,int optlen,int offset);
+
 // Decode incoming status message from the radio program, convert and fill in fields in local channel structure
 // Leave all other fields unchanged, as they may have local uses (e.g., file descriptors)
+// This also merges a STATUS_DELTA into a channel built up from earlier packets, since a delta is just
+// a status message with the unchanged entries left out
 // Note that we use some fields in channel differently than in radiod (e.g., dB vs ratios)
 int decode_radio_status(struct frontend *frontend,chan_t *channel,uint8_t const *buffer,int length){
   if(frontend == NULL || channel == NULL || buffer == NULL)
     return -1;
   if(length <= 0)
     return 0;
+  int bin_offset = -1; // Not a fragment unless BIN_OFFSET says so
   uint8_t const *cp = buffer;
   while(cp  < &buffer[length-1]){ // ensure at least 2 bytes for type & length
     enum status_type type = *cp++; // increment to length field
@@ -72,6 +79,22 @@ int decode_radio_status(struct frontend *frontend,chan_t *channel,uint8_t const
     case SAMPLES_SINCE_OVER:
       frontend->samp_since_over = decode_int64(cp,optlen);
       break;
+    case FE_XFER_QUEUE:
+      frontend->xfer_queue = decode_int(cp,optlen);
+      break;
+    case FE_XFER_SIZE:
+      frontend->xfer_size = decode_int(cp,optlen);
+      break;
+    case FE_XFER_FAILURES:
+      frontend->xfer_failures = decode_int64(cp,optlen);
+      break;
+    case FE_XFER_LATENCY:
+      {
+	int const count = optlen / sizeof(float);
+	for(int i=0; i < count && i < (int)(sizeof frontend->xfer_latency / sizeof frontend->xfer_latency[0]); i++)
+	  frontend->xfer_latency[i] = decode_float(cp + i * sizeof(float),sizeof(float));
+      }
+      break;
     case OUTPUT_DATA_SOURCE_SOCKET:
       decode_socket(&channel->output.source_socket,cp,optlen);
       break;
@@ -289,8 +312,48 @@ int decode_radio_status(struct frontend *frontend,chan_t *channel,uint8_t const
       channel->spectrum.step = decode_float(cp,optlen);
       break;
     case BIN_DATA:
-      break;
     case BIN_BYTE_DATA:
+    case BIN_RICE_DATA:
+      decode_bins(channel,type,cp,optlen,bin_offset);
+      break;
+    case BIN_SEQUENCE:
+      {
+	uint32_t const seq = decode_int32(cp,optlen);
+	if(seq != channel->spectrum.sequence){
+	  channel->spectrum.sequence = seq; // New response
+	  channel->spectrum.bins_received = 0;
+	}
+      }
+      break;
+    case BIN_OFFSET:
+      bin_offset = decode_int(cp,optlen);
+      break;
+    case BIN_COMPRESSION:
+      channel->spectrum.compression = decode_int(cp,optlen);
+      break;
+    case SPECTRUM_LATENCY:
+      channel->spectrum.latency = decode_float(cp,optlen);
+      break;
+    case SPECTRUM_TAP:
+      channel->spectrum.tap = decode_bool(cp,optlen);
+      break;
+    case SPECTRUM_DIRECT:
+      channel->spectrum.direct = decode_bool(cp,optlen);
+      break;
+    case OCCUPANCY_THRESHOLD:
+      channel->spectrum.occupancy_threshold = decode_float(cp,optlen);
+      break;
+    case OCCUPANCY_INTERVAL:
+      channel->spectrum.occupancy_interval = decode_float(cp,optlen);
+      break;
+    case SPECTRUM_HISTORY:
+      channel->spectrum.history_rows = decode_int(cp,optlen);
+      break;
+    case SPECTRUM_DETECTOR:
+      channel->spectrum.detector = decode_int(cp,optlen);
+      break;
+    case SPECTRUM_PERCENTILE:
+      channel->spectrum.percentile = decode_float(cp,optlen);
       break;
     case RF_AGC:
       frontend->rf_agc = decode_int(cp,optlen);
@@ -321,6 +384,15 @@ int decode_radio_status(struct frontend *frontend,chan_t *channel,uint8_t const
     case STATUS_INTERVAL:
       channel->status.output_interval = decode_int(cp,optlen);
       break;
+    case STATUS_REFRESH:
+      channel->status.refresh = decode_int(cp,optlen);
+      break;
+    case COMMAND_DROPS:
+      channel->status.cmd_drops = decode_int64(cp,optlen);
+      break;
+    case COMMANDS_COALESCED:
+      channel->status.cmd_coalesced = decode_int64(cp,optlen);
+      break;
     case SETOPTS:
       channel->options = decode_int64(cp,optlen);
       break;
@@ -348,6 +420,15 @@ int decode_radio_status(struct frontend *frontend,chan_t *channel,uint8_t const
     case OUTPUT_ERRORS:
       channel->output.errors = decode_int64(cp,optlen);
       break;
+    case OUTPUT_DROPS:
+      channel->output.drops = decode_int64(cp,optlen);
+      break;
+    case OPUS_LATENCY:
+      channel->opus.latency = decode_float(cp,optlen);
+      break;
+    case OPUS_BACKLOG:
+      channel->opus.backlog = decode_int(cp,optlen);
+      break;
     case FILTER2_BLOCKSIZE:
       channel->filter2.in.ilen = decode_int(cp,optlen);
       break;
@@ -449,3 +530,64 @@ uint32_t get_tag(uint8_t const *buffer,int length){
  done:;
   return 0; // broadcast
 }
+
+// Spectrum data is stored only if the caller has allocated channel->spectrum.bin_data, which is resized to fit
+// Whatever the format, it ends up as bin energies in FFT order (DC first), as in radiod
+/* Store spectrum bins, as power in FFT order
+   offset >= 0 means they're a fragment of a response too big for one packet (see radio_status.c), starting at
+   that index of the complete response; BIN_COUNT gives its size. Otherwise they're the whole response
+*/
+static void decode_bins(chan_t *channel,enum status_type type,uint8_t const *cp,int optlen,int offset){
+  if(channel->spectrum.bin_data == NULL)
+    return;
+
+  int count;
+  uint8_t *levels = NULL;
+  switch(type){
+  case BIN_DATA:
+    count = optlen / sizeof(float);
+    break;
+  case BIN_BYTE_DATA:
+    count = optlen;
+    break;
+  case BIN_RICE_DATA:
+    count = decode_rice_bins(cp,optlen,NULL,0);
+    if(count <= 0 || (levels = malloc(count)) == NULL)
+      return;
+    if(decode_rice_bins(cp,optlen,levels,count) != count){
+      free(levels);
+      return;
+    }
+    break;
+  default:
+    return;
+  }
+  int const total = offset >= 0 ? channel->spectrum.bin_count : count;
+  if(offset < 0)
+    offset = 0;
+  if(count <= 0 || offset + count > total){
+    free(levels);
+    return;
+  }
+  float * const bins = realloc(channel->spectrum.bin_data,total * sizeof *bins);
+  if(bins == NULL){
+    free(levels);
+    return;
+  }
+  channel->spectrum.bin_data = bins;
+  channel->spectrum.bins_received = offset == 0 && count == total ? total : channel->spectrum.bins_received + count;
+  if(type == BIN_DATA){
+    for(int i=0; i < count; i++)
+      bins[offset + i] = decode_float(cp + i * sizeof(float),sizeof(float));
+    return;
+  }
+  // Levels are in frequency order, lowest (most negative) first
+  uint8_t const *lp = levels != NULL ? levels : cp;
+  int wbin = (offset + total/2) % total;
+  for(int i=0; i < count; i++){
+    bins[wbin++] = dB2power(channel->spectrum.base + lp[i] * channel->spectrum.step);
+    if(wbin == total)
+      wbin = 0;
+  }
+  free(levels);
+}
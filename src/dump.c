@@ -108,6 +108,23 @@ void dump_metadata(FILE *fp,uint8_t const * const buffer,size_t length,bool newl
     case SAMPLES_SINCE_OVER:
       fprintf(fp,"Samples since A/D overrange: %'llu",(long long unsigned int)decode_int64(cp,optlen));
       break;
+    case FE_XFER_QUEUE:
+      fprintf(fp,"fe xfer queue %d",decode_int(cp,optlen));
+      break;
+    case FE_XFER_SIZE:
+      fprintf(fp,"fe xfer size %'d",decode_int(cp,optlen));
+      break;
+    case FE_XFER_FAILURES:
+      fprintf(fp,"fe xfer failures %'llu",(long long unsigned int)decode_int64(cp,optlen));
+      break;
+    case FE_XFER_LATENCY:
+      {
+	fprintf(fp,"fe xfer latency ms:");
+	int const count = optlen/sizeof(float);
+	for(int i=0; i < count; i++)
+	  fprintf(fp," %.2lf",1000 * decode_float(cp + i * sizeof(float),sizeof(float)));
+      }
+      break;
     case CALIBRATE:
       fprintf(fp,"calibration %'lg",decode_double(cp,optlen));
       break;
@@ -403,6 +420,90 @@ void dump_metadata(FILE *fp,uint8_t const * const buffer,size_t length,bool newl
     case STATUS_INTERVAL:
       fprintf(fp,"status interval %u",decode_int(cp,optlen));
       break;
+    case STATUS_REFRESH:
+      fprintf(fp,"status refresh %d",decode_int(cp,optlen));
+      break;
+    case COMMAND_DROPS:
+      fprintf(fp,"command drops %'llu",(unsigned long long)decode_int64(cp,optlen));
+      break;
+    case COMMANDS_COALESCED:
+      fprintf(fp,"commands coalesced %'llu",(unsigned long long)decode_int64(cp,optlen));
+      break;
+    case BIN_COMPRESSION:
+      fprintf(fp,"bin compression %d",decode_int(cp,optlen));
+      break;
+    case SPECTRUM_LATENCY:
+      fprintf(fp,"spectrum latency %.3f ms",1000 * decode_float(cp,optlen));
+      break;
+    case SPECTRUM_TAP:
+      fprintf(fp,"spectrum tap %s",decode_bool(cp,optlen) ? "on" : "off");
+      break;
+    case SPECTRUM_DIRECT:
+      fprintf(fp,"spectrum direct %s",decode_bool(cp,optlen) ? "on" : "off");
+      break;
+    case OCCUPANCY_THRESHOLD:
+      fprintf(fp,"occupancy threshold %.1f dB",decode_float(cp,optlen));
+      break;
+    case OCCUPANCY_INTERVAL:
+      fprintf(fp,"occupancy interval %.3f s",decode_float(cp,optlen));
+      break;
+    case SIGNAL_COUNT:
+      fprintf(fp,"signal count %d",decode_int(cp,optlen));
+      break;
+    case SIGNAL_FREQUENCY:
+      fprintf(fp,"signal freq %'.3lf Hz",decode_double(cp,optlen));
+      break;
+    case SIGNAL_BANDWIDTH:
+      fprintf(fp,"signal bw %.1f Hz",decode_float(cp,optlen));
+      break;
+    case SIGNAL_SNR:
+      fprintf(fp,"signal snr %.1f dB",decode_float(cp,optlen));
+      break;
+    case SIGNAL_FIRST:
+      {
+	char tbuf[100];
+	fprintf(fp,"signal first %s",format_gpstime(tbuf,sizeof(tbuf),(int64_t)decode_int64(cp,optlen)));
+      }
+      break;
+    case SIGNAL_LAST:
+      {
+	char tbuf[100];
+	fprintf(fp,"signal last %s",format_gpstime(tbuf,sizeof(tbuf),(int64_t)decode_int64(cp,optlen)));
+      }
+      break;
+    case SPECTRUM_HISTORY:
+      fprintf(fp,"spectrum history %d rows",decode_int(cp,optlen));
+      break;
+    case HISTORY_START:
+      {
+	char tbuf[100];
+	fprintf(fp,"history start %s",format_gpstime(tbuf,sizeof(tbuf),(int64_t)decode_int64(cp,optlen)));
+      }
+      break;
+    case HISTORY_END:
+      {
+	char tbuf[100];
+	fprintf(fp,"history end %s",format_gpstime(tbuf,sizeof(tbuf),(int64_t)decode_int64(cp,optlen)));
+      }
+      break;
+    case HISTORY_REMAINING:
+      fprintf(fp,"history remaining %d",decode_int(cp,optlen));
+      break;
+    case SPECTRUM_DETECTOR:
+      fprintf(fp,"spectrum detector %d",decode_int(cp,optlen));
+      break;
+    case SPECTRUM_PERCENTILE:
+      fprintf(fp,"spectrum percentile %.1f",decode_float(cp,optlen));
+      break;
+    case BIN_SEQUENCE:
+      fprintf(fp,"bin sequence %u",decode_int32(cp,optlen));
+      break;
+    case BIN_OFFSET:
+      fprintf(fp,"bin offset %d",decode_int(cp,optlen));
+      break;
+    case BIN_RICE_DATA:
+      fprintf(fp,"rice bin data %d bins, %u bytes",decode_rice_bins(cp,optlen,NULL,0),optlen);
+      break;
     case OUTPUT_ENCODING:
       {
 	enum encoding e = (enum encoding)decode_int(cp,optlen);
@@ -472,6 +573,15 @@ void dump_metadata(FILE *fp,uint8_t const * const buffer,size_t length,bool newl
     case OUTPUT_ERRORS:
       fprintf(fp,"output errors %'llu",(unsigned long long)decode_int64(cp,optlen));
       break;
+    case OUTPUT_DROPS:
+      fprintf(fp,"output drops %'llu",(unsigned long long)decode_int64(cp,optlen));
+      break;
+    case OPUS_LATENCY:
+      fprintf(fp,"opus latency %.1f ms",1000*decode_float(cp,optlen));
+      break;
+    case OPUS_BACKLOG:
+      fprintf(fp,"opus backlog %d",decode_int(cp,optlen));
+      break;
     case NOISE_BW:
       fprintf(fp,"bin noise bw %.1lf Hz",decode_float(cp,optlen));
       break;
@@ -0,0 +1,244 @@
+// Vectorized PCM exporters for RTP payloads, with C fallbacks
+// Everything radiod sends passes through one of these, so they're worth some effort
+// x86-64 gets AVX2 (and F16C for 16-bit float) versions chosen at run time;
+// elsewhere the scalar versions in import.h are used, which the compiler can often vectorize itself
+// The vector versions produce exactly the same bytes as the scalar ones
+//
+// Build with -DEXPORT_BENCH for a standalone checker and micro-benchmark ('make export-bench')
+// Copyright 2026, Phil Karn, KA9Q
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "misc.h"
+#include "import.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+
+// Scale, clip to +/-32767 and round 16 samples at a time, exactly as export_s16_noswap()
+__attribute__((target("avx2")))
+static uint8_t *export_s16_avx2(uint8_t *out,float const *in,size_t count,bool swap){
+  __m256 const scale = _mm256_set1_ps(32768.0f);
+  __m256 const upper = _mm256_set1_ps(32767.0f);
+  __m256 const lower = _mm256_set1_ps(-32767.0f);
+  __m256i const bswap16 = _mm256_setr_epi8(1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14,
+					   1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14);
+  size_t i = 0;
+  for(; i + 16 <= count; i += 16){
+    __m256 a = _mm256_mul_ps(_mm256_loadu_ps(in + i),scale);
+    __m256 b = _mm256_mul_ps(_mm256_loadu_ps(in + i + 8),scale);
+    a = _mm256_max_ps(_mm256_min_ps(a,upper),lower);
+    b = _mm256_max_ps(_mm256_min_ps(b,upper),lower);
+    // cvtps rounds to nearest even, like lrintf()
+    __m256i p = _mm256_packs_epi32(_mm256_cvtps_epi32(a),_mm256_cvtps_epi32(b));
+    p = _mm256_permute4x64_epi64(p,_MM_SHUFFLE(3,1,2,0)); // packs works within 128-bit lanes
+    if(swap)
+      p = _mm256_shuffle_epi8(p,bswap16);
+    _mm256_storeu_si256((__m256i *)(out + i * sizeof(int16_t)),p);
+  }
+  out += i * sizeof(int16_t);
+  return swap ? export_s16_swap(out,in + i,count - i) : export_s16_noswap(out,in + i,count - i);
+}
+
+__attribute__((target("avx2")))
+static uint8_t *export_f32_swap_avx2(uint8_t *out,float const *in,size_t count){
+  __m256i const bswap32 = _mm256_setr_epi8(3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12,
+					   3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12);
+  size_t i = 0;
+  for(; i + 8 <= count; i += 8){
+    __m256i x = _mm256_loadu_si256((__m256i const *)(in + i));
+    _mm256_storeu_si256((__m256i *)(out + i * sizeof(float)),_mm256_shuffle_epi8(x,bswap32));
+  }
+  return export_f32_swap(out + i * sizeof(float),in + i,count - i);
+}
+
+#ifdef HAS_FLOAT16
+__attribute__((target("avx2,f16c")))
+static uint8_t *export_f16_avx2(uint8_t *out,float const *in,size_t count,bool swap){
+  __m128i const bswap16 = _mm_setr_epi8(1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14);
+  size_t i = 0;
+  for(; i + 8 <= count; i += 8){
+    __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(in + i),_MM_FROUND_TO_NEAREST_INT);
+    if(swap)
+      h = _mm_shuffle_epi8(h,bswap16);
+    _mm_storeu_si128((__m128i *)(out + i * sizeof(float16_t)),h);
+  }
+  out += i * sizeof(float16_t);
+  return swap ? export_f16_swap(out,in + i,count - i) : export_f16_noswap(out,in + i,count - i);
+}
+#endif
+
+/* G.711 on 8 samples, same arithmetic as float_to_mulaw() and float_to_alaw() in rtp.c
+   floor(log2(pcm)) comes from the exponent field of pcm converted to float, which is exact below 2^24
+   Returns one code per 32-bit lane */
+__attribute__((target("avx2")))
+static inline __m256i g711_avx2(float const *in,bool alaw){
+  __m256 x = _mm256_loadu_ps(in);
+  x = _mm256_max_ps(_mm256_min_ps(x,_mm256_set1_ps(1.0f)),_mm256_set1_ps(-1.0f));
+  __m256i const sample = _mm256_cvtps_epi32(_mm256_mul_ps(x,_mm256_set1_ps(32768.0f)));
+  __m256i const sign = _mm256_and_si256(_mm256_srai_epi32(sample,31),_mm256_set1_epi32(0x80));
+  __m256i pcm = _mm256_min_epi32(_mm256_abs_epi32(sample),_mm256_set1_epi32(32635));
+  if(!alaw)
+    pcm = _mm256_add_epi32(pcm,_mm256_set1_epi32(0x84)); // mu-law bias
+
+  __m256i exponent = _mm256_srli_epi32(_mm256_castps_si256(_mm256_cvtepi32_ps(pcm)),23);
+  exponent = _mm256_sub_epi32(exponent,_mm256_set1_epi32(127 + 7));
+  exponent = _mm256_min_epi32(_mm256_max_epi32(exponent,_mm256_setzero_si256()),_mm256_set1_epi32(7));
+  __m256i shift = _mm256_add_epi32(exponent,_mm256_set1_epi32(3));
+  if(alaw)
+    shift = _mm256_max_epi32(shift,_mm256_set1_epi32(4)); // segment 0 is linear
+  __m256i const mantissa = _mm256_and_si256(_mm256_srlv_epi32(pcm,shift),_mm256_set1_epi32(0x0f));
+  __m256i const code = _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(exponent,4),mantissa),sign);
+  return _mm256_xor_si256(code,_mm256_set1_epi32(alaw ? 0x55 : 0xff));
+}
+
+__attribute__((target("avx2")))
+static uint8_t *export_g711_avx2(uint8_t *out,float const *in,size_t count,bool alaw){
+  __m256i const order = _mm256_setr_epi32(0,4,1,5,2,6,3,7);
+  size_t i = 0;
+  for(; i + 32 <= count; i += 32){
+    __m256i const lo = _mm256_packs_epi32(g711_avx2(in + i,alaw),g711_avx2(in + i + 8,alaw));
+    __m256i const hi = _mm256_packs_epi32(g711_avx2(in + i + 16,alaw),g711_avx2(in + i + 24,alaw));
+    __m256i const bytes = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(lo,hi),order);
+    _mm256_storeu_si256((__m256i *)(out + i),bytes);
+  }
+  return alaw ? export_alaw(out + i,in + i,count - i) : export_mulaw(out + i,in + i,count - i);
+}
+#endif // __x86_64__
+
+// Dispatchers, drop-in replacements for the export_* functions in import.h
+uint8_t *export_s16_be_vec(uint8_t *out,float const *in,size_t count){
+#if defined(__x86_64__)
+  if(__builtin_cpu_supports("avx2"))
+    return export_s16_avx2(out,in,count,true);
+#endif
+  return export_s16_be(out,in,count);
+}
+uint8_t *export_s16_le_vec(uint8_t *out,float const *in,size_t count){
+#if defined(__x86_64__)
+  if(__builtin_cpu_supports("avx2"))
+    return export_s16_avx2(out,in,count,false);
+#endif
+  return export_s16_le(out,in,count);
+}
+uint8_t *export_f32_be_vec(uint8_t *out,float const *in,size_t count){
+#if defined(__x86_64__)
+  if(__builtin_cpu_supports("avx2"))
+    return export_f32_swap_avx2(out,in,count);
+#endif
+  return export_f32_be(out,in,count);
+}
+uint8_t *export_f32_le_vec(uint8_t *out,float const *in,size_t count){
+  return export_f32_le(out,in,count); // memcpy on little-endian machines
+}
+#ifdef HAS_FLOAT16
+uint8_t *export_f16_be_vec(uint8_t *out,float const *in,size_t count){
+#if defined(__x86_64__)
+  if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c"))
+    return export_f16_avx2(out,in,count,true);
+#endif
+  return export_f16_be(out,in,count);
+}
+uint8_t *export_f16_le_vec(uint8_t *out,float const *in,size_t count){
+#if defined(__x86_64__)
+  if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c"))
+    return export_f16_avx2(out,in,count,false);
+#endif
+  return export_f16_le(out,in,count);
+}
+#endif
+uint8_t *export_mulaw_vec(uint8_t *out,float const *in,size_t count){
+#if defined(__x86_64__)
+  if(__builtin_cpu_supports("avx2"))
+    return export_g711_avx2(out,in,count,false);
+#endif
+  return export_mulaw(out,in,count);
+}
+uint8_t *export_alaw_vec(uint8_t *out,float const *in,size_t count){
+#if defined(__x86_64__)
+  if(__builtin_cpu_supports("avx2"))
+    return export_g711_avx2(out,in,count,true);
+#endif
+  return export_alaw(out,in,count);
+}
+
+#ifdef EXPORT_BENCH
+// Check each vector exporter against its scalar original over random, out of range and
+// special values, then time both at a typical packet size
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sysexits.h>
+
+static double now(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+typedef uint8_t *(*exporter)(uint8_t *,float const *,size_t);
+static struct {
+  char const *name;
+  exporter scalar;
+  exporter vector;
+} const Tests[] = {
+  {"s16be", export_s16_be, export_s16_be_vec},
+  {"s16le", export_s16_le, export_s16_le_vec},
+  {"f32be", export_f32_be, export_f32_be_vec},
+  {"f32le", export_f32_le, export_f32_le_vec},
+#ifdef HAS_FLOAT16
+  {"f16be", export_f16_be, export_f16_be_vec},
+  {"f16le", export_f16_le, export_f16_le_vec},
+#endif
+  {"mulaw", export_mulaw, export_mulaw_vec},
+  {"alaw", export_alaw, export_alaw_vec},
+};
+
+int main(int argc,char *argv[]){
+  size_t const count = argc > 1 ? strtol(argv[1],NULL,0) : 720; // one 1440-byte s16 packet
+  int const reps = argc > 2 ? strtol(argv[2],NULL,0) : 100000;
+  size_t const checklen = 1 << 20;
+  float *in = malloc(checklen * sizeof *in);
+  uint8_t *out1 = malloc(checklen * sizeof(float) + 64);
+  uint8_t *out2 = malloc(checklen * sizeof(float) + 64);
+  srandom(1);
+  for(size_t i = 0; i < checklen; i++)
+    in[i] = 2.4f * ((float)random() / RAND_MAX - 0.5f); // includes values beyond full scale
+  // Edges: exact full scale, rounding ties, segment boundaries, tiny values, odd length tails
+  float const specials[] = {0, -0.0f, 1, -1, 32767.5f/32768, -32767.5f/32768, 0.5f/32768, 1.5f/32768, -0.5f/32768,
+			    256.0f/32768, 255.5f/32768, 127.5f/32768, 1e-30f, -1e-30f, 65504.0f/32768};
+  memcpy(in,specials,sizeof specials);
+  for(int k = 0; k < 32768 && k + 100 < (int)checklen; k++)
+    in[100 + k] = (float)(k - 16384) / 16384; // every level near the G.711 segment edges
+
+  bool failed = false;
+  printf("%-6s %10s %10s %8s\n","format","scalar ns","vector ns","speedup");
+  for(size_t t = 0; t < sizeof Tests / sizeof Tests[0]; t++){
+    for(size_t len = checklen - 37; len <= checklen; len += 37){ // odd lengths exercise the scalar tails
+      size_t const n1 = Tests[t].scalar(out1,in,len) - out1;
+      size_t const n2 = Tests[t].vector(out2,in,len) - out2;
+      if(n1 != n2 || memcmp(out1,out2,n1) != 0){
+	size_t i = 0;
+	while(i < n1 && out1[i] == out2[i])
+	  i++;
+	printf("%s: MISMATCH at byte %zu (length %zu)\n",Tests[t].name,i,len);
+	failed = true;
+	break;
+      }
+    }
+    double start = now();
+    for(int r = 0; r < reps; r++)
+      Tests[t].scalar(out1,in + (r & 255),count);
+    double const scalar = (now() - start) / reps;
+    start = now();
+    for(int r = 0; r < reps; r++)
+      Tests[t].vector(out2,in + (r & 255),count);
+    double const vector = (now() - start) / reps;
+    printf("%-6s %10.1f %10.1f %7.1fx\n",Tests[t].name,1e9*scalar,1e9*vector,scalar/vector);
+  }
+  printf("%zu samples per call, %d calls\n",count,reps);
+  exit(failed ? EX_SOFTWARE : EX_OK);
+}
+#endif
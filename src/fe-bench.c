@@ -0,0 +1,552 @@
+// Front end driver conformance check and throughput benchmark
+// Loads a radiod front end driver (.so) and runs it against a stand-in for the input half of the
+// fast convolver. Nothing is transformed or demodulated, so the CPU time measured is the driver's own:
+// its transport handling and sample conversion. Also checks the accounting every driver must get right
+// (write pointer, sample count, energy, overranges)
+//
+// usage: fe-bench [-v] [-m [-n count]] [-t seconds] [-b blocktime_ms] [-o overlap] config_file section
+// e.g.,  fe-bench -t 30 /etc/radio/radiod@sig_gen.conf siggen
+//
+// sig_gen and netiq need no hardware; other drivers need their device attached.
+// -m replaces the driver's transport with canned transfers of 'count' values handed straight to its callback,
+// so its conversion and accounting can be checked (and timed) with no device.
+// The rx888, airspy, hackrf, rtlsdr, sdrplay, fobos and hydrasdr drivers support it
+// Copyright 2026, Phil Karn, KA9Q
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#if defined(linux)
+#include <bsd/string.h>
+#endif
+#include <strings.h>
+#include <unistd.h>
+#include <math.h>
+#include <complex.h>
+#include <time.h>
+#include <limits.h>
+#include <locale.h>
+#include <getopt.h>
+#include <sysexits.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <iniparser/iniparser.h>
+
+#include "misc.h"
+#include "config.h"
+#include "radio.h"
+#include "config_paths.h"
+
+// Globals that radiod normally provides to its drivers
+int Verbose;
+char const *Description;
+char const *Serial;
+int USB_busnum = -1;
+int USB_devnum = -1;
+double Blocktime;
+struct frontend Frontend = {
+  .status_mutex = PTHREAD_MUTEX_INITIALIZER,
+  .status_cond = PTHREAD_COND_INITIALIZER,
+};
+
+static double Duration = 10; // seconds
+double User_blocktime = .02; // seconds
+static int Overlap = 5;
+static char const *Locale = "en_US.UTF-8";
+static bool Mock_transport;
+
+// Everything the driver wrote through write_cfilter()/write_rfilter()
+// Updated only by the driver's thread, snapshotted by main() under the lock
+static struct {
+  pthread_mutex_t lock;
+  uint64_t calls;
+  uint64_t samples;
+  uint64_t blocks;        // Complete L-sample blocks that would have gone to the FFT
+  uint64_t bad_pointer;   // Write pointer not where the previous write left it
+  uint64_t too_big;       // Single write larger than the ring buffer
+  uint64_t nonfinite;     // NaN or Inf samples
+  uint64_t near_full;     // Samples within 0.1 dB of A/D full scale
+  int max_write;          // Largest single write, samples
+  double energy;          // Sum of squared samples, scaled units
+  void *expected;         // Where the next write should start
+  float fullscale;        // Full scale amplitude, scaled units
+  pthread_t writer;
+  bool multiple_writers;
+} Stats = {
+  .lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+// Mock transport (-m): canned transfers fed to the driver's callback as fast as it takes them
+// A driver supports it by exporting <device>_mock_setup(), <device>_mock_transfer() and <device>_mock_callback()
+#define MOCK_XFERS 8        // Distinct canned buffers, cycled
+#define MOCK_FAIL_EVERY 100 // Every this many transfers, one comes back with an error
+static int Mock_count = 65536; // Values per transfer, I and Q counted separately
+static struct {
+  void *(*transfer)(struct frontend *,float const *,int); // encodes normalized samples in the device's format
+  void (*callback)(void *);
+  void *xfers[MOCK_XFERS];
+  void *failed;   // NULL if the transport never fails a transfer
+  pthread_t thread;
+  _Atomic bool stop;
+} Mock;
+
+static int load_driver(struct frontend *frontend,dictionary *dict,char const *section);
+static int mock_startup(struct frontend *frontend);
+static int mock_shutdown(struct frontend *frontend);
+static int mock_filter_input(struct filter_in *f,int L,int M,enum filtertype type);
+static double cputime(void);
+static void usage(void);
+
+static char Optstring[] = "b:hmn:o:t:v";
+static struct option Options[] = {
+  {"blocktime", required_argument, NULL, 'b'},
+  {"help", no_argument, NULL, 'h'},
+  {"mock", no_argument, NULL, 'm'},
+  {"count", required_argument, NULL, 'n'},
+  {"overlap", required_argument, NULL, 'o'},
+  {"time", required_argument, NULL, 't'},
+  {"verbose", no_argument, NULL, 'v'},
+  {NULL, 0, NULL, 0},
+};
+
+int main(int argc,char *argv[]){
+  {
+    char const * const cp = getenv("LANG");
+    if(cp != NULL)
+      Locale = cp;
+  }
+  setlocale(LC_ALL,Locale);
+  int c;
+  while((c = getopt_long(argc,argv,Optstring,Options,NULL)) != -1){
+    switch(c){
+    case 'b':
+      User_blocktime = strtod(optarg,NULL) / 1000.;
+      break;
+    case 'm':
+      Mock_transport = true;
+      break;
+    case 'n':
+      Mock_count = strtol(optarg,NULL,0);
+      break;
+    case 'o':
+      Overlap = strtol(optarg,NULL,0);
+      break;
+    case 't':
+      Duration = strtod(optarg,NULL);
+      break;
+    case 'v':
+      Verbose++;
+      break;
+    case 'h':
+    default:
+      usage();
+      exit(c == 'h' ? EX_OK : EX_USAGE);
+    }
+  }
+  // Multiple of 16 keeps the drivers' vector and 12-bit packing paths happy
+  if(argc - optind != 2 || User_blocktime <= 0 || Overlap < 2 || Duration <= 0 || Mock_count <= 0 || (Mock_count % 16) != 0){
+    usage();
+    exit(EX_USAGE);
+  }
+  char const *file = argv[optind];
+  char const *section = argv[optind+1];
+  dictionary *dict = iniparser_load(file);
+  if(dict == NULL){
+    fprintf(stderr,"can't load config file %s\n",file);
+    exit(EX_NOINPUT);
+  }
+  if(iniparser_find_entry(dict,section) == 0){
+    fprintf(stderr,"no section [%s] in %s\n",section,file);
+    exit(EX_USAGE);
+  }
+  Description = config_getstring(dict,"global","description",NULL);
+  struct frontend * const frontend = &Frontend;
+  strlcpy(frontend->name,section,sizeof frontend->name);
+  if(load_driver(frontend,dict,section) != 0)
+    exit(EX_SOFTWARE);
+
+  int r = (*frontend->setup)(frontend,dict,section);
+  if(r != 0){
+    fprintf(stderr,"[%s] setup returned %d\n",section,r);
+    exit(EX_NOINPUT);
+  }
+  // Same block geometry as radiod
+  if(frontend->samprate <= 0){
+    fprintf(stderr,"[%s] setup did not set a sample rate\n",section);
+    exit(EX_SOFTWARE);
+  }
+  frontend->L = lrint(frontend->samprate * User_blocktime);
+  frontend->M = frontend->L / (Overlap - 1) + 1;
+  Blocktime = frontend->L / frontend->samprate;
+  if(mock_filter_input(&frontend->in,frontend->L,frontend->M,frontend->isreal ? REAL : COMPLEX) != 0){
+    fprintf(stderr,"can't allocate input buffer\n");
+    exit(EX_OSERR);
+  }
+  fprintf(stderr,"[%s] %s, %'.0lf Hz %s, %d bits/sample, block L=%'d M=%'d\n",
+	  section,frontend->description,frontend->samprate,frontend->isreal ? "real" : "complex",
+	  frontend->bitspersample,frontend->L,frontend->M);
+
+  int failures = 0;
+  // Entry point smoke tests before streaming
+  if(frontend->bitspersample <= 0){
+    fprintf(stderr,"FAIL: bitspersample %d not set by setup\n",frontend->bitspersample);
+    exit(EX_SOFTWARE);
+  }
+  if(frontend->tune != NULL && !frontend->lock && frontend->frequency > 0){
+    double const f = (*frontend->tune)(frontend,frontend->frequency);
+    if(isnan(f) || !isfinite(f)){
+      fprintf(stderr,"FAIL: tune(%'.0lf Hz) returned %lf\n",frontend->frequency,f);
+      failures++;
+    }
+  }
+  if(frontend->min_IF >= frontend->max_IF){
+    fprintf(stderr,"FAIL: IF range %'.0lf to %'.0lf Hz is empty\n",frontend->min_IF,frontend->max_IF);
+    failures++;
+  }
+  // The driver's scale factor, as it will compute it in its startup routine
+  double const scale = scale_AD(frontend);
+  Stats.fullscale = scale * (1 << (frontend->bitspersample - 1));
+  uint64_t const start_samples = frontend->samples;
+  uint64_t const start_overranges = frontend->overranges;
+  double const start_cpu = cputime();
+  int64_t const start_time = gps_time_ns();
+
+  r = (*frontend->start)(frontend);
+  if(r != 0){
+    fprintf(stderr,"FAIL: [%s] start returned %d\n",section,r);
+    exit(EX_SOFTWARE);
+  }
+  // Run, reporting once a second
+  uint64_t last_samples = 0;
+  double last_cpu = start_cpu;
+  int idle = 0;
+  for(int t = 1; t <= Duration; t++){
+    sleep(1);
+    pthread_mutex_lock(&Stats.lock);
+    uint64_t const samples = Stats.samples;
+    pthread_mutex_unlock(&Stats.lock);
+    double const cpu = cputime();
+    if(samples == last_samples){
+      if(++idle >= 5){
+	fprintf(stderr,"FAIL: no samples for %d seconds\n",idle);
+	failures++;
+	break;
+      }
+    } else
+      idle = 0;
+    if(Verbose)
+      fprintf(stderr,"%3d s: %'.3lf MS/s, %'.1lf MS/s per core, if power %.1f dBFS\n",
+	      t,(samples - last_samples) * 1e-6, cpu > last_cpu ? (samples - last_samples) * 1e-6 / (cpu - last_cpu) : 0,
+	      power2dB(frontend->if_power * scale_ADpower2FS(frontend)));
+    last_samples = samples;
+    last_cpu = cpu;
+  }
+  if(frontend->shutdown != NULL){
+    r = (*frontend->shutdown)(frontend);
+    if(r != 0){
+      fprintf(stderr,"FAIL: [%s] shutdown returned %d\n",section,r);
+      failures++;
+    }
+  }
+  double const elapsed = (gps_time_ns() - start_time) * 1e-9;
+  double const cpu = cputime() - start_cpu;
+
+  pthread_mutex_lock(&Stats.lock);
+  // Report
+  printf("driver [%s] %s\n",section,frontend->description);
+  printf("write calls %'llu, samples %'llu, blocks %'llu, largest write %'d samples\n",
+	 (unsigned long long)Stats.calls,(unsigned long long)Stats.samples,(unsigned long long)Stats.blocks,Stats.max_write);
+  printf("rate %'.3lf MS/s (nominal %'.3lf), CPU %.2lf s in %.2lf s, %'.1lf MS/s per core\n",
+	 Stats.samples * 1e-6 / elapsed,frontend->samprate * 1e-6,cpu,elapsed,cpu > 0 ? Stats.samples * 1e-6 / cpu : 0);
+
+  // Checks
+  if(Stats.bad_pointer != 0){
+    printf("FAIL: %'llu writes did not start at the input write pointer\n",(unsigned long long)Stats.bad_pointer);
+    failures++;
+  }
+  if(Stats.too_big != 0){
+    printf("FAIL: %'llu writes larger than the input ring buffer\n",(unsigned long long)Stats.too_big);
+    failures++;
+  }
+  if(Stats.multiple_writers){
+    printf("FAIL: write_*filter called from more than one thread\n");
+    failures++;
+  }
+  if(Stats.nonfinite != 0){
+    printf("FAIL: %'llu NaN or infinite samples\n",(unsigned long long)Stats.nonfinite);
+    failures++;
+  }
+  {
+    // Driver's sample count may lead or lag ours by one write, depending on where it updates
+    int64_t const diff = (int64_t)(frontend->samples - start_samples) - (int64_t)Stats.samples;
+    printf("sample count: driver %'llu, written %'llu\n",
+	   (unsigned long long)(frontend->samples - start_samples),(unsigned long long)Stats.samples);
+    if(llabs(diff) > Stats.max_write){
+      printf("FAIL: sample counts differ by %'lld\n",(long long)diff);
+      failures++;
+    }
+    if(frontend->overranges != 0 && frontend->samp_since_over > frontend->samples){
+      printf("FAIL: samples since overrange %'llu exceeds total %'llu\n",
+	     (unsigned long long)frontend->samp_since_over,(unsigned long long)frontend->samples);
+      failures++;
+    }
+  }
+  if(Stats.samples != 0){
+    // Driver's smoothed power is in raw A/D units; ours is from the scaled samples it wrote
+    double const measured = Stats.energy / Stats.samples / (scale * scale);
+    double const reported = frontend->if_power;
+    double const fs = scale_ADpower2FS(frontend);
+    printf("power: driver %.1f dBFS, written %.1f dBFS\n",power2dB(reported * fs),power2dB(measured * fs));
+    if(isnan(reported) || !isfinite(reported)){
+      printf("FAIL: driver power %lf\n",reported);
+      failures++;
+    } else if(measured * fs > 1e-12 && fabs(power2dB(reported / measured)) > 3){
+      // Generous: the driver's figure is exponentially smoothed, ours is a plain average
+      printf("FAIL: driver and written power differ by %.1f dB; check scale_AD() and bitspersample\n",power2dB(reported / measured));
+      failures++;
+    }
+  }
+  printf("overranges: driver %'llu, written samples near full scale %'llu\n",
+	 (unsigned long long)(frontend->overranges - start_overranges),(unsigned long long)Stats.near_full);
+  // Only integer A/D samples really clip; floating point sources (bitspersample == 1) may exceed nominal full scale
+  if(frontend->bitspersample > 1 && Stats.near_full > Stats.samples / 1000 && frontend->overranges == start_overranges){
+    printf("FAIL: samples reach full scale but driver counts no overranges\n");
+    failures++;
+  }
+  pthread_mutex_unlock(&Stats.lock);
+  printf("%s\n",failures == 0 ? "PASS" : "FAIL");
+  exit(failures == 0 ? EX_OK : EX_SOFTWARE);
+}
+
+// Load driver the same way radiod's setup_hardware() does
+static int load_driver(struct frontend *frontend,dictionary *dict,char const *section){
+  char const *device = config_getstring(dict,section,"device",section);
+  char defname[PATH_MAX];
+  snprintf(defname,sizeof(defname),"%s/%s.so",PKGLIBDIR,device);
+  char const *dlname = config_getstring(dict,device,"library",defname); // radiod looks in the [device] section
+  void *handle = dlopen(dlname,RTLD_GLOBAL|RTLD_NOW);
+  if(handle == NULL){
+    fprintf(stderr,"Error loading %s to handle device %s: %s\n",dlname,device,dlerror());
+    return -1;
+  }
+  char symname[128];
+  if(Mock_transport){
+    // The driver's own setup would go looking for its device; it supplies a mock one that doesn't
+    snprintf(symname,sizeof(symname),"%s_mock_setup",device);
+    frontend->setup = dlsym(handle,symname);
+    snprintf(symname,sizeof(symname),"%s_mock_transfer",device);
+    Mock.transfer = dlsym(handle,symname);
+    snprintf(symname,sizeof(symname),"%s_mock_callback",device);
+    Mock.callback = dlsym(handle,symname);
+    if(frontend->setup == NULL || Mock.transfer == NULL || Mock.callback == NULL){
+      fprintf(stderr,"FAIL: %s has no mock transport (%s_mock_setup, _mock_transfer, _mock_callback)\n",dlname,device);
+      return -1;
+    }
+    frontend->start = mock_startup;
+    frontend->shutdown = mock_shutdown;
+    fprintf(stderr,"Loaded %s from %s with mock transport\n",device,dlname);
+    return 0;
+  }
+  snprintf(symname,sizeof(symname),"%s_setup",device);
+  frontend->setup = dlsym(handle,symname);
+  snprintf(symname,sizeof(symname),"%s_startup",device);
+  frontend->start = dlsym(handle,symname);
+  if(frontend->setup == NULL || frontend->start == NULL){
+    fprintf(stderr,"FAIL: %s lacks %s_setup or %s_startup\n",dlname,device,device);
+    return -1;
+  }
+  snprintf(symname,sizeof(symname),"%s_shutdown",device);
+  frontend->shutdown = dlsym(handle,symname);
+  snprintf(symname,sizeof(symname),"%s_tune",device);
+  frontend->tune = dlsym(handle,symname);
+  snprintf(symname,sizeof(symname),"%s_gain",device);
+  frontend->gain = dlsym(handle,symname);
+  snprintf(symname,sizeof(symname),"%s_atten",device);
+  frontend->atten = dlsym(handle,symname);
+  fprintf(stderr,"Loaded %s from %s:%s%s%s%s\n",device,dlname,
+	  frontend->shutdown ? " shutdown" : "",frontend->tune ? " tune" : "",
+	  frontend->gain ? " gain" : "",frontend->atten ? " atten" : "");
+  return 0;
+}
+
+// Stand-in for create_filter_input(): same mirrored ring buffer and starting write pointer, no FFT
+static int mock_filter_input(struct filter_in *f,int const L,int const M,enum filtertype const type){
+  int const N = L + M - 1;
+  f->in_type = type;
+  f->points = N;
+  f->ilen = L;
+  f->impulse_length = M;
+  f->bins = type == COMPLEX ? N : N/2 + 1;
+  f->perform_inline = true;
+  f->input_buffer_size = round_to_page(ND * N * (type == COMPLEX ? sizeof(float complex) : sizeof(float)));
+  f->input_buffer = mirror_alloc(f->input_buffer_size);
+  if(f->input_buffer == NULL)
+    return -1;
+  memset(f->input_buffer,0,f->input_buffer_size);
+  if(type == COMPLEX){
+    f->input_read_pointer.c = f->input_buffer;
+    f->input_write_pointer.c = f->input_read_pointer.c + (M-1);
+    Stats.expected = f->input_write_pointer.c;
+  } else {
+    f->input_read_pointer.r = f->input_buffer;
+    f->input_write_pointer.r = f->input_read_pointer.r + (M-1);
+    Stats.expected = f->input_write_pointer.r;
+  }
+  pthread_mutex_init(&f->filter_mutex,NULL);
+  pthread_cond_init(&f->filter_cond,NULL);
+  f->init = true;
+  return 0;
+}
+
+// Hand the canned transfers to the driver's callback until mock_shutdown()
+static void *mock_transport(void *arg){
+  (void)arg;
+  pthread_setname("fe-mock");
+  for(uint64_t n = 0; !atomic_load(&Mock.stop); n++){
+    void * const transfer = Mock.failed != NULL && n % MOCK_FAIL_EVERY == MOCK_FAIL_EVERY - 1 ? Mock.failed : Mock.xfers[n % MOCK_XFERS];
+    (*Mock.callback)(transfer);
+  }
+  return NULL;
+}
+
+// Triangular noise, peaks 54 dB below full scale
+static double mock_noise(void){
+  return (random() + random() - (double)RAND_MAX) * (0.002 / RAND_MAX);
+}
+
+// Canned samples, +/-1 = A/D full scale: a tone at half full scale (a complex exponential on I/Q front ends)
+// plus a little noise. One buffer also has a full scale value every 1024 so the driver has overranges to count.
+// The driver encodes each into its own wire format once, here, so the timed loop is all driver
+static int mock_startup(struct frontend * const frontend){
+  int const count = Mock_count;
+  float * const samples = malloc(count * sizeof *samples);
+  if(samples == NULL)
+    return -1;
+  double phase = 0;
+  double const step = 2 * M_PI * 0.1372; // cycles per sample, arbitrary
+  for(int i = 0; i < MOCK_XFERS; i++){
+    for(int j = 0; j < count; ){
+      if(frontend->isreal){
+	samples[j++] = 0.5 * sin(phase) + mock_noise();
+      } else {
+	samples[j++] = 0.5 * cos(phase) + mock_noise();
+	samples[j++] = 0.5 * sin(phase) + mock_noise();
+      }
+      phase = remainder(phase + step,2 * M_PI);
+    }
+    if(i == MOCK_XFERS - 1){
+      for(int j = 0; j < count; j += 1024)
+	samples[j] = (j & 1024) ? -1.0 : +1.0;
+    }
+    Mock.xfers[i] = (*Mock.transfer)(frontend,samples,count);
+    if(Mock.xfers[i] == NULL){
+      fprintf(stderr,"FAIL: mock transfer of %'d values not created\n",count);
+      free(samples);
+      return -1;
+    }
+  }
+  free(samples);
+  Mock.failed = (*Mock.transfer)(frontend,NULL,count);
+  atomic_store(&Mock.stop,false);
+  if(pthread_create(&Mock.thread,NULL,mock_transport,NULL) != 0)
+    return -1;
+  return 0;
+}
+
+static int mock_shutdown(struct frontend * const frontend){
+  (void)frontend;
+  atomic_store(&Mock.stop,true);
+  pthread_join(Mock.thread,NULL);
+  for(int i = 0; i < MOCK_XFERS; i++)
+    FREE(Mock.xfers[i]);
+  FREE(Mock.failed);
+  return 0;
+}
+
+// Common checks on a write of 'size' samples at p; true if it completed a block
+static bool account(struct filter_in *f,void const *p,float const *samples,int size){
+  pthread_mutex_lock(&Stats.lock);
+  if(Stats.calls++ == 0)
+    Stats.writer = pthread_self();
+  else if(!pthread_equal(Stats.writer,pthread_self()))
+    Stats.multiple_writers = true;
+  if(p != Stats.expected)
+    Stats.bad_pointer++;
+  if(size > Stats.max_write)
+    Stats.max_write = size;
+
+  float const full = Stats.fullscale * 0.9886f; // -0.1 dB
+  double energy = 0;
+  uint64_t nonfinite = 0, near_full = 0;
+  int const n = f->in_type == COMPLEX ? 2 * size : size;
+  for(int i = 0; i < n; i++){
+    float const x = samples[i];
+    if(!isfinite(x)){
+      nonfinite++;
+      continue;
+    }
+    energy += x * x;
+    if(fabsf(x) >= full)
+      near_full++;
+  }
+  Stats.energy += energy;
+  Stats.nonfinite += nonfinite;
+  Stats.near_full += near_full;
+  Stats.samples += size;
+  f->wcnt += size;
+  bool executed = false;
+  while(f->wcnt >= f->ilen){
+    f->wcnt -= f->ilen;
+    Stats.blocks++;
+    executed = true;
+  }
+  pthread_mutex_unlock(&Stats.lock);
+  return executed;
+}
+
+// These replace the versions in filter.c, which would also run the forward FFT
+int write_cfilter(struct filter_in *f, float complex const *buffer,int size){
+  if(f == NULL || size < 0)
+    return -1;
+  if((f->wcnt + size) * sizeof *buffer >= f->input_buffer_size){
+    Stats.too_big++;
+    return -1;
+  }
+  if(buffer != NULL)
+    memcpy(f->input_write_pointer.c, buffer, size * sizeof *buffer);
+  bool const executed = account(f,f->input_write_pointer.c,(float const *)f->input_write_pointer.c,size);
+  f->input_write_pointer.c += size;
+  mirror_wrap((void *)&f->input_write_pointer.c, f->input_buffer, f->input_buffer_size);
+  Stats.expected = f->input_write_pointer.c;
+  return executed;
+}
+int write_rfilter(struct filter_in *f, float const *buffer,int size){
+  if(f == NULL || size < 0)
+    return -1;
+  if((f->wcnt + size) * sizeof *buffer >= f->input_buffer_size){
+    Stats.too_big++;
+    return -1;
+  }
+  if(buffer != NULL)
+    memcpy(f->input_write_pointer.r, buffer, size * sizeof *buffer);
+  bool const executed = account(f,f->input_write_pointer.r,f->input_write_pointer.r,size);
+  f->input_write_pointer.r += size;
+  mirror_wrap((void *)&f->input_write_pointer.r, f->input_buffer, f->input_buffer_size);
+  Stats.expected = f->input_write_pointer.r;
+  return executed;
+}
+
+// CPU seconds used by all threads in this process; main() is asleep nearly all the time
+static double cputime(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID,&ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void usage(void){
+  fprintf(stderr,"Usage: fe-bench [-v] [-m|--mock [-n|--count values]] [-t|--time seconds] [-b|--blocktime ms] [-o|--overlap n] config_file section\n");
+  fprintf(stderr,"-m (rx888, airspy, hackrf, rtlsdr, sdrplay, fobos, hydrasdr) feeds the driver canned transfers instead of a device; count is a multiple of 16\n");
+}
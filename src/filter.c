@@ -70,6 +70,7 @@ struct fft {
   pthread_mutex_t queue_mutex; // protects job_queue
   pthread_cond_t queue_cond;   // signaled when job put on job_queue
   struct fft_job *job_queue;
+  struct fft_work *work_queue; // Background work, run only when job_queue is empty
   pthread_t thread[NTHREADS_MAX];  // Worker threads
 };
 
@@ -219,6 +220,8 @@ int create_filter_input(struct filter_in *master,int const L,int const M, enum f
   if(!master->init){
     pthread_mutex_init(&master->filter_mutex,NULL);
     pthread_cond_init(&master->filter_cond,NULL);
+    pthread_mutex_init(&master->tap.mutex,NULL);
+    pthread_rwlock_init(&master->tap.rwlock,NULL);
     master->init = true;
   }
   master->owner = pthread_self();
@@ -478,6 +481,28 @@ int64_t Max_fft_time = 0;
 int64_t Avg_fft_time = 0;
 int64_t Mean_dev = 0;
 
+// Sum the power in each bin of a forward FFT into the tap, if anyone is reading it
+// Done before the notches so the spectrum shows what's really there
+static void tap_power(struct filter_in * const f,float complex const * const fdomain,uint64_t const sample_index){
+  struct power_tap * const tap = &f->tap;
+  pthread_mutex_lock(&tap->mutex);
+  if(tap->users > 0 && tap->sum != NULL && tap->bins == f->bins){
+    float * restrict const sum = tap->sum;
+    float const * restrict const x = (float const *)fdomain;
+    if(tap->blocks == 0){
+      for(int k=0; k < f->bins; k++)
+	sum[k] = x[2*k] * x[2*k] + x[2*k+1] * x[2*k+1];
+    } else {
+      for(int k=0; k < f->bins; k++)
+	sum[k] += x[2*k] * x[2*k] + x[2*k+1] * x[2*k+1];
+    }
+    // Workers can finish out of order
+    if(tap->blocks++ == 0 || (int64_t)(sample_index - tap->sample_index) > 0)
+      tap->sample_index = sample_index;
+  }
+  pthread_mutex_unlock(&tap->mutex);
+}
+
 // Worker thread(s) that actually execute FFTs
 // Used for input FFTs since they tend to be large and CPU-consuming
 // Lets the input thread process the next input block in parallel on another core
@@ -492,8 +517,17 @@ void *run_fft(void *p){
   do {
     // Get next job
     pthread_mutex_lock(&FFT.queue_mutex);
-    while(FFT.job_queue == NULL)
+    while(FFT.job_queue == NULL && FFT.work_queue == NULL)
       pthread_cond_wait(&FFT.queue_cond,&FFT.queue_mutex);
+    if(FFT.job_queue == NULL){
+      // Nothing more urgent; do a piece of background work
+      struct fft_work *work = FFT.work_queue;
+      FFT.work_queue = work->next;
+      pthread_mutex_unlock(&FFT.queue_mutex);
+      if((*work->func)(work->arg))
+	submit_fft_work(work); // Not done; to the back of the line, behind any forward FFTs that came in meanwhile
+      continue;
+    }
     struct fft_job *job = FFT.job_queue;
     FFT.job_queue = job->next;
     pthread_mutex_unlock(&FFT.queue_mutex);
@@ -510,6 +544,7 @@ void *run_fft(void *p){
       default:
 	break;
       }
+      tap_power(job->fin,job->output,job->fin->samples_by_job[job->jobnum % ND]);
     }
     drop_cache(job->input,job->input_dropsize);
     // Apply notches, if any
@@ -584,6 +619,7 @@ int execute_filter_input(struct filter_in * const f){
       }
       break;
     }
+    tap_power(f,output,f->sample_index);
     // Apply notches, if any
     if(f->notches != NULL)
       apply_notch_filters(f->notches,output);
@@ -649,6 +685,119 @@ int execute_filter_input(struct filter_in * const f){
   pthread_mutex_unlock(&FFT.queue_mutex);
   return 0;
 }
+// Run work->func(work->arg) on an FFT worker thread when it has no forward FFTs to do, or right here if there are no workers
+// Used for work that can be split up, like averaging spectrum analyzer FFTs. The caller owns work and arranges to learn when it's done
+// A worker does one piece at a time, and checks for forward FFTs before each
+void submit_fft_work(struct fft_work *work){
+  if(N_worker_threads == 0){
+    while((*work->func)(work->arg))
+      ;
+    return;
+  }
+  work->next = NULL;
+  struct fft_work *jp_prev = NULL;
+  pthread_mutex_lock(&FFT.queue_mutex);
+  for(struct fft_work *jp = FFT.work_queue; jp != NULL; jp = jp->next)
+    jp_prev = jp;
+  if(jp_prev)
+    jp_prev->next = work;
+  else
+    FFT.work_queue = work;
+  pthread_cond_signal(&FFT.queue_cond);
+  pthread_mutex_unlock(&FFT.queue_mutex);
+}
+/* Coarse power spectrum for spectrum channels, taken from the forward FFTs we do anyway
+   |X[k]|^2 of every block is summed until a reader asks for it. The blocks are unwindowed and overlap by M-1 samples
+   (overlap-save), so each bin is a rectangular-window estimate with spacing samprate/N.
+   Readers must hold the filter input open between attach_power_tap() and detach_power_tap()
+*/
+// (Re)size the tap buffers to the current FFT; caller holds both locks
+static int size_power_tap(struct filter_in * const f){
+  struct power_tap * const tap = &f->tap;
+  if(tap->bins == f->bins && tap->sum != NULL && tap->result != NULL)
+    return 0;
+  FREE(tap->sum);
+  FREE(tap->result);
+  tap->bins = 0;
+  tap->blocks = 0;
+  tap->result_blocks = 0;
+  if(f->bins <= 0)
+    return -1;
+  tap->sum = lmalloc(f->bins * sizeof *tap->sum);
+  tap->result = lmalloc(f->bins * sizeof *tap->result);
+  if(tap->sum == NULL || tap->result == NULL){
+    FREE(tap->sum);
+    FREE(tap->result);
+    return -1;
+  }
+  tap->bins = f->bins;
+  return 0;
+}
+
+int attach_power_tap(struct filter_in * const f){
+  if(f == NULL || !f->init)
+    return -1;
+  struct power_tap * const tap = &f->tap;
+  pthread_rwlock_wrlock(&tap->rwlock);
+  pthread_mutex_lock(&tap->mutex);
+  int const r = size_power_tap(f);
+  if(r == 0)
+    tap->users++;
+  pthread_mutex_unlock(&tap->mutex);
+  pthread_rwlock_unlock(&tap->rwlock);
+  return r;
+}
+
+void detach_power_tap(struct filter_in * const f){
+  if(f == NULL || !f->init)
+    return;
+  struct power_tap * const tap = &f->tap;
+  pthread_rwlock_wrlock(&tap->rwlock);
+  pthread_mutex_lock(&tap->mutex);
+  if(tap->users > 0 && --tap->users == 0){
+    FREE(tap->sum);
+    FREE(tap->result);
+    tap->bins = 0;
+  }
+  pthread_mutex_unlock(&tap->mutex);
+  pthread_rwlock_unlock(&tap->rwlock);
+}
+
+/* Return the power summed over the blocks since the last read by anyone (or the last result, if no block has finished since)
+   The result is f->bins long, in FFT order, and unscaled. *blocks gets the number of blocks summed
+   Returns NULL if nothing is available yet. Either way, the caller must call unlock_power_tap() when done with it
+*/
+float const *read_power_tap(struct filter_in * const f,int *blocks,uint64_t *sample_index){
+  struct power_tap * const tap = &f->tap;
+  pthread_rwlock_wrlock(&tap->rwlock);
+  pthread_mutex_lock(&tap->mutex);
+  if(tap->users > 0 && size_power_tap(f) == 0 && tap->blocks > 0){
+    // Swap the buffers; the next block will overwrite the old result
+    float * const t = tap->result;
+    tap->result = tap->sum;
+    tap->sum = t;
+    tap->result_blocks = tap->blocks;
+    tap->result_index = tap->sample_index;
+    tap->blocks = 0;
+  }
+  pthread_mutex_unlock(&tap->mutex);
+  pthread_rwlock_unlock(&tap->rwlock);
+
+  // Another reader can swap in between, but then we just get its newer result
+  pthread_rwlock_rdlock(&tap->rwlock);
+  if(tap->result == NULL || tap->result_blocks == 0)
+    return NULL;
+  if(blocks)
+    *blocks = tap->result_blocks;
+  if(sample_index)
+    *sample_index = tap->result_index;
+  return tap->result;
+}
+
+void unlock_power_tap(struct filter_in * const f){
+  pthread_rwlock_unlock(&f->tap.rwlock);
+}
+
 /* Execute the output side of a filter:
    1 - wait for a forward FFT job to complete
    frequency domain data is in a circular queue ND buffers deep to tolerate scheduling jitter
@@ -933,6 +1082,10 @@ int delete_filter_input(struct filter_in * master){
   ASSERT_UNLOCKED(&master->filter_mutex);
   pthread_mutex_destroy(&master->filter_mutex);
   pthread_cond_destroy(&master->filter_cond);
+  pthread_mutex_destroy(&master->tap.mutex);
+  pthread_rwlock_destroy(&master->tap.rwlock);
+  FREE(master->tap.sum);
+  FREE(master->tap.result);
   destroy_plan(&master->fwd_plan);
   mirror_free(&master->input_buffer,master->input_buffer_size); // Don't use free() !
   for(int i=0; i < ND; i++)
@@ -1102,6 +1255,8 @@ int write_cfilter(struct filter_in *f, float complex const *buffer,int size){
     memcpy(f->input_write_pointer.c, buffer, size * sizeof *buffer);
   f->input_write_pointer.c += size;
   mirror_wrap((void *)&f->input_write_pointer.c, f->input_buffer, f->input_buffer_size);
+  // Publish after the copy; the spectrum engine derives its ring position from this alone
+  atomic_fetch_add_explicit(&f->written,size,memory_order_release);
   f->wcnt += size;
   bool executed = false;
   while(f->wcnt >= f->ilen){
@@ -1123,6 +1278,8 @@ int write_rfilter(struct filter_in *f, float const *buffer,int size){
     memcpy(f->input_write_pointer.r, buffer, size * sizeof *buffer);
   f->input_write_pointer.r += size;
   mirror_wrap((void *)&f->input_write_pointer.r, f->input_buffer, f->input_buffer_size);
+  // Publish after the copy; the spectrum engine derives its ring position from this alone
+  atomic_fetch_add_explicit(&f->written,size,memory_order_release);
   f->wcnt += size;
   bool executed = false;
   while(f->wcnt >= f->ilen){
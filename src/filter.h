@@ -11,6 +11,7 @@
 #include <pthread.h>
 #include <complex.h>
 #include <stdbool.h>
+#include <stdatomic.h>
 #include <fftw3.h>
 #include "misc.h"
 
@@ -45,6 +46,28 @@ struct notch_state {
   double alpha;         // gain of averager, larger -> wider notch
 };
 
+// Power spectrum summed from the forward FFTs of a filter input, for spectrum channels
+struct power_tap {
+  pthread_mutex_t mutex;     // protects users, sum, blocks, sample_index; held by FFT workers while summing
+  pthread_rwlock_t rwlock;   // protects result while it's being read
+  int users;                 // Readers; nothing is summed when 0
+  int bins;                  // Size of sum and result
+  float *sum;                // |X[k]|^2 summed over 'blocks' forward FFTs
+  int blocks;
+  uint64_t sample_index;     // Input sample index at start of newest block summed
+  float *result;             // Last sum handed to readers
+  int result_blocks;
+  uint64_t result_index;
+};
+
+/* Background work for the FFT workers (see submit_fft_work()), embedded in the submitter's own state
+   func does one small piece, e.g., one FFT, so a worker can get back to the forward FFTs between pieces */
+struct fft_work {
+  struct fft_work *next;
+  bool (*func)(void *);  // Returns true while there's more to do
+  void *arg;
+};
+
 #define ND 4
 struct filter_in {
   enum filtertype in_type;           // REAL, COMPLEX
@@ -56,6 +79,7 @@ struct filter_in {
   void *input_buffer;                // Beginning of mirrored ring buffer
   size_t input_buffer_size;          // size of input buffer in **bytes**
   struct rc input_write_pointer;     // For incoming samples
+  _Atomic uint64_t written;          // Samples ever written; the write pointer is M-1 + written mod the ring size
   struct rc input_read_pointer;      // For FFT input
   fftwf_plan fwd_plan;               // FFT (time -> frequency)
 
@@ -71,6 +95,7 @@ struct filter_in {
   uint64_t samples_by_job[ND];
   bool init;
   pthread_t owner;           // thread ID of writer to this filter, disables waits when read in same thread
+  struct power_tap tap;
 };
 
 struct filter_out {
@@ -104,6 +129,11 @@ int delete_filter_input(struct filter_in *);
 int delete_filter_output(struct filter_out *);
 int set_filter(struct filter_out *,double,double,double);
 void *run_fft(void *);
+void submit_fft_work(struct fft_work *);
+int attach_power_tap(struct filter_in *);
+void detach_power_tap(struct filter_in *);
+float const *read_power_tap(struct filter_in *,int *blocks,uint64_t *sample_index);
+void unlock_power_tap(struct filter_in *);
 int write_cfilter(struct filter_in * restrict, float complex const * restrict, int size);
 int write_rfilter(struct filter_in * restrict, float const * restrict , int size);
 void suggest(int size,int dir,int clex);
@@ -68,19 +68,8 @@ int demod_fm(void *arg){
     response(chan,response_needed);
     response_needed = false;
 
-    pthread_mutex_lock(&chan->status.lock);
-    // Look on the command queue and grab just one atomically
-    for(int i=0;i < CQLEN; i++){
-      if(chan->commands[i].buffer != NULL){
-	restart_needed = decode_radio_commands(chan,chan->commands[i].buffer,
-					       chan->commands[i].length);
-	FREE(chan->commands[i].buffer);
-	chan->commands[i].length = 0;
-	response_needed = true;
-	break;
-      }
-    }
-    pthread_mutex_unlock(&chan->status.lock);
+    // Execute the next command, if any
+    response_needed = next_command(chan,&restart_needed);
     int r;
     if(restart_needed || (r = downconvert(chan)) == -1)
       break; // restart or terminate
@@ -76,6 +76,8 @@ struct sdrstate {
 
 static void rx_callback(float * restrict buf, unsigned buf_length, void * restrict ctx);
 static void *fobos_monitor(void *p);
+static struct sdrstate *new_sdrstate(struct frontend *frontend);
+static void set_direct_sampling_levels(struct frontend *frontend);
 
 static int find_serial_position(const char *serials, const char *serialnumcfg) {
   if (serialnumcfg == NULL) {
@@ -105,10 +107,6 @@ int fobos_setup(struct frontend *const frontend, dictionary const * const dictio
                 char const *const section) {
   assert(dictionary != NULL);
   config_validate_section(stderr, dictionary, section, Fobos_keys, NULL);
-  frontend->isreal = false; // Make sure the right kind of filter gets created!
-  // The Fobos apparently provides scaled float samples
-  frontend->bitspersample = 1; // only used for gain scaling
-  frontend->rf_agc = false; // On by default unless gain or atten is specified
 
   // Read Config Files
   {
@@ -154,14 +152,8 @@ int fobos_setup(struct frontend *const frontend, dictionary const * const dictio
     }
   }
   // Open the SDR
-  struct sdrstate *const sdr = calloc(1, sizeof(struct sdrstate));
-  // Cross-link generic and hardware-specific control structures
-  assert(sdr != NULL);
-  sdr->frontend = frontend;
-  frontend->context = sdr;
+  struct sdrstate *const sdr = new_sdrstate(frontend);
   sdr->scale = scale_AD(frontend);
-  sdr->buff_count = 0;
-  sdr->max_buff_count = 2048;
   sdr->device = position;
   result = fobos_rx_open(&sdr->dev, sdr->device);
   if (result != FOBOS_ERR_OK) {
@@ -254,15 +246,7 @@ int fobos_setup(struct frontend *const frontend, dictionary const * const dictio
   frontend->max_IF = 0.47 * frontend->samprate;
 
   if(sdr->direct_sampling){
-    // With -40 dBm @ 15 MHz on B input and nothing on A input,
-    // A/D reads -42.2 dBm
-    // So level_cal = -0.8 dB gives (average) input of -43.0 dBm
-    // Note I flipped the sign convention on rf_level_cal to have units of dBm/FS
-    // ie, how many dBm on the input gives 0 dBFS
-    frontend->frequency = 0;
-    frontend->rf_gain = 0;
-    frontend->rf_atten = 0;
-    frontend->rf_level_cal = -0.8;
+    set_direct_sampling_levels(frontend);
   } else {
     const char *frequencycfg =
       config_getstring(dictionary, section, "frequency", "100m0");
@@ -326,6 +310,77 @@ int fobos_setup(struct frontend *const frontend, dictionary const * const dictio
 
 } // End of Setup
 
+// Driver state before the device is opened, shared by fobos_setup() and fobos_mock_setup()
+static struct sdrstate *new_sdrstate(struct frontend * const frontend){
+  struct sdrstate *const sdr = calloc(1, sizeof(struct sdrstate));
+  // Cross-link generic and hardware-specific control structures
+  assert(sdr != NULL);
+  sdr->frontend = frontend;
+  frontend->context = sdr;
+  frontend->isreal = false; // Make sure the right kind of filter gets created!
+  // The Fobos apparently provides scaled float samples
+  frontend->bitspersample = 1; // only used for gain scaling
+  frontend->rf_agc = false; // On by default unless gain or atten is specified
+  sdr->buff_count = 0;
+  sdr->max_buff_count = 2048;
+  return sdr;
+}
+
+// Fixed 20 dB amplifiers straight into the A/Ds, no tuner
+static void set_direct_sampling_levels(struct frontend * const frontend){
+  // With -40 dBm @ 15 MHz on B input and nothing on A input,
+  // A/D reads -42.2 dBm
+  // So level_cal = -0.8 dB gives (average) input of -43.0 dBm
+  // Note I flipped the sign convention on rf_level_cal to have units of dBm/FS
+  // ie, how many dBm on the input gives 0 dBFS
+  frontend->frequency = 0;
+  frontend->rf_gain = 0;
+  frontend->rf_atten = 0;
+  frontend->rf_level_cal = -0.8;
+}
+
+// fe-bench -m: the driver with libfobos's transport replaced by canned buffers
+// No device, so it runs as in direct sample mode at the requested sample rate
+int fobos_mock_setup(struct frontend *const frontend, dictionary const * const dictionary,
+		     char const *const section) {
+  assert(dictionary != NULL);
+  struct sdrstate *const sdr = new_sdrstate(frontend);
+  frontend->samprate = config_getdouble(dictionary, section, "samprate", 8000000.0);
+  frontend->min_IF = -0.47 * frontend->samprate;
+  frontend->max_IF = 0.47 * frontend->samprate;
+  sdr->direct_sampling = true;
+  set_direct_sampling_levels(frontend);
+  strlcpy(frontend->description,"fobos mock",sizeof(frontend->description));
+  sdr->scale = scale_AD(frontend);
+  return 0;
+}
+
+// What fobos_rx_read_async() hands rx_callback()
+struct mock_transfer {
+  struct sdrstate *sdr;
+  unsigned len;
+  float buf[];
+};
+
+// Copy 'count' values (interleaved I/Q, +/-1 = full scale) into one buffer as libfobos would deliver it
+// libfobos already delivers floats, so there's nothing to encode
+// libfobos has no failed transfers, so samples == NULL gives NULL. free() the result when done
+void *fobos_mock_transfer(struct frontend * const frontend,float const * const samples,int const count){
+  if(samples == NULL)
+    return NULL;
+  struct mock_transfer * const transfer = calloc(1,sizeof(*transfer) + count * sizeof(float));
+  assert(transfer != NULL);
+  transfer->sdr = frontend->context;
+  transfer->len = count / 2; // complex samples
+  memcpy(transfer->buf,samples,count * sizeof(float));
+  return transfer;
+}
+
+void fobos_mock_callback(void * const p){
+  struct mock_transfer * const transfer = p;
+  rx_callback(transfer->buf,transfer->len,transfer->sdr);
+}
+
 /* command to set analog gain. Turn off AGC if it was on
   MAX2830 datasheet: vga gain 0-63 dB in 2 dB steps (0x00 - 0x1F)
   lna gain: 00 -> -33 dB; 10 -> -16 dB; 11 -> 0 dB
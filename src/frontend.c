@@ -0,0 +1,58 @@
+// Front end helpers shared by radiod and the drivers it loads, kept out of radio.c so fe-bench can link them too
+// Copyright 2017-2025, Phil Karn, KA9Q
+#include <assert.h>
+#include <math.h>
+
+#include "misc.h"
+#include "radio.h"
+
+// scale A/D output power to full scale for monitoring overloads
+double scale_ADpower2FS(struct frontend const *frontend){
+  assert(frontend != NULL);
+  if(frontend == NULL)
+    return NAN;
+
+  assert(frontend->bitspersample > 0);
+  double scale = 1.0 / (1 << (frontend->bitspersample - 1)); // Important to force the numerator to double, otherwise the divide produces zero!
+  scale *= scale;
+  // Scale real signals up 3 dB so a rail-to-rail sine will be 0 dBFS, not -3 dBFS
+  // Complex signals carry twice as much power, divided between I and Q
+  if(frontend->isreal)
+    scale *= 2;
+  return scale;
+}
+// Returns multiplicative factor for converting raw samples to doubles with analog gain correction
+// Front ends providing floating point in the nominal +/- 1 range have effectively 1 bit/sample, for a unity scale factor
+double scale_AD(struct frontend const *frontend){
+  assert(frontend != NULL);
+  if(frontend == NULL)
+    return NAN;
+
+  assert(frontend->bitspersample > 0);
+  // net analog gain, dBm to dBFS, that we correct for to maintain unity gain, i.e., 0 dBm -> 0 dBFS
+
+  double analog_gain = 0;
+  if(!isnan(frontend->rf_gain) && isfinite(frontend->rf_gain))
+    analog_gain += frontend->rf_gain;
+  if (!isnan(frontend->rf_atten) && isfinite(frontend->rf_atten))
+    analog_gain -= frontend->rf_atten;
+  if(!isnan(frontend->rf_level_cal) && isfinite(frontend->rf_level_cal))
+    analog_gain -= frontend->rf_level_cal; // new sign convention
+  if(frontend->isreal)
+    analog_gain -= 3.0;
+  // Will first get called before the filter input is created
+  //  = (10 ^ (-analog_gain/10)) * 2^(1-bitspersample)
+  return ldexp(dB2voltage(-analog_gain), 1-frontend->bitspersample); // Front end gain as amplitude ratio
+}
+// A/D code nearest x, where +/-1 is full scale, for a 'bits'-wide two's complement converter.
+// Clips like the real thing. Used by the drivers' fe-bench -m mock transports to build canned transfers
+int mock_ad_code(double x,int bits){
+  assert(bits > 1 && bits <= 31);
+  long const fs = 1L << (bits - 1);
+  long code = lrint(x * fs);
+  if(code > fs - 1)
+    code = fs - 1;
+  else if(code < -fs)
+    code = -fs;
+  return (int)code;
+}
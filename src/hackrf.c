@@ -81,6 +81,9 @@ static char const *HackRF_keys[] = {
   NULL
 };
 static int rx_callback(hackrf_transfer *transfer);
+static struct sdrstate *new_sdrstate(struct frontend *frontend);
+static double config_samprate(dictionary const *dictionary,char const *section);
+static double set_bandwidth(struct frontend *frontend);
 static void *hackrf_agc(void *arg);
 #if 0
 static double rffc5071_freq(uint16_t lo);
@@ -97,14 +100,7 @@ int hackrf_setup(struct frontend * const frontend,dictionary const * const dicti
       return -1; // Not for us
   }
   config_validate_section(stderr,dictionary,section,HackRF_keys,NULL);
-  struct sdrstate * const sdr = calloc(1,sizeof(struct sdrstate));
-  assert(sdr != NULL);
-  // Cross-link generic and hardware-specific control structures
-  sdr->frontend = frontend;
-  frontend->context = sdr;
-  frontend->isreal = false; // Make sure the right kind of filter gets created!
-  frontend->bitspersample = 8; // For gain scaling
-  frontend->rf_agc = true; // On by default unless gain or atten is specified
+  struct sdrstate * const sdr = new_sdrstate(frontend);
 
   int ret;
   if((ret = hackrf_init()) != HACKRF_SUCCESS){
@@ -145,12 +141,7 @@ int hackrf_setup(struct frontend * const frontend,dictionary const * const dicti
     hackrf_exit();
     return -1;
   }
-  double samprate = Default_samprate;
-  {
-    char const *p = config_getstring(dictionary, section, "samprate", NULL);
-    if(p != NULL)
-      samprate = parse_frequency(p,false);
-  }
+  double const samprate = config_samprate(dictionary,section);
   frontend->samprate = samprate;
   ret = hackrf_set_sample_rate(sdr->device,(uint32_t)samprate);
   if(ret != HACKRF_SUCCESS){
@@ -159,17 +150,13 @@ int hackrf_setup(struct frontend * const frontend,dictionary const * const dicti
     return -1;
   }
 
-  double bw = (double)hackrf_compute_baseband_filter_bw_round_down_lt(samprate);
+  double const bw = set_bandwidth(frontend);
   ret = hackrf_set_baseband_filter_bandwidth(sdr->device,bw);
   if(ret != HACKRF_SUCCESS){
     fprintf(stderr,"hackrf_set_baseband_filter_bandwidth(%lf): %s\n",bw,hackrf_error_name(ret));
     hackrf_exit();
     return -1;
   }
-  // Are these right?
-  frontend->max_IF = min(bw,frontend->samprate/2);
-  frontend->min_IF = -min(bw,frontend->samprate/2);
-
 
   // NOTE: what we call mixer gain, they call lna gain
   // What we call lna gain, they call antenna enable
@@ -218,8 +205,6 @@ int hackrf_setup(struct frontend * const frontend,dictionary const * const dicti
 
 
   frontend->rf_gain = sdr->lna_gain + sdr->mixer_gain + sdr->if_gain;
-  frontend->rf_atten = 0;
-  frontend->rf_level_cal = NAN; // To be measured
   sdr->scale = scale_AD(frontend);
 
   double frequency = config_getdouble(dictionary, section, "frequency", 0);
@@ -234,12 +219,6 @@ int hackrf_setup(struct frontend * const frontend,dictionary const * const dicti
       return -1;
     }
   }
-  sdr->sinphi = 0;
-  sdr->tanphi = 0;
-  sdr->secphi = 1;
-  sdr->gain_i = 1;
-  sdr->gain_q = 1;
-
   fprintf(stderr,"device %d; A/D sample rate %'lf Hz freq %'.1f Hz lna gain %d mix gain %d if gain %d agc %s\n",
 	  index,samprate,frequency,
 	  frontend->lna_gain,
@@ -249,6 +228,76 @@ int hackrf_setup(struct frontend * const frontend,dictionary const * const dicti
   return 0;
 }
 
+// Driver state before any device or gain settings, shared by hackrf_setup() and hackrf_mock_setup()
+static struct sdrstate *new_sdrstate(struct frontend * const frontend){
+  struct sdrstate * const sdr = calloc(1,sizeof(struct sdrstate));
+  assert(sdr != NULL);
+  // Cross-link generic and hardware-specific control structures
+  sdr->frontend = frontend;
+  frontend->context = sdr;
+  frontend->isreal = false; // Make sure the right kind of filter gets created!
+  frontend->bitspersample = 8; // For gain scaling
+  frontend->rf_agc = true; // On by default unless gain or atten is specified
+  frontend->rf_atten = 0;
+  frontend->rf_level_cal = NAN; // To be measured
+  // No I/Q correction until the callback has estimated the errors
+  sdr->sinphi = 0;
+  sdr->tanphi = 0;
+  sdr->secphi = 1;
+  sdr->gain_i = 1;
+  sdr->gain_q = 1;
+  return sdr;
+}
+
+static double config_samprate(dictionary const * const dictionary,char const * const section){
+  double samprate = Default_samprate;
+  char const *p = config_getstring(dictionary, section, "samprate", NULL);
+  if(p != NULL)
+    samprate = parse_frequency(p,false);
+  return samprate;
+}
+
+// Baseband filter bandwidth for the sample rate, and the IF range it passes
+static double set_bandwidth(struct frontend * const frontend){
+  double const bw = (double)hackrf_compute_baseband_filter_bw_round_down_lt(frontend->samprate);
+  // Are these right?
+  frontend->max_IF = min(bw,frontend->samprate/2);
+  frontend->min_IF = -min(bw,frontend->samprate/2);
+  return bw;
+}
+
+// fe-bench -m: the driver with libhackrf's transport replaced by canned transfers
+// No device, so the gains stay at zero and the software AGC stays off
+int hackrf_mock_setup(struct frontend * const frontend,dictionary const * const dictionary,char const * const section){
+  assert(dictionary != NULL);
+  struct sdrstate * const sdr = new_sdrstate(frontend);
+  frontend->rf_agc = false;
+  frontend->samprate = config_samprate(dictionary,section);
+  set_bandwidth(frontend);
+  strlcpy(frontend->description,"HackRF mock",sizeof(frontend->description));
+  sdr->scale = scale_AD(frontend);
+  return 0;
+}
+
+// Encode 'count' values (interleaved I/Q, +/-1 = full scale) as one int8 transfer as libhackrf would deliver it
+// libhackrf has no failed transfers, so samples == NULL gives NULL. Transfer and buffer are one block; free() it
+void *hackrf_mock_transfer(struct frontend * const frontend,float const * const samples,int const count){
+  if(samples == NULL)
+    return NULL;
+  hackrf_transfer * const transfer = calloc(1,sizeof(*transfer) + count);
+  assert(transfer != NULL);
+  transfer->buffer = (uint8_t *)(transfer + 1);
+  transfer->buffer_length = transfer->valid_length = count;
+  transfer->rx_ctx = frontend->context;
+  for(int i=0; i < count; i++)
+    transfer->buffer[i] = (uint8_t)mock_ad_code(samples[i],8);
+  return transfer;
+}
+
+void hackrf_mock_callback(void * const transfer){
+  rx_callback((hackrf_transfer *)transfer);
+}
+
 int hackrf_startup(struct frontend * const frontend){
   assert(frontend != NULL);
   struct sdrstate *sdr = frontend->context;
@@ -312,6 +361,7 @@ static int rx_callback(hackrf_transfer *transfer){
   double complex samp_sum = 0;
   double i_energy=0,q_energy=0;
   double dotprod = 0;                           // sum of I*Q, for phase balance
+  int clips = 0;
   // Use double to minimize risk of denormals
   // Should probably be an exp() here, but it's OK as long as it's small
   double rate_factor = 1./(frontend->samprate * Power_tc);
@@ -323,11 +373,11 @@ static int rx_callback(hackrf_transfer *transfer){
     int isamp_q = (int8_t)*dp++;
 
     if(isamp_q == -128){
-      sdr->clips++;
+      clips++;
       isamp_q = -127;
     }
     if(isamp_i == -128){
-      sdr->clips++;
+      clips++;
       isamp_i = -127;
     }
     double complex samp = CMPLX(isamp_i,isamp_q);
@@ -353,6 +403,12 @@ static int rx_callback(hackrf_transfer *transfer){
     wptr[i] = (float complex)(sdr->scale * samp);
   }
   write_cfilter(&frontend->in,NULL,sampcount); // Update write pointer, invoke FFT if block is complete
+  if(clips){
+    sdr->clips += clips;
+    frontend->overranges += clips;
+    frontend->samp_since_over = 0;
+  } else
+    frontend->samp_since_over += sampcount;
 
   // Update every block
   // estimates of DC offset, signal powers and phase error
@@ -361,7 +417,9 @@ static int rx_callback(hackrf_transfer *transfer){
   double block_energy = 0.5 * (i_energy + q_energy); // Normalize for complex pairs
 
   // These blocks are kinda small, so exponentially smooth the power readings
-  frontend->if_power += sampcount * rate_factor * (block_energy/sampcount - frontend->if_power);
+  // Like the other complex front ends, power is I^2 + Q^2 per sample; scale_ADpower2FS() expects that
+  if(sampcount != 0)
+    frontend->if_power += sampcount * rate_factor * ((i_energy + q_energy)/sampcount - frontend->if_power);
   frontend->samples += sampcount; // Count original samples
   if(block_energy > 0){ // Avoid divisions by 0, etc
     sdr->imbalance += rate_factor * sampcount * ((i_energy / q_energy) - sdr->imbalance);
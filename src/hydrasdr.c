@@ -119,6 +119,7 @@ static int rx_callback(hydrasdr_transfer *transfer);
 static void *hydrasdr_monitor(void *p);
 static double true_freq(uint64_t freq);
 static void set_gain(struct sdrstate *sdr,int gainstep);
+static void set_format(struct sdrstate *sdr,dictionary const *Dictionary,char const *section,double default_samprate);
 
 int hydrasdr_setup(struct frontend * const frontend,dictionary const * const Dictionary,char const * const section){
   assert(Dictionary != NULL);
@@ -319,32 +320,7 @@ int hydrasdr_setup(struct frontend * const frontend,dictionary const * const Dic
 	break;
     }
   }
-  frontend->samprate = sdr->sample_rates[0];  // Default to first (highest) sample rate on list
-  {
-    char const *p = config_getstring(Dictionary,section,"samprate",NULL);
-    if(p != NULL)
-      frontend->samprate = parse_frequency(p,false);
-  }
-  // We already knew if an offset had to applied, but not how much until we knew the sample rate
-  switch(sdr->sample_type){
-  case HYDRASDR_SAMPLE_FLOAT32_IQ:
-  case HYDRASDR_SAMPLE_INT16_IQ:
-  case HYDRASDR_SAMPLE_INT8_IQ:
-  case HYDRASDR_SAMPLE_UINT8_IQ:
-    frontend->isreal = false;
-    sdr->offset = 0;
-    break;
-  case HYDRASDR_SAMPLE_FLOAT32_REAL:
-  case HYDRASDR_SAMPLE_INT16_REAL:
-  case HYDRASDR_SAMPLE_UINT16_REAL:
-  case HYDRASDR_SAMPLE_RAW:
-  case HYDRASDR_SAMPLE_INT8_REAL:
-  case HYDRASDR_SAMPLE_UINT8_REAL:
-  default:
-    frontend->isreal = true;
-    sdr->offset = +frontend->samprate / 4; // Positive for high-side injection (assumed)
-    break;
-  }
+  set_format(sdr,Dictionary,section,sdr->sample_rates[0]); // Default to first (highest) sample rate on list
   fprintf(stderr,"; choosing %'.3lf Hz, offset %'.3lf Hz\n",frontend->samprate,sdr->offset);
   funlockfile(stderr);
   {
@@ -414,18 +390,6 @@ int hydrasdr_setup(struct frontend * const frontend,dictionary const * const Dic
   fputc('\n',stderr);
   funlockfile(stderr);
 
-  sdr->converter = config_getdouble(Dictionary,section,"converter",0);
-  frontend->calibrate = config_getdouble(Dictionary,section,"calibrate",0);
-  // Set this from bandwidth info
-  if(frontend->isreal){
-    frontend->max_IF = -600000;
-    frontend->min_IF = -0.47 * frontend->samprate;
-  } else {
-    // Complex, symmetrical
-    frontend->max_IF = 0.47 * frontend->samprate;
-    frontend->min_IF = -frontend->max_IF;
-  }
-
   // Hardware device settings
   bool lna_agc = false;
   bool rf_agc = false;
@@ -559,6 +523,91 @@ int hydrasdr_setup(struct frontend * const frontend,dictionary const * const Dic
   }
   return 0;
 }
+// Sample rate and everything that follows from it and the sample type, shared by hydrasdr_setup() and hydrasdr_mock_setup()
+static void set_format(struct sdrstate * const sdr,dictionary const * const Dictionary,char const * const section,double const default_samprate){
+  struct frontend * const frontend = sdr->frontend;
+  frontend->samprate = default_samprate;
+  {
+    char const *p = config_getstring(Dictionary,section,"samprate",NULL);
+    if(p != NULL)
+      frontend->samprate = parse_frequency(p,false);
+  }
+  // We already knew if an offset had to applied, but not how much until we knew the sample rate
+  switch(sdr->sample_type){
+  case HYDRASDR_SAMPLE_FLOAT32_IQ:
+  case HYDRASDR_SAMPLE_INT16_IQ:
+  case HYDRASDR_SAMPLE_INT8_IQ:
+  case HYDRASDR_SAMPLE_UINT8_IQ:
+    frontend->isreal = false;
+    sdr->offset = 0;
+    break;
+  case HYDRASDR_SAMPLE_FLOAT32_REAL:
+  case HYDRASDR_SAMPLE_INT16_REAL:
+  case HYDRASDR_SAMPLE_UINT16_REAL:
+  case HYDRASDR_SAMPLE_RAW:
+  case HYDRASDR_SAMPLE_INT8_REAL:
+  case HYDRASDR_SAMPLE_UINT8_REAL:
+  default:
+    frontend->isreal = true;
+    sdr->offset = +frontend->samprate / 4; // Positive for high-side injection (assumed)
+    break;
+  }
+  sdr->converter = config_getdouble(Dictionary,section,"converter",0);
+  frontend->calibrate = config_getdouble(Dictionary,section,"calibrate",0);
+  // Set this from bandwidth info
+  if(frontend->isreal){
+    frontend->max_IF = -600000;
+    frontend->min_IF = -0.47 * frontend->samprate;
+  } else {
+    // Complex, symmetrical
+    frontend->max_IF = 0.47 * frontend->samprate;
+    frontend->min_IF = -frontend->max_IF;
+  }
+}
+
+// fe-bench -m: the driver with libhydrasdr's transport replaced by canned transfers
+// No device, so packed 12-bit raw samples (what a current RFOne delivers), no gain and no software AGC
+int hydrasdr_mock_setup(struct frontend * const frontend,dictionary const * const Dictionary,char const * const section){
+  assert(Dictionary != NULL);
+  struct sdrstate * const sdr = calloc(1,sizeof(struct sdrstate));
+  assert(sdr != NULL);
+  sdr->frontend = frontend;
+  frontend->context = sdr;
+  sdr->sample_type = HYDRASDR_SAMPLE_RAW;
+  frontend->bitspersample = 12;
+  set_format(sdr,Dictionary,section,20e6); // nominal; hydrasdr_setup() takes the first rate the device lists
+  sdr->software_agc = false;
+  frontend->rf_level_cal = NAN;
+  strlcpy(frontend->description,"HydraSDR mock",sizeof(frontend->description));
+  sdr->scale = scale_AD(frontend);
+  return 0;
+}
+
+// Pack 'count' samples (+/-1 = full scale, count a multiple of 8) into one raw transfer as libhydrasdr would deliver it
+// libhydrasdr has no failed transfers, so samples == NULL gives NULL. Transfer and samples are one block; free() it
+void *hydrasdr_mock_transfer(struct frontend * const frontend,float const * const samples,int const count){
+  if(samples == NULL)
+    return NULL;
+  assert((count % 8) == 0);
+  hydrasdr_transfer * const transfer = calloc(1,sizeof(*transfer) + count * 3 / 2); // 12 bits/sample
+  assert(transfer != NULL);
+  transfer->ctx = frontend->context;
+  transfer->samples = transfer + 1;
+  transfer->sample_count = count;
+  transfer->sample_type = HYDRASDR_SAMPLE_RAW;
+  int * const codes = malloc(count * sizeof(int));
+  assert(codes != NULL);
+  for(int i=0; i < count; i++)
+    codes[i] = mock_ad_code(samples[i],12);
+  airspy_pack(transfer->samples,codes,count);
+  free(codes);
+  return transfer;
+}
+
+void hydrasdr_mock_callback(void * const transfer){
+  rx_callback((hydrasdr_transfer *)transfer);
+}
+
 int hydrasdr_startup(struct frontend * const frontend){
   struct sdrstate * const sdr = (struct sdrstate *)frontend->context;
   while(true){
@@ -273,4 +273,16 @@ static inline uint8_t *export_f16_be(uint8_t *out,float const *in, size_t count)
 }
 #endif
 #endif
+
+// Vectorized versions with run time CPU dispatch, in export.c
+uint8_t *export_s16_be_vec(uint8_t *out,float const *in,size_t count);
+uint8_t *export_s16_le_vec(uint8_t *out,float const *in,size_t count);
+uint8_t *export_f32_be_vec(uint8_t *out,float const *in,size_t count);
+uint8_t *export_f32_le_vec(uint8_t *out,float const *in,size_t count);
+#ifdef HAS_FLOAT16
+uint8_t *export_f16_be_vec(uint8_t *out,float const *in,size_t count);
+uint8_t *export_f16_le_vec(uint8_t *out,float const *in,size_t count);
+#endif
+uint8_t *export_mulaw_vec(uint8_t *out,float const *in,size_t count);
+uint8_t *export_alaw_vec(uint8_t *out,float const *in,size_t count);
 #endif
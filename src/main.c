@@ -195,9 +195,10 @@ static void closedown(int a){
 
   ssize_t r = write(2,message,strlen(message));
   (void)r; // shut up compiler
-  extern struct frontend Frontend;
-  if(Frontend.shutdown)
-    (*Frontend.shutdown)(&Frontend);
+  for(int i = 0; i < Nfrontends; i++){
+    if(Frontends[i]->shutdown)
+      (*Frontends[i]->shutdown)(Frontends[i]);
+  }
   sleep(1); // pause for threads to see it
   _exit(a == SIGTERM ? EX_OK : EX_SOFTWARE); // Success when terminated by systemd
 }
@@ -79,7 +79,7 @@ void decode_stdin(){
   ssize_t length = read(STDIN_FILENO,buffer,PKTSIZE);
   if (length>0){
     enum pkt_type const cr = buffer[0]; // Command/response byte
-    fprintf(stdout," %s", cr == STATUS ? "STAT" : "CMD");
+    fprintf(stdout," %s", cr == STATUS ? "STAT" : cr == STATUS_DELTA ? "DELTA" : cr == HISTORY ? "HIST" : cr == SIGNALS ? "SIGS" : "CMD");
     dump_metadata(stdout,buffer+1,length-1,Newline);
     fflush(stdout);
   }
@@ -271,8 +271,8 @@ void *input_thread(void *p){
     char temp[1024];
     fprintf(stdout,"%s %s", format_gpstime(temp,sizeof(temp),now), formatsock(&source,true));
     enum pkt_type const cr = buffer[0]; // Command/response byte
-    fprintf(stdout," %s", cr == STATUS ? "STAT" : "CMD");
-    if(cr == STATUS){
+    fprintf(stdout," %s", cr == STATUS ? "STAT" : cr == STATUS_DELTA ? "DELTA" : cr == HISTORY ? "HIST" : cr == SIGNALS ? "SIGS" : "CMD");
+    if(cr == STATUS || cr == STATUS_DELTA){
       Status_packets++; // Don't count our own responses
       Last_status_time = now; // Reset poll timeout
     }
@@ -96,6 +96,7 @@ char const *Channel_keys[] = {
   "beam",
   "bitrate",
   "buffer",
+  "bundle",
   "channels",
   "conj",
   "ctcss",
@@ -132,7 +133,9 @@ char const *Channel_keys[] = {
   "freq7",
   "freq8",
   "freq9",
+  "frontend",
   "gain",
+  "gso",
   "hang-time",
   "headroom",
   "high",
@@ -170,6 +173,7 @@ char const *Channel_keys[] = {
   "squelch-open",
   "squelch-tail",
   "squelchtail",
+  "status-refresh",
   "stereo",
   "threshold-extend",
   "threshold",
@@ -219,14 +223,17 @@ int set_defaults(chan_t *chan){
   chan->prio = default_prio();
 
   chan->status.output_interval = DEFAULT_UPDATE;
+  chan->status.refresh = 0;
 
   chan->output.gain = dB2voltage(DEFAULT_GAIN);
   chan->output.headroom = dB2voltage(DEFAULT_HEADROOM);
   chan->output.ttl = DEFAULT_TTL;
   chan->output.pacing = false;
+  chan->output.gso = false;
+  chan->output.bundle = false;
   chan->output.maxdelay = 0;  // No output buffering
   chan->output.queue = NULL;
-  chan->output.queue_length = 0;
+  chan->output.queue_length = chan->output.queue_size = 0;
   chan->output.silent = true; // Prevent burst of FM status messages on output channel at startup
   chan->output.samprate = round_samprate(DEFAULT_LINEAR_SAMPRATE); // Don't trust even a compile constant
   chan->output.encoding = S16BE;
@@ -303,6 +310,21 @@ int set_defaults(chan_t *chan){
   chan->spectrum.shape = DEFAULT_SPECTRUM_KAISER_BETA;
   chan->spectrum.window = NULL;
   chan->spectrum.plan = NULL;
+  chan->spectrum.engine = NULL;
+  chan->spectrum.avg = NULL;
+  chan->spectrum.tap = false;
+  chan->spectrum.direct = false;
+  chan->spectrum.ring_count = 0;
+  chan->spectrum.occupancy = NULL;
+  chan->spectrum.occupancy_threshold = 0;
+  chan->spectrum.occupancy_interval = 0;
+  chan->spectrum.history = NULL;
+  chan->spectrum.history_rows = 0;
+  chan->spectrum.history_start = chan->spectrum.history_end = 0;
+  chan->spectrum.detector = DETECT_AVERAGE;
+  chan->spectrum.percentile = 50;
+  chan->spectrum.hold = NULL;
+  chan->spectrum.hold_freq = NAN;
   chan->spectrum.bin_data = NULL;
   chan->spectrum.base = -150; // dB == value 0
   chan->spectrum.step = 0.5;  // dB/step
@@ -476,6 +498,8 @@ int loadpreset(chan_t *chan,dictionary const *table,char const *sname){
       chan->fm.tone_freq = tone;
   }
   chan->output.pacing = config_getboolean(table,sname,"pacing",chan->output.pacing);
+  chan->output.gso = config_getboolean(table,sname,"gso",chan->output.gso);
+  chan->output.bundle = config_getboolean(table,sname,"bundle",chan->output.bundle);
   {
     int bitrate = abs(config_getint(table,sname,"bitrate",chan->opus.bitrate));
     bitrate = abs(config_getint(table,sname,"opus-bitrate",bitrate));
@@ -523,6 +547,7 @@ int loadpreset(chan_t *chan,dictionary const *table,char const *sname){
     }
   }
   chan->status.output_interval = abs(config_getint(table,sname,"update",chan->status.output_interval));
+  chan->status.refresh = abs(config_getint(table,sname,"status-refresh",chan->status.refresh));
   {
     int maxdelay = abs(config_getint(table,sname,"buffer",chan->output.maxdelay));
     if(maxdelay > 4)
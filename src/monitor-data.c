@@ -80,6 +80,10 @@ void *dataproc(void *arg){
     pthread_exit(NULL);
 
   struct packet *pkt = NULL;
+  uint8_t buffer[PKTSIZE];
+  int offset = 0;    // Next packet in buffer
+  ssize_t bufsize = 0;
+  struct sockaddr_storage sender;  // of the bundle too
 
   realtime(default_prio());
   // Main loop begins here
@@ -92,15 +96,28 @@ void *dataproc(void *arg){
     pkt->data = NULL;
     pkt->len = 0;
 
-    struct sockaddr_storage sender;
-    socklen_t socksize = sizeof(sender);
-    ssize_t size = recvfrom(input_fd,&pkt->content,sizeof(pkt->content),0,(struct sockaddr *)&sender,&socksize);
-    if(size == -1){
-      if(errno != EINTR){ // Happens routinely, e.g., when window resized
-	perror("recvfrom");
-	usleep(1000);
+    ssize_t size;
+    uint8_t const *bp;
+    if((size = next_rtp(buffer,bufsize,&offset,&bp)) > 0){
+      // Next one from a bundle
+      memcpy(pkt->content,bp,size);
+    } else {
+      socklen_t socksize = sizeof(sender);
+      size = recvfrom(input_fd,&pkt->content,sizeof(pkt->content),0,(struct sockaddr *)&sender,&socksize);
+      if(size == -1){
+	if(errno != EINTR){ // Happens routinely, e.g., when window resized
+	  perror("recvfrom");
+	  usleep(1000);
+	}
+	continue;  // Reuse current buffer
+      }
+      if(size >= RTP_BUNDLE_HDR && pkt->content[0] == RTP_BUNDLE_MAGIC0 && pkt->content[1] == RTP_BUNDLE_MAGIC1){
+	// RTP packets from several channels, each needs its own buffer
+	memcpy(buffer,pkt->content,size);
+	bufsize = size;
+	offset = 0;
+	continue;
       }
-      continue;  // Reuse current buffer
     }
     if(size <= RTP_MIN_SIZE)
       continue; // Must be big enough for RTP header and at least some data
@@ -205,11 +222,6 @@ static void decode_task_cleanup(void *arg){
   // Just in case anything was allocated for these arrays
   chan_t * const chan = &sp->chan;
   FREE(chan->spectrum.bin_data);
-  for(int i=0; i < CQLEN; i++){
-    FREE(chan->commands[i].buffer);
-    chan->commands[i].length = 0;
-  }
-  FREE(chan->spectrum.window);
   FREE(chan->spectrum.plan);
   FREE(chan->spectrum.ring);
   FREE(sp->buffer);
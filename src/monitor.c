@@ -502,7 +502,7 @@ void *statproc(void *arg){
     if(length < 0)
       fprintf(stderr,"recvfrom status: %s\n",strerror(errno));
 
-    if(length < 3 || buffer[0] != STATUS) // not status, ignore
+    if(length < 3 || (buffer[0] != STATUS && buffer[0] != STATUS_DELTA)) // not status, ignore
       continue;
 
     // Extract just the SSRC to see if the session exists
@@ -0,0 +1,609 @@
+// Network IQ front end - takes an RTP IQ stream from another host (e.g., another radiod) as radiod's input
+// Copyright 2026, Phil Karn, KA9Q
+#include <assert.h>
+#include <complex.h>
+#include <math.h>
+#include <pthread.h>
+#include <errno.h>
+#include <iniparser/iniparser.h>
+#include <string.h>
+#if defined(linux)
+#include <bsd/string.h>
+#endif
+#include <stdlib.h>
+#include <strings.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include "misc.h"
+#include "multicast.h"
+#include "rtp.h"
+#include "import.h"
+#include "status.h"
+#include "radio.h"
+#include "config.h"
+#include "sched.h"
+
+extern int Verbose;
+extern char const *Description;
+
+static double Power_alpha = 0.05; // Calculate this properly someday
+
+#define VLEN 64            // Packets per recvmmsg() call (Linux; elsewhere one per recv())
+#define NETIQ_BUFSIZE 9216 // Big enough for a jumbo frame
+#define RESEQ 64           // Size of resequencing queue, packets
+#define CLOCK_INTERVAL 10  // Seconds between sender clock rate estimates
+
+static char const *Netiq_keys[] = {
+  "data",
+  "description",
+  "device",
+  "encoding",
+  "channels",
+  "frequency",
+  "iface",
+  "library",
+  "max-gap",
+  "reorder",
+  "samprate",
+  "source",
+  "ssrc",
+  "timeout",
+  NULL
+};
+
+enum state {
+  STOPPED,
+  STARTING,
+  STOPPING,
+  RUNNING
+};
+
+struct reseq {
+  bool inuse;
+  struct rtp_header rtp;
+  int size; // bytes of payload
+  uint8_t data[NETIQ_BUFSIZE];
+};
+
+struct sdrstate {
+  struct frontend *frontend;
+  int data_fd;
+  int status_fd;
+  uint32_t ssrc;           // Stream we're following
+  int type;                // RTP payload type
+  enum encoding encoding;
+  int channels;            // 1 = real, 2 = complex (I/Q)
+  int framesize;           // bytes per sample (all channels)
+  int reorder;             // Max packets to wait for a missing one
+  long max_gap;            // Largest gap, samples, to zero-fill before just resynchronizing
+  double scale;
+
+  struct rtp_state rtp_state;
+  uint32_t next_timestamp; // Expected RTP timestamp of next sample to be written
+  struct reseq *reseq;     // Resequencing queue, RESEQ entries
+
+  // Statistics
+  uint64_t drops;          // Packets lost
+  uint64_t late;           // Packets arriving after we've given up on them, or duplicates
+  uint64_t resyncs;        // Timestamp jumps too big to fill
+  uint64_t fill;           // Samples of zeroes inserted for lost packets
+
+  // Sender clock tracking
+  int64_t clock_ref_time;  // Local time of reference point, ns
+  uint64_t clock_ref_samples; // frontend->samples at reference point
+
+  pthread_t proc_thread;
+  _Atomic enum state state;
+};
+
+double netiq_tune(struct frontend * const frontend,double const freq);
+static void *proc_netiq(void *arg);
+
+// Bytes per sample of one channel, 0 if unsupported
+static int sample_size(enum encoding encoding){
+  switch(encoding){
+  case F32LE:
+  case F32BE:
+    return sizeof(float);
+  case S16LE:
+  case S16BE:
+    return sizeof(int16_t);
+#ifdef HAS_FLOAT16
+  case F16LE:
+  case F16BE:
+    return sizeof(float16_t);
+#endif
+  default:
+    return 0;
+  }
+}
+
+// Get stream parameters from a radiod status packet for our SSRC
+// Returns 0 when the stream is described, -1 otherwise
+static int process_status(struct sdrstate *sdr,uint8_t const *buffer,int length){
+  if(length < 2 || (enum pkt_type)buffer[0] != STATUS)
+    return -1;
+  chan_t * const chan = calloc(1,sizeof *chan); // big, keep off the stack
+  struct frontend * const fe = calloc(1,sizeof *fe);
+  assert(chan != NULL && fe != NULL);
+  decode_radio_status(fe,chan,buffer+1,length-1);
+  int r = -1;
+  if(chan->output.rtp.ssrc == sdr->ssrc && chan->output.samprate != 0){
+    struct frontend * const frontend = sdr->frontend;
+    if(frontend->samprate == 0)
+      frontend->samprate = chan->output.samprate;
+    if(sdr->encoding == NO_ENCODING)
+      sdr->encoding = chan->output.encoding;
+    if(sdr->channels == 0)
+      sdr->channels = chan->output.channels;
+    if(frontend->frequency == 0 && !isnan(chan->tune.freq))
+      frontend->frequency = chan->tune.freq;
+    sdr->type = chan->output.rtp.type;
+    r = 0;
+  }
+  free(chan);
+  free(fe);
+  return r;
+}
+
+int netiq_setup(struct frontend * const frontend, dictionary const * const dictionary, char const * const section){
+  assert(dictionary != NULL);
+  {
+    char const * const device = config_getstring(dictionary,section,"device",section);
+    if(strcasecmp(device,"netiq") != 0)
+      return -1; // Not for us
+  }
+  config_validate_section(stderr,dictionary,section,Netiq_keys,NULL);
+
+  // Cross-link generic and hardware-specific control structures
+  struct sdrstate * const sdr = calloc(1,sizeof *sdr);
+  assert(sdr != NULL);
+  sdr->frontend = frontend;
+  frontend->context = sdr;
+  sdr->data_fd = sdr->status_fd = -1;
+
+  char const * const data = config_getstring(dictionary,section,"data",NULL);
+  if(data == NULL){
+    fprintf(stderr,"netiq: 'data = ' must specify the IQ multicast stream\n");
+    return -1;
+  }
+  {
+    char const * const p = config_getstring(dictionary,section,"ssrc",NULL);
+    if(p != NULL)
+      sdr->ssrc = strtoul(p,NULL,0);
+  }
+  {
+    char const * const p = config_getstring(dictionary,section,"samprate",NULL);
+    if(p != NULL)
+      frontend->samprate = parse_frequency(p,false);
+  }
+  {
+    char const * const p = config_getstring(dictionary,section,"encoding",NULL);
+    sdr->encoding = p != NULL ? parse_encoding(p) : NO_ENCODING;
+  }
+  sdr->channels = config_getint(dictionary,section,"channels",0);
+  {
+    char const * const p = config_getstring(dictionary,section,"frequency",NULL);
+    if(p != NULL)
+      frontend->frequency = parse_frequency(p,false);
+  }
+  sdr->reorder = config_getint(dictionary,section,"reorder",8);
+  if(sdr->reorder < 1 || sdr->reorder >= RESEQ)
+    sdr->reorder = 8;
+  double const max_gap = config_getdouble(dictionary,section,"max-gap",1.0); // seconds
+  double const timeout = config_getdouble(dictionary,section,"timeout",10.0); // seconds to wait for the stream
+
+  struct sockaddr_storage source_sock = {0};
+  char const * const source = config_getstring(dictionary,section,"source",NULL);
+  if(source != NULL)
+    resolve_mcast(source,&source_sock,0,NULL,0,0);
+  {
+    struct sockaddr_storage sock;
+    char iface[1024] = {0};
+    resolve_mcast(data,&sock,DEFAULT_RTP_PORT,iface,sizeof iface,0);
+    char const * const ifp = config_getstring(dictionary,section,"iface",strlen(iface) > 0 ? iface : NULL);
+    sdr->data_fd = listen_mcast(source != NULL ? &source_sock : NULL,&sock,ifp);
+    resolve_mcast(data,&sock,DEFAULT_STAT_PORT,iface,sizeof iface,0);
+    sdr->status_fd = listen_mcast(source != NULL ? &source_sock : NULL,&sock,ifp);
+  }
+  if(sdr->data_fd == -1){
+    fprintf(stderr,"netiq: can't listen to %s: %s\n",data,strerror(errno));
+    return -1;
+  }
+  {
+    int n = 1 << 24; // 16 MB; a wideband stream can't afford drops during scheduling hiccups
+    if(setsockopt(sdr->data_fd,SOL_SOCKET,SO_RCVBUF,&n,sizeof n) == -1)
+      perror("netiq setsockopt SO_RCVBUF");
+  }
+  // Wait for the first data packet to find the SSRC (if not given) and payload type,
+  // then for a status packet from the sender if we still don't know the format
+  int64_t const deadline = gps_time_ns() + llrint(timeout * BILLION);
+  bool have_data = false;
+  bool described = false;
+  while(gps_time_ns() < deadline){
+    struct pollfd pfd[2] = {
+      { .fd = sdr->data_fd, .events = POLLIN },
+      { .fd = sdr->status_fd, .events = POLLIN },
+    };
+    if(poll(pfd,sdr->status_fd != -1 ? 2 : 1,100) <= 0)
+      continue;
+    uint8_t buffer[PKTSIZE];
+    if(!have_data && (pfd[0].revents & POLLIN)){
+      ssize_t const size = recv(sdr->data_fd,buffer,sizeof buffer,0);
+      if(size < RTP_MIN_SIZE)
+	continue;
+      struct rtp_header rtp;
+      ntoh_rtp(&rtp,buffer);
+      if(sdr->ssrc != 0 && rtp.ssrc != sdr->ssrc)
+	continue;
+      sdr->ssrc = rtp.ssrc;
+      sdr->type = rtp.type;
+      have_data = true;
+      // A static payload type may be enough
+      if(frontend->samprate == 0 && samprate_from_pt(rtp.type) != 0)
+	frontend->samprate = samprate_from_pt(rtp.type);
+      if(sdr->encoding == NO_ENCODING)
+	sdr->encoding = encoding_from_pt(rtp.type);
+      if(sdr->channels == 0)
+	sdr->channels = channels_from_pt(rtp.type);
+    }
+    if(pfd[1].revents & POLLIN){
+      ssize_t const size = recv(sdr->status_fd,buffer,sizeof buffer,0);
+      if(sdr->ssrc != 0 && size > 0 && process_status(sdr,buffer,size) == 0)
+	described = true;
+    }
+    if(have_data && (described || (frontend->samprate != 0 && sdr->encoding != NO_ENCODING && sdr->channels != 0)))
+      break;
+  }
+  if(sdr->status_fd != -1){
+    close(sdr->status_fd); // Only needed to learn the stream format
+    sdr->status_fd = -1;
+  }
+  if(!have_data){
+    fprintf(stderr,"netiq: no data from %s in %.1lf sec\n",data,timeout);
+    return -1;
+  }
+  if(frontend->samprate == 0 || sdr->channels < 1 || sdr->channels > 2){
+    fprintf(stderr,"netiq: can't determine format of ssrc %u payload type %d; set samprate, channels and encoding\n",
+	    sdr->ssrc,sdr->type);
+    return -1;
+  }
+  if(sample_size(sdr->encoding) == 0){
+    fprintf(stderr,"netiq: unsupported encoding %s\n",encoding_string(sdr->encoding));
+    return -1;
+  }
+  sdr->framesize = sdr->channels * sample_size(sdr->encoding);
+  sdr->max_gap = lrint(max_gap * frontend->samprate);
+
+  frontend->isreal = (sdr->channels == 1);
+  frontend->bitspersample = 1; // Input is converted to floating point in the +/-1 range
+  frontend->rf_gain = NAN;
+  frontend->rf_atten = NAN;
+  frontend->rf_level_cal = NAN;
+  frontend->lock = true; // We can't tune the sender
+  if(frontend->isreal){
+    frontend->min_IF = 0;
+    frontend->max_IF = 0.5 * frontend->samprate;
+  } else {
+    frontend->min_IF = -0.5 * frontend->samprate;
+    frontend->max_IF = +0.5 * frontend->samprate;
+  }
+  {
+    char const * const p = config_getstring(dictionary,section,"description",Description ? Description : "network IQ");
+    if(p != NULL){
+      strlcpy(frontend->description,p,sizeof(frontend->description));
+      Description = p;
+    }
+  }
+  sdr->reseq = calloc(RESEQ,sizeof *sdr->reseq);
+  assert(sdr->reseq != NULL);
+
+  fprintf(stderr,"netiq %s: %s ssrc %u pt %d, samprate %'.0lf Hz, %s, encoding %s, frequency %'.3lf Hz, reorder %d pkts\n",
+	  frontend->description,data,sdr->ssrc,sdr->type,frontend->samprate,
+	  frontend->isreal ? "real" : "complex",encoding_string(sdr->encoding),frontend->frequency,sdr->reorder);
+  return 0;
+}
+
+int netiq_startup(struct frontend * const frontend){
+  assert(frontend != NULL);
+  struct sdrstate * const sdr = (struct sdrstate *)frontend->context;
+  assert(sdr != NULL);
+  while(true){
+    enum state s = STOPPED;
+    if(atomic_compare_exchange_strong(&sdr->state,&s,STARTING))
+      break;
+    if(s == RUNNING)
+      return 0; // Already running
+    usleep(10000); // 10 ms
+  }
+  sdr->scale = scale_AD(frontend);
+  pthread_create(&sdr->proc_thread,NULL,proc_netiq,sdr);
+  atomic_store(&sdr->state,RUNNING);
+  fprintf(stderr,"netiq running\n");
+  return 0;
+}
+
+int netiq_shutdown(struct frontend * const frontend){
+  assert(frontend != NULL);
+  struct sdrstate * const sdr = (struct sdrstate *)frontend->context;
+  assert(sdr != NULL);
+  while(true){
+    enum state s = RUNNING;
+    if(atomic_compare_exchange_strong(&sdr->state,&s,STOPPING))
+      break;
+    if(s == STOPPED)
+      return 0; // Already stopped
+    usleep(10000); // 10 ms
+  }
+  pthread_join(sdr->proc_thread,NULL);
+  atomic_store(&sdr->state,STOPPED);
+  fprintf(stderr,"netiq stopped (%'llu drops, %'llu late, %'llu resyncs, %'llu samples filled)\n",
+	  (unsigned long long)sdr->drops,(unsigned long long)sdr->late,
+	  (unsigned long long)sdr->resyncs,(unsigned long long)sdr->fill);
+  return 0;
+}
+
+double netiq_tune(struct frontend * const frontend,double const freq){
+  (void)freq;
+  assert(frontend != NULL);
+  return frontend->frequency; // Set by the sender
+}
+
+// Hand n samples already at the input write pointer to the filter
+// Writes are limited to one block so they can't wrap the input buffer
+static void write_input(struct frontend *frontend,int n){
+  if(frontend->isreal)
+    write_rfilter(&frontend->in,NULL,n);
+  else
+    write_cfilter(&frontend->in,NULL,n);
+}
+
+// Insert n samples of zeroes for lost data
+static void zero_fill(struct sdrstate *sdr,long n){
+  struct frontend * const frontend = sdr->frontend;
+  sdr->fill += n;
+  while(n > 0){
+    int const chunk = min(n,(long)frontend->L);
+    if(frontend->isreal)
+      memset(frontend->in.input_write_pointer.r,0,chunk * sizeof(float));
+    else
+      memset(frontend->in.input_write_pointer.c,0,chunk * sizeof(float complex));
+    write_input(frontend,chunk);
+    frontend->samples += chunk;
+    n -= chunk;
+  }
+}
+
+// Convert one packet payload to float at the filter input and run the filter
+static void emit(struct sdrstate *sdr,struct rtp_header const *rtp,uint8_t const *payload,int size){
+  struct frontend * const frontend = sdr->frontend;
+  int const samples = size / sdr->framesize;
+  if(samples <= 0)
+    return;
+
+  // The sender's RTP clock is the sample clock; place this packet by its timestamp
+  int32_t const gap = (int32_t)(rtp->timestamp - sdr->next_timestamp);
+  if(gap > 0 && gap <= sdr->max_gap){
+    zero_fill(sdr,gap);
+  } else if(gap != 0){
+    // Sender restart or a huge outage; just pick up where it is now
+    sdr->resyncs++;
+    if(Verbose)
+      fprintf(stderr,"netiq: ssrc %u timestamp jump %'d samples, resync\n",sdr->ssrc,gap);
+  }
+  sdr->next_timestamp = rtp->timestamp + samples;
+
+  double in_energy = 0;
+  int done = 0;
+  while(done < samples){
+    int const chunk = min(samples - done,frontend->L);
+    uint8_t const * const dp = payload + done * sdr->framesize;
+    int const count = chunk * sdr->channels; // individual floats
+    float * const wptr = frontend->isreal ? frontend->in.input_write_pointer.r : (float *)frontend->in.input_write_pointer.c;
+    switch(sdr->encoding){
+    case F32LE:
+      import_f32_le(wptr,dp,count);
+      break;
+    case F32BE:
+      import_f32_be(wptr,dp,count);
+      break;
+    case S16LE:
+      import_s16_le(wptr,dp,count);
+      break;
+    case S16BE:
+      import_s16_be(wptr,dp,count);
+      break;
+#ifdef HAS_FLOAT16
+    case F16LE:
+      import_f16_le(wptr,dp,count);
+      break;
+    case F16BE:
+      import_f16_be(wptr,dp,count);
+      break;
+#endif
+    default:
+      return; // Can't happen, checked in setup
+    }
+    float const scale = sdr->scale;
+    float energy = 0;
+    for(int i=0; i < count; i++){
+      energy += wptr[i] * wptr[i];
+      wptr[i] *= scale;
+    }
+    in_energy += energy;
+    write_input(frontend,chunk);
+    done += chunk;
+  }
+  frontend->samples += samples;
+  if(isfinite(in_energy))
+    frontend->if_power += Power_alpha * (in_energy / samples - frontend->if_power);
+}
+
+// Process everything in order that's waiting on the resequencing queue
+static void drain(struct sdrstate *sdr){
+  while(true){
+    struct reseq * const qp = &sdr->reseq[sdr->rtp_state.seq % RESEQ];
+    if(!qp->inuse || qp->rtp.seq != sdr->rtp_state.seq)
+      break;
+    emit(sdr,&qp->rtp,qp->data,qp->size);
+    qp->inuse = false;
+    sdr->rtp_state.seq++;
+  }
+}
+
+// Give up on the missing packet(s) at the head of the queue; skip to the oldest one we have
+static void skip_missing(struct sdrstate *sdr){
+  for(int i=1; i < RESEQ; i++){
+    uint16_t const seq = sdr->rtp_state.seq + i;
+    struct reseq const * const qp = &sdr->reseq[seq % RESEQ];
+    if(qp->inuse && qp->rtp.seq == seq){
+      sdr->drops += i;
+      sdr->rtp_state.seq = seq;
+      return; // emit() will zero-fill from the timestamp gap
+    }
+  }
+}
+
+static void process_packet(struct sdrstate *sdr,uint8_t const *buffer,int size){
+  if(size < RTP_MIN_SIZE)
+    return;
+  struct rtp_header rtp;
+  uint8_t const *dp = ntoh_rtp(&rtp,buffer);
+  if(rtp.pad){
+    size -= buffer[size-1];
+    rtp.pad = 0;
+  }
+  size -= (dp - buffer);
+  if(size <= 0 || rtp.ssrc != sdr->ssrc)
+    return;
+  if(rtp.type != sdr->type)
+    return; // Sender changed format; we can't follow without a restart
+
+  sdr->rtp_state.packets++;
+  sdr->rtp_state.bytes += size;
+  if(!sdr->rtp_state.init){
+    sdr->rtp_state.seq = rtp.seq;
+    sdr->next_timestamp = rtp.timestamp;
+    sdr->rtp_state.init = true;
+  }
+  int16_t const seqdiff = rtp.seq - sdr->rtp_state.seq;
+  if(seqdiff < 0){
+    sdr->late++;
+    return;
+  }
+  if(seqdiff == 0){
+    // The usual case: in order, no copy
+    emit(sdr,&rtp,dp,size);
+    sdr->rtp_state.seq++;
+    drain(sdr);
+    return;
+  }
+  if(seqdiff >= RESEQ){
+    // Way ahead: sender restart or a long outage. Flush the queue and start over here
+    for(int i=0; i < RESEQ; i++)
+      sdr->reseq[i].inuse = false;
+    sdr->drops += seqdiff;
+    sdr->rtp_state.seq = rtp.seq;
+    emit(sdr,&rtp,dp,size);
+    sdr->rtp_state.seq++;
+    return;
+  }
+  // Out of order; hold it until the missing packet(s) show up or we give up
+  struct reseq * const qp = &sdr->reseq[rtp.seq % RESEQ];
+  if(qp->inuse && qp->rtp.seq == rtp.seq){
+    sdr->late++; // duplicate
+    return;
+  }
+  if(size > NETIQ_BUFSIZE)
+    return;
+  qp->inuse = true;
+  qp->rtp = rtp;
+  qp->size = size;
+  memcpy(qp->data,dp,size);
+  if(seqdiff >= sdr->reorder){
+    skip_missing(sdr);
+    drain(sdr);
+  }
+}
+
+// Estimate the sender's sample clock against ours, reported as the front end calibration
+static void track_clock(struct sdrstate *sdr){
+  struct frontend * const frontend = sdr->frontend;
+  int64_t const now = gps_time_ns();
+  if(sdr->clock_ref_time == 0){
+    sdr->clock_ref_time = now;
+    sdr->clock_ref_samples = frontend->samples;
+    return;
+  }
+  int64_t const elapsed = now - sdr->clock_ref_time;
+  if(elapsed < (int64_t)CLOCK_INTERVAL * BILLION)
+    return;
+  double const rate = (double)(frontend->samples - sdr->clock_ref_samples) * BILLION / elapsed;
+  double const error = rate / frontend->samprate - 1;
+  if(fabs(error) < 0.01) // ignore startup transients, outages
+    frontend->calibrate += 0.1 * (error - frontend->calibrate);
+  if(Verbose > 1)
+    fprintf(stderr,"netiq: sender clock %'.1lf Hz (%+.3lf ppm), %'llu drops, %'llu late\n",
+	    rate,1e6 * frontend->calibrate,(unsigned long long)sdr->drops,(unsigned long long)sdr->late);
+  sdr->clock_ref_time = now;
+  sdr->clock_ref_samples = frontend->samples;
+}
+
+static void *proc_netiq(void *arg){
+  pthread_setname("proc_netiq");
+  struct sdrstate * const sdr = (struct sdrstate *)arg;
+  assert(sdr != NULL);
+
+  realtime(2 + default_prio());
+  {
+    // Wake up periodically to notice shutdown
+    struct timeval tv = { .tv_sec = 0, .tv_usec = 100000 };
+    if(setsockopt(sdr->data_fd,SOL_SOCKET,SO_RCVTIMEO,&tv,sizeof tv) == -1)
+      perror("netiq setsockopt SO_RCVTIMEO");
+  }
+  uint8_t (*buffers)[NETIQ_BUFSIZE] = malloc(VLEN * sizeof *buffers);
+  assert(buffers != NULL);
+#ifdef __linux__
+  struct iovec iov[VLEN];
+  struct mmsghdr msgs[VLEN];
+  for(int i=0; i < VLEN; i++){
+    iov[i].iov_base = buffers[i];
+    iov[i].iov_len = sizeof buffers[i];
+    memset(&msgs[i],0,sizeof msgs[i]);
+    msgs[i].msg_hdr.msg_iov = &iov[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+#endif
+  enum state s;
+  while((s = atomic_load(&sdr->state)) == RUNNING || s == STARTING){
+#ifdef __linux__
+    // Block for the first packet, then take whatever else is already queued
+    int const n = recvmmsg(sdr->data_fd,msgs,VLEN,MSG_WAITFORONE,NULL);
+#else
+    // One packet per call
+    ssize_t const received = recv(sdr->data_fd,buffers[0],sizeof buffers[0],0);
+    int const n = received < 0 ? -1 : 1;
+#endif
+    if(n < 0){
+      if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR){
+	fprintf(stderr,"netiq recv: %s\n",strerror(errno));
+	usleep(100000);
+      }
+      continue;
+    }
+    for(int i=0; i < n; i++){
+#ifdef __linux__
+      process_packet(sdr,buffers[i],msgs[i].msg_len);
+#else
+      process_packet(sdr,buffers[i],received);
+#endif
+    }
+    track_clock(sdr);
+  }
+  FREE(buffers);
+  return NULL;
+}
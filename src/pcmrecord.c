@@ -213,6 +213,7 @@ static void closedown(int a);
 static void input_loop(void);
 static void process_status(int);
 static void process_data(int);
+static void process_rtp(struct sockaddr const *sender,uint8_t const *buffer,ssize_t size);
 static void scan_sessions(void);
 
 static void cleanup(void);
@@ -606,6 +607,16 @@ static void process_data(int fd){
     }
   }
 #endif
+  // Might be a bundle of RTP packets from several channels
+  int offset = 0;
+  uint8_t const *pkt;
+  int len;
+  while((len = next_rtp(buffer,size,&offset,&pkt)) > 0)
+    process_rtp(&sender,pkt,len);
+}
+
+// Process one RTP packet
+static void process_rtp(struct sockaddr const *sender,uint8_t const *buffer,ssize_t size){
   if(size < RTP_MIN_SIZE)
     return; // Too small for RTP, ignore
 
@@ -629,8 +640,8 @@ static void process_data(int fd){
   for(sp = Sessions;sp != NULL;sp=sp->next){
     if(sp->ssrc == rtp.ssrc
        && sp->type == rtp.type
-       && address_match(&sp->sender,&sender)
-       && getportnumber(&sp->sender) == getportnumber(&sender))
+       && address_match(&sp->sender,sender)
+       && getportnumber(&sp->sender) == getportnumber(sender))
       break;
   }
   // If a matching session is not found, drop packet and wait for first status packet to create it
@@ -654,7 +665,7 @@ static void process_data(int fd){
     int64_t sender_time = sp->chan.clocktime + (int64_t)BILLION * (UNIX_EPOCH - GPS_UTC_OFFSET);
     sender_time += (int64_t)BILLION * (int32_t)(rtp.timestamp - sp->chan.output.time_snap) / sp->samprate;
 
-    if(session_file_init(sp,&sender,sender_time) != 0)
+    if(session_file_init(sp,sender,sender_time) != 0)
       return;
 
     if(sp->encoding == OPUS || sp->encoding == OPUS_VOIP){
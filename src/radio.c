@@ -44,6 +44,7 @@
 
 #define DEFAULT_PRESET "am"
 #define GLOBAL "global"
+#define BLOCKTIME_TOLERANCE 10e-6 // Front ends' block times may differ by this fraction
 
 #ifndef PKGLIBDIR
 #define PKGLIBDIR "/usr/local/lib/ka9q-radio"
@@ -54,7 +55,6 @@
 #endif
 
 static int Total_channels;
-static void *Dl_handle;
 static int const DEFAULT_IP_TOS = 46 << 2; // Expedited Forwarding
 static double const DEFAULT_BLOCKTIME = .02; // 20 ms
 static char const *Metadata_dest_string; // DNS name of default multicast group for status/commands
@@ -83,18 +83,22 @@ struct frontend Frontend = {
   .status_mutex = PTHREAD_MUTEX_INITIALIZER,
   .status_cond = PTHREAD_COND_INITIALIZER,
 };
+// Additional front ends share the FFT workers, output sockets and status channel with the first
+struct frontend *Frontends[MAX_FRONTENDS] = { &Frontend };
+int Nfrontends = 0;
 
  // Template containing compiled-in defaults and global parameters
 chan_t Template;
 pthread_mutex_t Channel_list_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_mutex_t Freq_mutex = PTHREAD_MUTEX_INITIALIZER;
-static int Active_channel_count = 0;
 
 // List of valid config keys in [global] section, for error checking
 static char const *Global_keys[] = {
   "advertise",
   "affinity",
+  "batch-output",
   "blocktime",
+  "bundle-size",
   "data",
   "dc-cut",
   "description",
@@ -107,6 +111,7 @@ static char const *Global_keys[] = {
   "lifetime",
   "mode-file",
   "mode",
+  "opus-threads",
   "overlap",
   "preset",
   "presets-file",
@@ -116,6 +121,7 @@ static char const *Global_keys[] = {
   "static",
   "status",
   "tos",
+  "txtime",
   "ttl",
   "update",
   "verbose",
@@ -139,7 +145,7 @@ int Ctl_fd = -1;     // File descriptor for receiving user commands
 
 extern char const *Name;     // owned by main.c
 static double estimate_noise(chan_t *chan,int shift);// Noise estimator tuning
-static int setup_hardware(char const *sname);
+static int setup_hardware(struct frontend *frontend,char const *sname);
 static void *process_section(void *p);
 static void *sap_send(void *p);
 static void *rtcp_send(void *p);
@@ -397,6 +403,36 @@ int loadconfig(char const *file){
     if(Output_fd < 0 || Output_fd0 < 0)
       exit(EX_NOHOST); // let systemd restart us
   }
+  {
+    int const n = config_getint(Configtable,GLOBAL,"opus-threads",0);
+    if(n > 0 && start_opus_pool(n) != 0)
+      fprintf(stderr,"can't start Opus encoder pool, encoding in channel threads\n");
+  }
+  Bundle_size = config_getint(Configtable,GLOBAL,"bundle-size",Bundle_size);
+  if(Bundle_size < 512 || Bundle_size > 65000){
+    fprintf(stderr,"bundle-size = %d out of range 512-65000, using 8972\n",Bundle_size);
+    Bundle_size = 8972;
+  }
+  Batch_output = config_getboolean(Configtable,GLOBAL,"batch-output",false);
+  if(Batch_output && start_output_sender() != 0){
+    fprintf(stderr,"can't start batched output sender, using per-packet sends\n");
+    Batch_output = false;
+  }
+  {
+    // Kernel pacing for channels with 'pacing' set; needs the ETF or fq qdisc on the output interface
+    char const *txtime = config_getstring(Configtable,GLOBAL,"txtime",NULL);
+    if(txtime != NULL){
+      int const fd = output_mcast(&Frontend.metadata_dest_socket, Iface, 1, ip_tos);
+      int const fd0 = output_mcast(&Frontend.metadata_dest_socket, Iface, 0, ip_tos);
+      if(fd < 0 || fd0 < 0 || setup_txtime(fd,fd0,txtime) != 0){
+	fprintf(stderr,"txtime = %s: can't enable SO_TXTIME (%s), pacing in a thread instead\n",txtime,strerror(errno));
+	if(fd >= 0)
+	  close(fd);
+	if(fd0 >= 0)
+	  close(fd0);
+      }
+    }
+  }
   // Set up the hardware early, in case it fails
   const char *hardware = config_getstring(Configtable,GLOBAL,"hardware",NULL);
   if(hardware == NULL){
@@ -404,23 +440,55 @@ int loadconfig(char const *file){
     fprintf(stderr,"'hardware = [sectionname]' now required to specify front end configuration\n");
     exit(EX_USAGE);
   }
-  // Look for specified hardware section
+  // Look for specified hardware section(s)
+  // 'hardware = a b ...' sets up several front ends; the first is the default for channels that don't name one
   {
-    int const nsect = iniparser_getnsec(Configtable);
-    int sect;
-    for(sect = 0; sect < nsect; sect++){
-      char const * const sname = iniparser_getsecname(Configtable,sect);
-      if(strcasecmp(sname,hardware) == 0){
-	if(setup_hardware(sname) != 0)
-	  exit(EX_NOINPUT);
-
+    char *hw_copy = strdup(hardware);
+    char *next = NULL;
+    for(char const *hw = strtok_r(hw_copy," \t,",&next); hw != NULL; hw = strtok_r(NULL," \t,",&next)){
+      if(Nfrontends == MAX_FRONTENDS){
+	fprintf(stderr,"too many front ends, [%s] and later ignored\n",hw);
 	break;
       }
+      if(lookup_frontend(hw) != NULL){
+	fprintf(stderr,"front end [%s] listed twice\n",hw);
+	continue;
+      }
+      int const nsect = iniparser_getnsec(Configtable);
+      int sect;
+      for(sect = 0; sect < nsect; sect++){
+	char const * const sname = iniparser_getsecname(Configtable,sect);
+	if(strcasecmp(sname,hw) == 0){
+	  struct frontend *frontend = &Frontend;
+	  if(Nfrontends > 0){
+	    frontend = calloc(1,sizeof *frontend);
+	    assert(frontend != NULL);
+	    pthread_mutex_init(&frontend->status_mutex,NULL);
+	    pthread_cond_init(&frontend->status_cond,NULL);
+	    frontend->metadata_dest_socket = Frontend.metadata_dest_socket;
+	    strlcpy(frontend->description,Description,sizeof frontend->description);
+	  }
+	  strlcpy(frontend->name,sname,sizeof frontend->name);
+	  if(setup_hardware(frontend,sname) != 0)
+	    exit(EX_NOINPUT);
+
+	  Frontends[Nfrontends++] = frontend;
+	  break;
+	}
+      }
+      if(sect == nsect){
+	fprintf(stderr,"no hardware section [%s] found, please create it\n",hw);
+	exit(EX_USAGE);
+      }
     }
-    if(sect == nsect){
-      fprintf(stderr,"no hardware section [%s] found, please create it\n",hardware);
+    FREE(hw_copy);
+    if(Nfrontends == 0){
+      fprintf(stderr,"'hardware = [sectionname]' now required to specify front end configuration\n");
       exit(EX_USAGE);
     }
+    // Drivers overwrite Description; the first front end describes this instance
+    if(Nfrontends > 1)
+      Description = Frontend.description;
   }
   // Wait until hardware section has been parsed in case it sets Description
   if(advertise){
@@ -437,6 +505,17 @@ int loadconfig(char const *file){
   }
   assert(Blocktime != 0);
   set_defaults(&Template);
+  {
+    // Dynamic channels use the first front end unless another is named here
+    char const *fe_name = config_getstring(Configtable,GLOBAL,"frontend",NULL);
+    if(fe_name != NULL){
+      struct frontend *frontend = lookup_frontend(fe_name);
+      if(frontend != NULL)
+	Template.frontend = frontend;
+      else
+	fprintf(stderr,"[%s] frontend %s not found, using [%s]\n",GLOBAL,fe_name,Frontend.name);
+    }
+  }
   // (Trying to switch from term "mode" to term "preset" as more descriptive)
   // Load preset first, then load options in global section that may modify them
   char const * p = config_getstring(Configtable,GLOBAL,"preset","am"); // Hopefully "am" is defined in presets.conf
@@ -463,7 +542,7 @@ int loadconfig(char const *file){
 
     if(strcasecmp(sname,GLOBAL) == 0)
       continue; // Already processed above
-    if(strcasecmp(sname,hardware) == 0)
+    if(lookup_frontend(sname) != NULL)
       continue; // Already processed as a hardware section (possibly without device=)
     if(config_getstring(Configtable,sname,"device",NULL) != NULL)
       continue; // It's a front end configuration, ignore
@@ -499,8 +578,8 @@ int loadconfig(char const *file){
 // Process the hardware config section, load driver, have it set up the hardware,
 // set up the input half (time -> frequency) half of the fast convolver, and start the front end A/D
 // Set up the experimental coherent spur notch filters
-static int setup_hardware(char const *sname){
-  if(sname == NULL)
+static int setup_hardware(struct frontend *frontend,char const *sname){
+  if(frontend == NULL || sname == NULL)
    return -1; // Possible?
   char const *device = config_getstring(Configtable,sname,"device",sname);
   {
@@ -514,7 +593,7 @@ static int setup_hardware(char const *sname){
     }
     fprintf(stderr,"Dynamically loading %s hardware driver from %s\n",device,dlname);
     // Do not close - must remain open for symbols to be valid
-    Dl_handle = dlopen(dlname,RTLD_GLOBAL|RTLD_NOW);
+    void *Dl_handle = dlopen(dlname,RTLD_GLOBAL|RTLD_NOW);
     if(Dl_handle == NULL){
       char *error = dlerror();
       fprintf(stderr,"Error loading %s to handle device %s: %s\n",dlname,device,error);
@@ -523,50 +602,50 @@ static int setup_hardware(char const *sname){
     char symname[128];
     char *error = NULL;
     snprintf(symname,sizeof(symname),"%s_setup",device);
-    Frontend.setup = dlsym(Dl_handle,symname);
+    frontend->setup = dlsym(Dl_handle,symname);
     if((error = dlerror()) != NULL){
       fprintf(stderr,"error: symbol %s not found in %s for %s: %s\n",symname,dlname,device,error);
       dlclose(Dl_handle);
       return -1;
     }
     snprintf(symname,sizeof(symname),"%s_startup",device);
-    Frontend.start = dlsym(Dl_handle,symname);
+    frontend->start = dlsym(Dl_handle,symname);
     if((error = dlerror()) != NULL){
       fprintf(stderr,"error: symbol %s not found in %s for %s: %s\n",symname,dlname,device,error);
       dlclose(Dl_handle);
       return -1;
     }
     snprintf(symname,sizeof(symname),"%s_shutdown",device);
-    Frontend.shutdown = dlsym(Dl_handle,symname);
+    frontend->shutdown = dlsym(Dl_handle,symname);
     if((error = dlerror()) != NULL){
-      Frontend.shutdown = NULL;
+      frontend->shutdown = NULL;
       if(Verbose)
 	fprintf(stderr,"no %s_shutdown symbol: %s\n",device,error);
     }
     snprintf(symname,sizeof(symname),"%s_tune",device);
-    Frontend.tune = dlsym(Dl_handle,symname);
+    frontend->tune = dlsym(Dl_handle,symname);
     if((error = dlerror()) != NULL){
       // Not fatal, but no tuning possible
-      Frontend.tune = NULL;
+      frontend->tune = NULL;
       fprintf(stderr,"warning: symbol %s not found in %s for %s: %s\n",symname,dlname,device,error);
     }
     // No error checking on these, they're optional
     snprintf(symname,sizeof(symname),"%s_gain",device);
-    Frontend.gain = dlsym(Dl_handle,symname);
+    frontend->gain = dlsym(Dl_handle,symname);
     if((error = dlerror()) != NULL){
-      Frontend.gain = NULL;
+      frontend->gain = NULL;
       if(Verbose) // Not serious errors
 	fprintf(stderr,"no %s_gain symbol: %s\n",device,error);
     }
     snprintf(symname,sizeof(symname),"%s_atten",device);
-    Frontend.atten = dlsym(Dl_handle,symname);
+    frontend->atten = dlsym(Dl_handle,symname);
     if((error = dlerror()) != NULL){
-      Frontend.atten = NULL;
+      frontend->atten = NULL;
       if(Verbose)
 	fprintf(stderr,"no %s_atten symbol: %s\n",device,error);
     }
   }
-  int r = (*Frontend.setup)(&Frontend,Configtable,sname);
+  int r = (*frontend->setup)(frontend,Configtable,sname);
   if(r != 0){
     fprintf(stderr,"device setup returned %d\n",r);
     return r;
@@ -578,28 +657,38 @@ static int setup_hardware(char const *sname){
   // M = filter impulse response duration
   // N = FFT size = L + M - 1
   // Note: no checking that N is an efficient FFT blocksize; choose your parameters wisely
-  assert(Frontend.samprate != 0);
-  Frontend.L = lrint(Frontend.samprate * User_blocktime); // Blocktime is in seconds
-  Frontend.M = Frontend.L / (Overlap - 1) + 1;
-  assert(Frontend.M != 0);
-  assert(Frontend.L != 0);
-  int const N = Frontend.M + Frontend.L - 1;
-  Blocktime = Frontend.L / Frontend.samprate; // True value, must be set early, many things depend on it
-  if(fabs(Blocktime / User_blocktime - 1) > 1e-15)
+  assert(frontend->samprate != 0);
+  frontend->L = lrint(frontend->samprate * User_blocktime); // Blocktime is in seconds
+  frontend->M = frontend->L / (Overlap - 1) + 1;
+  assert(frontend->M != 0);
+  assert(frontend->L != 0);
+  int const N = frontend->M + frontend->L - 1;
+  double const blocktime = frontend->L / frontend->samprate;
+  if(Blocktime == 0)
+    Blocktime = blocktime; // True value, must be set early, many things depend on it
+  else if(fabs(blocktime / Blocktime - 1) > BLOCKTIME_TOLERANCE){
+    // The demodulators all size their blocks with the one global Blocktime, so they'd all be wrong on this front end.
+    // They only round Blocktime * samprate, so a rate that's off by a few ppm (e.g., a calibrated reference) is fine
+    fprintf(stderr,"[%s] block time %.15lg s differs from first front end's %.15lg s by more than %.0lf ppm; choose sample rates giving the same integral block size\n",
+	    sname,blocktime,Blocktime,1e6 * BLOCKTIME_TOLERANCE);
+    exit(EX_USAGE);
+  }
+  if(fabs(blocktime / User_blocktime - 1) > 1e-15)
     fprintf(stderr,"Warning: requested block time %.15lg s changed to %.15lg s for integral block size %d at sample rate %lf Hz\n",
-	    User_blocktime,Blocktime,Frontend.L,Frontend.samprate);
+	    User_blocktime,blocktime,frontend->L,frontend->samprate);
 
-  fprintf(stderr,"Block time %.3lf ms, block samples L=%'d, overlap %d (%.1lf%%) M-1=%'d samples, forward FFT size N=%'u %s\n",
-	  1000.*Blocktime,
-	  Frontend.L,
+  fprintf(stderr,"[%s] block time %.3lf ms, block samples L=%'d, overlap %d (%.1lf%%) M-1=%'d samples, forward FFT size N=%'u %s\n",
+	  sname,
+	  1000.*blocktime,
+	  frontend->L,
 	  Overlap, 100. / Overlap,
-	  Frontend.M-1,
+	  frontend->M-1,
 	  N,
-	  Frontend.isreal ? "real" : "complex");
-  create_filter_input(&Frontend.in,Frontend.L,Frontend.M, Frontend.isreal ? REAL : COMPLEX);
+	  frontend->isreal ? "real" : "complex");
+  create_filter_input(&frontend->in,frontend->L,frontend->M, frontend->isreal ? REAL : COMPLEX);
   // Create list of frequency spurs in filter input (experimental)
-  Frontend.in.notches = calloc(NSPURS+1,sizeof (struct notch_state));
-  struct notch_state *notch = Frontend.in.notches;
+  frontend->in.notches = calloc(NSPURS+1,sizeof (struct notch_state));
+  struct notch_state *notch = frontend->in.notches;
   if(notch == NULL){
     fprintf(stderr,"calloc failed in notch filter setup\n");
     return 0;
@@ -608,7 +697,7 @@ static int setup_hardware(char const *sname){
   for(int i = 0; i < NSPURS; i++){
     int shift;
     double remainder; // Offset from bin center, Hz, e.g, -20 to +20. Or is it -25 to +25?
-    int r = compute_tuning(N,Frontend.M,Frontend.samprate,&shift,&remainder,Frontend.spurs[i]);
+    int r = compute_tuning(N,frontend->M,frontend->samprate,&shift,&remainder,frontend->spurs[i]);
     if(r != 0)
       break;
     notch->state = 0;
@@ -621,6 +710,17 @@ static int setup_hardware(char const *sname){
   return 0;
 }
 
+// Find front end by its config section name
+struct frontend *lookup_frontend(char const *name){
+  if(name == NULL)
+    return NULL;
+  for(int i = 0; i < Nfrontends; i++){
+    if(strcasecmp(Frontends[i]->name,name) == 0)
+      return Frontends[i];
+  }
+  return NULL;
+}
+
 // called by loadconfig() to process one receiver section of a config file
 static void *process_section(void *arg){
   char const *sname = (char *)arg;
@@ -644,6 +744,18 @@ static void *process_section(void *arg){
     strlcpy(chan_template.preset,preset,sizeof(chan_template.preset));
   }
   loadpreset(&chan_template,Configtable,sname);
+  {
+    // Bind channels in this section to a specific front end; default is the one in [global]
+    char const *fe_name = config_getstring(Configtable,sname,"frontend",NULL);
+    if(fe_name != NULL){
+      struct frontend *frontend = lookup_frontend(fe_name);
+      if(frontend == NULL){
+	fprintf(stderr,"[%s] frontend %s not found, no channels started\n",sname,fe_name);
+	return NULL;
+      }
+      chan_template.frontend = frontend;
+    }
+  }
   struct sockaddr_in *sock = (struct sockaddr_in *)&chan_template.output.dest_socket;
 
   if(chan_template.advertise && sock->sin_family == AF_INET) {
@@ -893,13 +1005,14 @@ chan_t *lookup_or_create_chan(uint32_t ssrc,chan_t const *template){
   chan->state = CHANNEL_STARTING;
   pthread_mutex_init(&chan->status.lock,NULL);
   pthread_mutex_lock(&chan->status.lock);
-  int c = Active_channel_count++;
-  if(c == 0){
-    // First channel created, start front end
-    assert(Frontend.start != NULL);
-    int r = (*Frontend.start)(&Frontend);
+  struct frontend * const frontend = chan->frontend;
+  assert(frontend != NULL);
+  if(frontend->active_channels++ == 0){
+    // First channel on this front end, start it
+    assert(frontend->start != NULL);
+    int r = (*frontend->start)(frontend);
     if(r != 0)
-      fprintf(stderr,"Front end start returned %d\n",r);
+      fprintf(stderr,"Front end [%s] start returned %d\n",frontend->name,r);
   }
   pthread_mutex_unlock(&Channel_list_mutex);
   return chan; // lock on chan->status.lock still held
@@ -967,8 +1080,9 @@ static void *demod_thread(void *p){
       fprintf(stderr,"%s returning\n",chan->name);
 
     // clean up
+    opus_release(chan);
     FREE(chan->output.queue);
-    chan->output.queue_length = 0;
+    chan->output.queue_length = chan->output.queue_size = 0;
     if(chan->opus.encoder != NULL){
       opus_encoder_destroy(chan->opus.encoder);
       chan->opus.encoder = NULL;
@@ -1015,19 +1129,8 @@ int demod_idle(void *arg){
     }
     bool restart_needed = false;
     bool response_needed = false;
-    pthread_mutex_lock(&chan->status.lock);
-    // Look on the command queue and grab just one atomically
-    for(int i=0;i < CQLEN; i++){
-      if(chan->commands[i].buffer != NULL){
-	restart_needed = decode_radio_commands(chan,chan->commands[i].buffer,
-					       chan->commands[i].length);
-	FREE(chan->commands[i].buffer);
-	chan->commands[i].length = 0;
-	response_needed = true;
-	break;
-      }
-    }
-    pthread_mutex_unlock(&chan->status.lock);
+    // Execute the next command, if any
+    response_needed = next_command(chan,&restart_needed);
     response(chan,response_needed);
     if(restart_needed)
       break; // restart or terminate
@@ -1065,28 +1168,26 @@ static int close_chan(chan_t *chan){
   pthread_mutex_unlock(&Channel_list_mutex);
 
   // no longer flushed during individual demod exit
-  for(int i=0; i < CQLEN; i++){
-    FREE(chan->commands[i].buffer);
-    chan->commands[i].length = 0;
-  }
+  free_commands(chan);
   FREE(chan->spectrum.bin_data);
   delete_filter_output(&chan->filter.out);
+  opus_release(chan);
   if(chan->opus.encoder != NULL){
     opus_encoder_destroy(chan->opus.encoder);
     chan->opus.encoder = NULL;
   }
   FREE(chan->output.queue);
-  chan->output.queue_length = 0;
+  chan->output.queue_length = chan->output.queue_size = 0;
   pthread_mutex_unlock(&chan->status.lock);
   int err = pthread_mutex_destroy(&chan->status.lock);
   (void)err;
   assert(err == 0);
   pthread_mutex_lock(&Channel_list_mutex);
   chan->state = CHANNEL_IDLE;
-  int c = Active_channel_count--;
-  if(c == 1 && Frontend.shutdown){
-    // No more channels left
-    Frontend.shutdown(&Frontend);
+  struct frontend * const frontend = chan->frontend;
+  if(--frontend->active_channels == 0 && frontend->shutdown){
+    // No more channels left on this front end
+    (*frontend->shutdown)(frontend);
   }
   pthread_mutex_unlock(&Channel_list_mutex);
   return 0;
@@ -1109,9 +1210,10 @@ double set_freq(chan_t * const chan,double const f){
   if(f == 0)
     return f;
 
+  struct frontend const * const frontend = chan->frontend;
   pthread_mutex_lock(&Freq_mutex); // Protect front end tuner
   // Determine new IF
-  double new_if = f - Frontend.frequency;
+  double new_if = f - frontend->frequency;
 
   // Flip sign to convert LO2 frequency to IF carrier frequency
   // Tune an extra kHz to account for front end roundoff
@@ -1120,13 +1222,13 @@ double set_freq(chan_t * const chan,double const f){
   // Retuning the front end will cause all the other channels to recalculate their own IFs
   // What if the IF is wider than the receiver can supply?
   double const fudge = 1000;
-  if(new_if > Frontend.max_IF - chan->filter.max_IF){
+  if(new_if > frontend->max_IF - chan->filter.max_IF){
     // Retune LO1 as little as possible
-    new_if = Frontend.max_IF - chan->filter.max_IF - fudge;
+    new_if = frontend->max_IF - chan->filter.max_IF - fudge;
     set_first_LO(chan,f - new_if);
-  } else if(new_if < Frontend.min_IF - chan->filter.min_IF){
+  } else if(new_if < frontend->min_IF - chan->filter.min_IF){
     // Also retune LO1 as little as possible
-    new_if = Frontend.min_IF - chan->filter.min_IF + fudge;
+    new_if = frontend->min_IF - chan->filter.min_IF + fudge;
     set_first_LO(chan,f - new_if);
   }
   pthread_mutex_unlock(&Freq_mutex);
@@ -1142,7 +1244,8 @@ double set_first_LO(chan_t const * const chan,double const first_LO){
   if(chan == NULL || isnan(first_LO) || !isfinite(first_LO))
     return NAN;
 
-  double const current_lo1 = Frontend.frequency;
+  struct frontend * const frontend = chan->frontend;
+  double const current_lo1 = frontend->frequency;
 
   // Just return actual frequency without changing anything
   if(first_LO == current_lo1 || first_LO <= 0)
@@ -1151,8 +1254,8 @@ double set_first_LO(chan_t const * const chan,double const first_LO){
   // Direct tuning through local module if available
   if(Verbose > 1)
     fprintf(stderr,"%s retuning front end to %'.3lf\n",chan->name,first_LO);
-  if(Frontend.tune != NULL)
-    return (*Frontend.tune)(&Frontend,first_LO);
+  if(frontend->tune != NULL)
+    return (*frontend->tune)(frontend,first_LO);
 
   return first_LO;
 }
@@ -1337,12 +1440,12 @@ static void *sap_send(void *p){
     }
 
     // s= (session name)
-    len = snprintf(wp,space,"s=radio %s\r\n",Frontend.description);
+    len = snprintf(wp,space,"s=radio %s\r\n",chan->frontend->description);
     wp += len;
     space -= len;
 
     // i= (human-readable session information)
-    len = snprintf(wp,space,"i=PCM output stream from ka9q-radio on %s\r\n",Frontend.description);
+    len = snprintf(wp,space,"i=PCM output stream from ka9q-radio on %s\r\n",chan->frontend->description);
     wp += len;
     space -= len;
 
@@ -1413,6 +1516,7 @@ int downconvert(chan_t *chan){
     return -1;
 
   assert(Blocktime != 0);
+  struct frontend * const frontend = chan->frontend;
 
   int shift = 0;
   double remainder = 0;
@@ -1430,16 +1534,16 @@ int downconvert(chan_t *chan){
     }
     // To save CPU time when the front end is completely tuned away from us, block (with timeout) until the front
     // end status changes rather than process zeroes. We must still poll the terminate flag.
-    pthread_mutex_lock(&Frontend.status_mutex);
+    pthread_mutex_lock(&frontend->status_mutex);
 
     // Sign conventions are reversed and simplified from before
     // When RF > LO, tune.second_LO is still negative but shift is now positive
     // When RF < LO, tune.second_LO is still positive but shift is now negative
-    chan->tune.second_LO = Frontend.frequency - chan->tune.freq;
+    chan->tune.second_LO = frontend->frequency - chan->tune.freq;
     double const freq = -(chan->tune.doppler + chan->tune.second_LO); // Total logical oscillator frequency
-    if(compute_tuning(Frontend.in.ilen + Frontend.in.impulse_length - 1,
-		      Frontend.in.impulse_length,
-		      Frontend.samprate,
+    if(compute_tuning(frontend->in.ilen + frontend->in.impulse_length - 1,
+		      frontend->in.impulse_length,
+		      frontend->samprate,
 		      &shift,&remainder,freq) != 0){
       // No front end coverage of our carrier; wait one block time for it to retune
       chan->sig.bb_power = 0;
@@ -1451,11 +1555,11 @@ int downconvert(chan_t *chan){
 	timeout.tv_sec += 1; // 1 sec in the future
 	timeout.tv_nsec -= BILLION;
       }
-      pthread_cond_timedwait(&Frontend.status_cond,&Frontend.status_mutex,&timeout);
-      pthread_mutex_unlock(&Frontend.status_mutex);
+      pthread_cond_timedwait(&frontend->status_cond,&frontend->status_mutex,&timeout);
+      pthread_mutex_unlock(&frontend->status_mutex);
       return 1; // channel idle
     }
-    pthread_mutex_unlock(&Frontend.status_mutex);
+    pthread_mutex_unlock(&frontend->status_mutex);
 
     execute_filter_output(&chan->filter.out,shift); // block until new data frame
 
@@ -1489,7 +1593,7 @@ int downconvert(chan_t *chan){
        equation (12).
     */
     if(shift != chan->filter.bin_shift){
-      const int V = 1 + (Frontend.in.ilen / (Frontend.in.impulse_length - 1)); // Overlap factor
+      const int V = 1 + (frontend->in.ilen / (frontend->in.impulse_length - 1)); // Overlap factor
       chan->filter.phase_adjust = cispi(2.0*(shift % V)/(double)V); // Amount to rotate on each block for shifts not divisible by V
       chan->fine.phasor *= cispi((shift - chan->filter.bin_shift) / (-2.0 * (V-1))); // One time adjust for shift change
       chan->filter.bin_shift = shift;
@@ -1533,21 +1637,21 @@ void response(chan_t *chan,bool response_needed){
   struct frontend const *frontend = chan->frontend;
 
   if(response_needed){
-    send_radio_status((struct sockaddr *)&frontend->metadata_dest_socket,frontend,chan); // Send status in response
+    send_radio_status((struct sockaddr *)&frontend->metadata_dest_socket,frontend,chan,true); // Send status in response
     chan->status.global_timer = 0; // Just sent one
     // Also send to output stream
     // Only send spectrum on status channel, and only in response to poll
     if(chan->demod_type != SPECT_DEMOD && chan->demod_type != SPECT2_DEMOD){
-      send_radio_status((struct sockaddr *)&chan->status.dest_socket,frontend,chan);
+      send_radio_status((struct sockaddr *)&chan->status.dest_socket,frontend,chan,true);
       chan->status.output_timer = chan->status.output_interval; // Reload
     }
   } else if(chan->status.global_timer != 0 && --chan->status.global_timer <= 0){
     // Delayed status request, used mainly by all-channel polls to avoid big bursts
-    send_radio_status((struct sockaddr *)&frontend->metadata_dest_socket,frontend,chan); // Send status in response
+    send_radio_status((struct sockaddr *)&frontend->metadata_dest_socket,frontend,chan,true); // Send status in response
     chan->status.global_timer = 0; // to make sure
   } else if(chan->status.output_interval != 0 && chan->status.output_timer > 0 && --chan->status.output_timer == 0){
     // Output stream status timer has expired; send status on output channel
-    send_radio_status((struct sockaddr *)&chan->status.dest_socket,frontend,chan);
+    send_radio_status((struct sockaddr *)&chan->status.dest_socket,frontend,chan,false);
     if(!chan->output.silent)
       chan->status.output_timer = chan->status.output_interval; // Restart timer only if channel is active
   }
@@ -1610,44 +1714,6 @@ int set_channel_filter(chan_t *chan){
   return 0;
 }
 
-// scale A/D output power to full scale for monitoring overloads
-double scale_ADpower2FS(struct frontend const *frontend){
-  assert(frontend != NULL);
-  if(frontend == NULL)
-    return NAN;
-
-  assert(frontend->bitspersample > 0);
-  double scale = 1.0 / (1 << (frontend->bitspersample - 1)); // Important to force the numerator to double, otherwise the divide produces zero!
-  scale *= scale;
-  // Scale real signals up 3 dB so a rail-to-rail sine will be 0 dBFS, not -3 dBFS
-  // Complex signals carry twice as much power, divided between I and Q
-  if(frontend->isreal)
-    scale *= 2;
-  return scale;
-}
-// Returns multiplicative factor for converting raw samples to doubles with analog gain correction
-// Front ends providing floating point in the nominal +/- 1 range have effectively 1 bit/sample, for a unity scale factor
-double scale_AD(struct frontend const *frontend){
-  assert(frontend != NULL);
-  if(frontend == NULL)
-    return NAN;
-
-  assert(frontend->bitspersample > 0);
-  // net analog gain, dBm to dBFS, that we correct for to maintain unity gain, i.e., 0 dBm -> 0 dBFS
-
-  double analog_gain = 0;
-  if(!isnan(frontend->rf_gain) && isfinite(frontend->rf_gain))
-    analog_gain += frontend->rf_gain;
-  if (!isnan(frontend->rf_atten) && isfinite(frontend->rf_atten))
-    analog_gain -= frontend->rf_atten;
-  if(!isnan(frontend->rf_level_cal) && isfinite(frontend->rf_level_cal))
-    analog_gain -= frontend->rf_level_cal; // new sign convention
-  if(frontend->isreal)
-    analog_gain -= 3.0;
-  // Will first get called before the filter input is created
-  //  = (10 ^ (-analog_gain/10)) * 2^(1-bitspersample)
-  return ldexp(dB2voltage(-analog_gain), 1-frontend->bitspersample); // Front end gain as amplitude ratio
-}
 
 /*
 ==============================================================================
@@ -1862,7 +1928,7 @@ static double estimate_noise(chan_t *chan,int shift){
 
   // correct for FFT scaling and normalize to 1 Hz
   // With an unnormalized FFT, the noise energy in each bin scales proportionately with the number of points in the FFT
-  return noise_bin_energy / ((double)master->bins * Frontend.samprate);
+  return noise_bin_energy / ((double)master->bins * chan->frontend->samprate);
 }
 static int fcompare(void const *ap, void const *bp){
   struct ftab *a = (struct ftab *)ap;
@@ -75,6 +75,7 @@ struct frontend {
 
   // Stuff maintained by our upstream source and filled in by the status daemon
   char description[128];  // free-form text, must be unique per radiod instance
+  char name[64];          // radiod config section name, referenced by channel 'frontend =' entries
   double samprate;      // Nominal (requested) sample rate on raw input data stream
   double frequency;
   double calibrate;  // Clock frequency error ratio, e.g, +1e-6 means 1 ppm high
@@ -115,6 +116,12 @@ struct frontend {
   double if_power;   // Exponentially smoothed power measurement in A/D units (not normalized)
   double if_power_max;
 
+  // Set by drivers that keep a pool of transfers in flight (rx888 USB); zero otherwise
+  int xfer_queue;          // Transfers in flight
+  int xfer_size;           // Bytes per transfer
+  uint64_t xfer_failures;  // Failed transfers
+  float xfer_latency[4];   // Completion interval median, 99th percentile and max; max callback time (sec)
+
   // This structure is updated asynchronously by the front end thread, so it's protected
   pthread_mutex_t status_mutex;
   pthread_cond_t status_cond;     // Signalled whenever status changes
@@ -129,6 +136,7 @@ struct frontend {
   double (*atten)(struct frontend *,double);// optional
   struct filter_in in; // Input half of fast convolver, shared with all channels
   double spurs[NSPURS]; // List of frequency spurs to notch, in Hertz (testing)
+  int active_channels;  // Channels using this front end, protected by Channel_list_mutex
 };
 
 /**
@@ -264,14 +272,35 @@ struct channel {
     int fft_n;        // size of analysis FFT
     int fft_avg;      // Number of consecutive FFTs to average into each spectrum response
     enum window_type window_type;
-    float *window;    // Analysis window
-    fftwf_plan plan;
+    float const *window; // Analysis window, shared (spectrum.c)
+    fftwf_plan plan;  // narrowband mode
+    struct spectrum_engine *engine; // Shared FFTs in wideband mode (spectrum.c)
+    struct spectrum_avg *avg; // FFT workspace for narrowband polls (spectrum.c)
+    double latency;   // Time taken by the last poll, sec
     float complex *ring; // Ring buffer of demodulated data in narrowband mode
     int ring_size;
     int ring_idx;     // index into ring buffer
+    int64_t ring_count; // Samples ever written to it, for the sliding window average
     double base;      // lowest bin energy, dB (v2 byte format)
     double step;      // dB/step (v2 byte format)
+    enum bin_compression compression; // v2 byte format only
     double overlap;   // Overlap between successive FFTs when averaging
+    bool tap;         // Wideband from the front end's forward FFT when the RBW allows (spectrum.c)
+    bool direct;      // Narrowband FFTs on the filter output block, without the ring, when it's big enough (spectrum.c)
+    struct spectrum_history *history; // Past rows of byte levels (spectrum.c)
+    int history_rows; // Rows to keep
+    int64_t history_start; // Backfill requested from this GPS time, ns; 0 = none pending
+    int64_t history_end;   // ...to this one; 0 = now
+    enum spectrum_detector detector;
+    double percentile;  // For DETECT_PERCENTILE, 0-100
+    float *hold;        // Bins held across responses by the hold detectors
+    double hold_freq;   // Frequency of the held bins; NAN restarts the hold
+    uint32_t sequence;  // Last fragmented response
+    int fragment_offset; // First bin still to send in fragments (radio_status.c)
+    int bins_received;  // Clients: bins of response 'sequence' decoded so far
+    double occupancy_threshold; // Report signals this many dB over the noise floor; 0 = off
+    double occupancy_interval;  // Scan for them this often even without polls, sec; 0 = only on polls
+    struct spectrum_occupancy *occupancy; // Noise floor and signals being tracked (spectrum.c)
   } spectrum;
 
   // Output
@@ -294,12 +323,20 @@ struct channel {
     double deemph_state_right;
     uint64_t samples;
     bool pacing;     // Pace output packets
+    int64_t pace_time;  // Launch time of the packet with RTP timestamp pace_ts (audio.c)
+    uint32_t pace_ts;
+    bool gso;        // Send runs of packets with UDP generic segmentation offload, if available
+    bool bundle;     // Share datagrams with other bundled channels to the same destination
+    struct bundle *bundler; // The bundle we last used (audio.c)
     enum encoding encoding;
-    float *queue;    // delayed output data for aggregation when minpacket > 0
-    int queue_length; // Size of allocation, in floats
+    float *queue;    // delayed output data for aggregation when maxdelay > 0
+    int queue_size;   // Size of allocation, in frames (one full packet)
+    int queue_channels; // channels when queue was allocated
+    int queue_length; // frames waiting in queue
     int queue_age; // in frames
     int maxdelay;  // maximum allowable extra latency for output aggregation in blocks, max 5
     uint64_t errors;      // Count of errors with sendto()
+    _Atomic uint64_t drops; // Packets dropped for lack of socket or output queue space
     double gain;        // Audio gain to normalize amplitude
     int ttl; // per-channel IP TTL for multicast scope control
     uint32_t time_snap;    // Snapshot of RTP timestamp sampled by sender in status packets, for linking RTP time to clock time
@@ -314,6 +351,9 @@ struct channel {
     int signal;       // speech/music: OPUS_AUTO, OPUS_SIGNAL_VOICE, OPUS_SIGNAL_MUSIC
     int fec;
     bool dtx;
+    struct opus_queue *queue; // Blocks waiting for the encoder pool, if any (audio.c)
+    double latency;   // Average delay through the encoder pool, sec
+    int backlog;      // Blocks waiting in the pool (shadow copies only; radiod uses opus_backlog())
   } opus;
 
   struct {
@@ -325,14 +365,14 @@ struct channel {
     int output_interval;
     uint64_t packets_out;
     struct sockaddr_storage dest_socket; // Local status output; same IP as output.dest_socket but different port
+    int refresh;                // Full status every this many, deltas in between; 0 = always full
+    uint64_t dirty[2][4];       // Status types set by commands since the last status to metadata_dest_socket, dest_socket
+    int since_full[2];          // Status packets on each since its last full one; 0 = none yet
+    struct cmd_mailbox * _Atomic mailbox; // Commands waiting for the demod thread (radio_status.c)
+    uint64_t cmd_drops;         // Commands dropped because the mailbox was full
+    uint64_t cmd_coalesced;     // Commands skipped because the next one overrode them
   } status;
 
-#define CQLEN 2
-  struct {
-    uint8_t *buffer;
-    int length;
-  } commands[CQLEN];
-
   struct {
     struct sockaddr_storage dest_socket;
     pthread_t thread;
@@ -350,13 +390,19 @@ struct channel {
 typedef struct channel chan_t;
 
 
-extern struct frontend Frontend;
+extern struct frontend Frontend; // First (default) front end
+#define MAX_FRONTENDS 8
+extern struct frontend *Frontends[MAX_FRONTENDS]; // All front ends, Frontends[0] == &Frontend
+extern int Nfrontends;
 extern chan_t Channel_list[];
 extern chan_t Template;
 #define Nchannels 2000
 extern int Channel_idle_timeout;
 extern int Ctl_fd;     // File descriptor for receiving user commands
 extern int Output_fd,Output_fd0;
+extern bool Batch_output;
+extern int Bundle_size;
+extern int Opus_threads;
 extern int Output_fd_lo;
 extern struct sockaddr_storage Metadata_dest_socket; // Socket for main metadata
 extern int Verbose;
@@ -371,6 +417,7 @@ extern dictionary const *Preset_table;   // Table of presets, usually in /usr/lo
 // Channel configuration, initialization & manipulation
 int loadconfig(char const *file);
 chan_t *lookup_or_create_chan(uint32_t ssrc,chan_t const *chan);
+struct frontend *lookup_frontend(char const *name);
 int set_defaults(chan_t *chan);
 int loadpreset(chan_t *chan,dictionary const *table,char const *preset);
 int start_demod(chan_t * restrict chan);
@@ -388,6 +435,7 @@ void response(chan_t *chan,bool response_needed);
 double scale_voltage_out2FS(struct frontend *frontend);
 double scale_AD(struct frontend const *frontend);
 double scale_ADpower2FS(struct frontend const *frontend);
+int mock_ad_code(double x,int bits); // for the drivers' fe-bench mock transports
 
 void *radio_status(void *);
 
@@ -400,9 +448,17 @@ int demod_spectrum(void *);
 
 // Control and status
 int send_output(chan_t * restrict ,const float * ,int,bool);
-int send_radio_status(struct sockaddr const *,struct frontend const *, chan_t *);
+int start_output_sender(void);
+int start_opus_pool(int nthreads);
+int setup_txtime(int fd,int fd0,char const *clockname);
+void opus_release(chan_t *chan);
+int opus_backlog(chan_t const *chan);
+int send_radio_status(struct sockaddr const *,struct frontend const *, chan_t *,bool full);
+int send_status_packet(struct sockaddr const *,chan_t *,uint8_t const *,unsigned long);
 int reset_radio_status(chan_t *chan);
 bool decode_radio_commands(chan_t *chan,uint8_t const *buffer,int length);
+bool next_command(chan_t *chan,bool *restart_needed);
+void free_commands(chan_t *chan);
 int decode_radio_status(struct frontend *frontend,chan_t *channel,uint8_t const *buffer,int length);
 int flush_output(chan_t *chan,bool marker,bool complete);
 
@@ -28,92 +28,385 @@
 #include "multicast.h"
 #include "status.h"
 
-static unsigned long encode_radio_status(struct frontend const *frontend,chan_t *chan,uint8_t *packet, unsigned long len);
+static unsigned long encode_radio_status(struct frontend const *frontend,chan_t *chan,uint8_t *packet, unsigned long len,uint64_t const *dirty);
+static void encode_bins(uint8_t **bp,chan_t const *chan,uint8_t const *levels,int offset,int count);
+static void send_bin_fragments(struct sockaddr const *sock,chan_t *chan);
+
+#define BIN_FRAGMENT 8192    // Bytes of spectrum bin data per fragment
+#define STATUS_RESERVE 1024  // Room kept for the status entries after the spectrum bins
+
+/* Commands for each channel wait in a small mailbox: a bounded multi-producer, single consumer ring
+   (Vyukov's algorithm, like the output queues in audio.c). The demod thread checks it every block without a lock.
+   When a command only sets things the next one also sets (e.g., a series of Doppler updates), it's skipped,
+   unless it carries a COMMAND_TAG the next one doesn't: its sender is waiting to see that tag in a response
+*/
+#define CMD_BATCH 32      // Commands per recvmmsg() (Linux only; elsewhere they're read one at a time)
+#define CMDQ_SLOTS 16     // Commands waiting per channel, power of 2
+#define CMDQ_INLINE 1024  // Bigger commands are copied to the heap
+
+struct cmd_slot {
+  _Atomic size_t seq;
+  int length;
+  bool coalescible;      // Sets at least one thing, and nothing cumulative like SETOPTS
+  uint64_t types[4];     // Bit map of the status_types it sets
+  bool tagged;           // Has a COMMAND_TAG...
+  uint64_t tag;          // ...this one
+  uint8_t *data;         // == buf unless it didn't fit
+  uint8_t buf[CMDQ_INLINE];
+};
+
+struct cmd_mailbox {
+  _Alignas(64) _Atomic size_t head; // producers
+  _Alignas(64) size_t tail;         // demod thread
+  struct cmd_slot slots[CMDQ_SLOTS];
+};
+
+static bool post_command(chan_t *chan,uint8_t const *buffer,int length);
 
 // Radio status reception and transmission thread
 void *radio_status(void *arg){
   pthread_setname("radio stat");
   (void)arg; // unused
 
+  static uint8_t buffers[CMD_BATCH][PKTSIZE];
+#ifdef __linux__
+  struct iovec iovs[CMD_BATCH];
+  struct mmsghdr msgs[CMD_BATCH];
+  memset(msgs,0,sizeof msgs);
+  for(int i=0; i < CMD_BATCH; i++){
+    iovs[i].iov_base = buffers[i];
+    iovs[i].iov_len = sizeof buffers[i];
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+#endif
   while(true){
+#ifdef __linux__
+    // Commands from users; wait for at least one, take as many as are waiting
+    int const count = recvmmsg(Ctl_fd,msgs,CMD_BATCH,MSG_WAITFORONE,NULL);
+#else
     // Command from user
-    uint8_t buffer[PKTSIZE];
-    ssize_t const length = recv(Ctl_fd,buffer,sizeof buffer,0);
-    if(length < 0){
-      fprintf(stderr,"recv status: %s\n",strerror(errno));
+    ssize_t const received = recv(Ctl_fd,buffers[0],sizeof buffers[0],0);
+    int const count = received < 0 ? -1 : 1;
+#endif
+    if(count < 0){
+      if(errno != EINTR)
+	fprintf(stderr,"recv status: %s\n",strerror(errno));
       continue; // Should we exit?
     }
-    if(length < 3 || (enum pkt_type)buffer[0] != CMD)
-      continue; // short packet, or a response; ignore
-
-    // for a specific ssrc?
-    uint32_t const ssrc = get_ssrc(buffer+1,length-1);
-    switch(ssrc){
-    case 0:
-      // Ignore; reserved for dynamic channel template
-      break;
-    case 0xffffffffu:
-      // Ask all threads to dump their status in a staggered manner
-      pthread_mutex_lock(&Channel_list_mutex); // protect status entries
-      for(int i=0; i < Nchannels; i++){
-	chan_t * const chan = &Channel_list[i];
-	if(chan->state == CHANNEL_RUNNING){
-	  pthread_mutex_lock(&chan->status.lock);   // nested locks -- any chance of a deadlock or priority inversion here?
-	  if(chan->output.rtp.ssrc != 0xffffffffu && chan->output.rtp.ssrc != 0)
-	    chan->status.global_timer = (i >> 2) + 1; // four at a time
-	  pthread_mutex_unlock(&chan->status.lock);
-	}
-      }
-      pthread_mutex_unlock(&Channel_list_mutex);
-      break;
-    default:
-      {
-	// find or create specific chan instance
-	chan_t * const chan = lookup_or_create_chan(ssrc,&Template);
-	if(chan == NULL){
-	  // Only happens when we can't create
-	  fprintf(stderr,"Dynamic create of ssrc %'u failed; is 'data =' set in [global]?\n",ssrc);
-	  break;
+    for(int m=0; m < count; m++){
+      uint8_t const * const buffer = buffers[m];
+#ifdef __linux__
+      ssize_t const length = msgs[m].msg_len;
+#else
+      ssize_t const length = received;
+#endif
+      if(length < 3 || (enum pkt_type)buffer[0] != CMD)
+	continue; // short packet, or a response; ignore
+
+      // for a specific ssrc?
+      uint32_t const ssrc = get_ssrc(buffer+1,length-1);
+      switch(ssrc){
+      case 0:
+	// Ignore; reserved for dynamic channel template
+	break;
+      case 0xffffffffu:
+	// Ask all threads to dump their status in a staggered manner
+	pthread_mutex_lock(&Channel_list_mutex); // protect status entries
+	for(int i=0; i < Nchannels; i++){
+	  chan_t * const chan = &Channel_list[i];
+	  if(chan->state == CHANNEL_RUNNING){
+	    pthread_mutex_lock(&chan->status.lock);   // nested locks -- any chance of a deadlock or priority inversion here?
+	    if(chan->output.rtp.ssrc != 0xffffffffu && chan->output.rtp.ssrc != 0)
+	      chan->status.global_timer = (i >> 2) + 1; // four at a time
+	    pthread_mutex_unlock(&chan->status.lock);
+	  }
 	}
-	// We have the lock on chan->status.lock
-	switch(chan->state){
-	default:
-	  pthread_mutex_unlock(&chan->status.lock); // can't happen
-	  break;
-	case CHANNEL_STARTING:
-	  pthread_mutex_lock(&Channel_list_mutex);
-	  chan->state = CHANNEL_RUNNING;
-	  pthread_mutex_unlock(&Channel_list_mutex);
-	  start_demod(chan);
-	  if(Verbose)
-	    fprintf(stderr,"%s dynamically started\n",chan->name);
-	  [[fallthrough]];
-	case CHANNEL_RUNNING: /* fall through */
-	  // queue the command for it to execute
-	  for(int i=0; i < CQLEN; i++){
-	    if(chan->commands[i].buffer == NULL){
-	      uint8_t *cmd = malloc(length-1);
-	      assert(cmd != NULL);
-	      memcpy(cmd,buffer+1,length-1);
-	      chan->commands[i].buffer = cmd;
-	      chan->commands[i].length = length - 1;
-	      cmd = NULL;
-	      break;
-	    }
+	pthread_mutex_unlock(&Channel_list_mutex);
+	break;
+      default:
+	{
+	  // find or create specific chan instance
+	  chan_t * const chan = lookup_or_create_chan(ssrc,&Template);
+	  if(chan == NULL){
+	    // Only happens when we can't create
+	    fprintf(stderr,"Dynamic create of ssrc %'u failed; is 'data =' set in [global]?\n",ssrc);
+	    break;
 	  }
-	  pthread_mutex_unlock(&chan->status.lock); // release lock set by lookup_chan(), let demod run
-	  break;
-	} // send switch(chan->state)
-      }
-    } // end of switch(ssrc)
+	  // We have the lock on chan->status.lock
+	  switch(chan->state){
+	  default:
+	    pthread_mutex_unlock(&chan->status.lock); // can't happen
+	    break;
+	  case CHANNEL_STARTING:
+	    pthread_mutex_lock(&Channel_list_mutex);
+	    chan->state = CHANNEL_RUNNING;
+	    pthread_mutex_unlock(&Channel_list_mutex);
+	    start_demod(chan);
+	    if(Verbose)
+	      fprintf(stderr,"%s dynamically started\n",chan->name);
+	    [[fallthrough]];
+	  case CHANNEL_RUNNING: /* fall through */
+	    // queue the command for it to execute
+	    if(!post_command(chan,buffer+1,length-1))
+	      chan->status.cmd_drops++;
+	    pthread_mutex_unlock(&chan->status.lock); // release lock set by lookup_chan(), let demod run
+	    break;
+	  } // send switch(chan->state)
+	}
+      } // end of switch(ssrc)
+    } // end of for(m)
   } // end of while(true)
   return NULL;
 }
 
-int send_radio_status(struct sockaddr const *sock,struct frontend const *frontend,chan_t *chan){
+// Queue a command for a channel. Returns false if its mailbox is full
+// The caller holds chan->status.lock, which keeps the mailbox from being freed under us
+static bool post_command(chan_t *chan,uint8_t const *buffer,int length){
+  struct cmd_mailbox *mb = atomic_load_explicit(&chan->status.mailbox,memory_order_acquire);
+  if(mb == NULL){
+    // First command for this channel
+    mb = calloc(1,sizeof *mb);
+    if(mb == NULL)
+      return false;
+    for(size_t i=0; i < CMDQ_SLOTS; i++)
+      atomic_init(&mb->slots[i].seq,i);
+    atomic_store_explicit(&chan->status.mailbox,mb,memory_order_release);
+  }
+  struct cmd_slot *slot;
+  size_t pos = atomic_load_explicit(&mb->head,memory_order_relaxed);
+  while(true){
+    slot = &mb->slots[pos & (CMDQ_SLOTS-1)];
+    size_t const seq = atomic_load_explicit(&slot->seq,memory_order_acquire);
+    intptr_t const dif = (intptr_t)seq - (intptr_t)pos;
+    if(dif == 0){
+      if(atomic_compare_exchange_weak_explicit(&mb->head,&pos,pos+1,memory_order_relaxed,memory_order_relaxed))
+	break;
+    } else if(dif < 0)
+      return false; // Full
+    else
+      pos = atomic_load_explicit(&mb->head,memory_order_relaxed);
+  }
+  slot->data = length <= (int)sizeof slot->buf ? slot->buf : malloc(length);
+  slot->length = slot->data != NULL ? length : 0;
+  if(slot->data != NULL)
+    memcpy(slot->data,buffer,length);
+  // Note what it sets, for coalescing
+  memset(slot->types,0,sizeof slot->types);
+  slot->coalescible = false;
+  slot->tagged = false;
+  uint8_t const *cp = buffer;
+  while(cp + 1 < buffer + length){
+    enum status_type const type = *cp++;
+    if(type == EOL)
+      break;
+    unsigned int optlen = *cp++;
+    if(optlen & 0x80){
+      int length_of_length = optlen & 0x7f;
+      optlen = 0;
+      while(length_of_length-- > 0 && cp < buffer + length)
+	optlen = (optlen << 8) | *cp++;
+    }
+    if(cp + optlen > buffer + length)
+      break;
+    if(type == COMMAND_TAG){
+      slot->tagged = true;
+      slot->tag = decode_int64(cp,optlen);
+    }
+    cp += optlen;
+    if(type == COMMAND_TAG || type == OUTPUT_SSRC)
+      continue;
+    if(type == SETOPTS || type == CLEAROPTS){
+      slot->coalescible = false;
+      break;
+    }
+    slot->types[type / 64] |= 1ULL << (type % 64);
+    slot->coalescible = true;
+  }
+  atomic_store_explicit(&slot->seq,pos+1,memory_order_release);
+  return true;
+}
+
+static void release_command(struct cmd_mailbox *mb,struct cmd_slot *slot){
+  if(slot->data != slot->buf)
+    FREE(slot->data);
+  atomic_store_explicit(&slot->seq,mb->tail + CMDQ_SLOTS,memory_order_release);
+  mb->tail++;
+}
+
+// Execute the next command waiting for this channel, if any. Called by its demod thread every block
+// Returns true if there was one, so a response is due. Sets *restart_needed if the command requires a restart
+bool next_command(chan_t *chan,bool *restart_needed){
+  struct cmd_mailbox * const mb = atomic_load_explicit(&chan->status.mailbox,memory_order_acquire);
+  if(mb == NULL)
+    return false;
+  struct cmd_slot *slot = &mb->slots[mb->tail & (CMDQ_SLOTS-1)];
+  if(atomic_load_explicit(&slot->seq,memory_order_acquire) != mb->tail + 1)
+    return false; // Empty (the usual case)
+
+  pthread_mutex_lock(&chan->status.lock);
+  while(true){
+    // Skip it if the next one sets everything it does
+    struct cmd_slot * const next = &mb->slots[(mb->tail + 1) & (CMDQ_SLOTS-1)];
+    if(!slot->coalescible || atomic_load_explicit(&next->seq,memory_order_acquire) != mb->tail + 2
+       || (slot->tagged && (!next->tagged || next->tag != slot->tag)) // Its sender wants to see the tag
+       || (slot->types[0] & ~next->types[0]) != 0 || (slot->types[1] & ~next->types[1]) != 0
+       || (slot->types[2] & ~next->types[2]) != 0 || (slot->types[3] & ~next->types[3]) != 0)
+      break;
+    chan->status.cmd_coalesced++;
+    release_command(mb,slot);
+    slot = next;
+  }
+  bool const restart = decode_radio_commands(chan,slot->data,slot->length);
+  for(int i=0; i < 4; i++){
+    // Mark what it set for the next status on each stream
+    chan->status.dirty[0][i] |= slot->types[i];
+    chan->status.dirty[1][i] |= slot->types[i];
+  }
+  release_command(mb,slot);
+  pthread_mutex_unlock(&chan->status.lock);
+  if(restart)
+    *restart_needed = true;
+  return true;
+}
+
+// Discard a channel's mailbox and anything in it. Caller holds chan->status.lock
+void free_commands(chan_t *chan){
+  struct cmd_mailbox * const mb = atomic_exchange(&chan->status.mailbox,NULL);
+  if(mb == NULL)
+    return;
+  for(int i=0; i < CMDQ_SLOTS; i++){
+    if(mb->slots[i].data != mb->slots[i].buf)
+      FREE(mb->slots[i].data);
+  }
+  free(mb);
+}
+
+/* Settings that change only by command, and only the entry of the same type: a STATUS_DELTA carries one only when
+   a command has set it since the last status on that stream. Those never set by command (e.g., the front end's
+   description) go only in full packets. Anything else a command sets may add, remove or rederive other entries,
+   so the next status on each stream is full */
+static bool is_setting(enum status_type type){
+  switch(type){
+  case DESCRIPTION:
+  case STATUS_DEST_SOCKET:
+  case INPUT_SAMPRATE:
+  case FE_ISREAL:
+  case AD_BITS_PER_SAMPLE:
+  case FILTER_BLOCKSIZE:
+  case FILTER_FIR_LENGTH:
+  case KAISER_BETA:
+  case LOW_EDGE:
+  case HIGH_EDGE:
+  case PLL_SQUARE:
+  case PLL_BW:
+  case ENVELOPE:
+  case SHIFT_FREQUENCY:
+  case AGC_HANGTIME:
+  case AGC_THRESHOLD:
+  case AGC_RECOVERY_RATE:
+  case THRESH_EXTEND:
+  case SNR_SQUELCH:
+  case HEADROOM:
+  case DOPPLER_FREQUENCY:
+  case DOPPLER_FREQUENCY_RATE:
+  case SPECTRUM_TAP:
+  case SPECTRUM_DIRECT:
+  case OCCUPANCY_INTERVAL:
+  case SPECTRUM_HISTORY:
+  case SPECTRUM_PERCENTILE:
+  case STATUS_INTERVAL:
+  case STATUS_REFRESH:
+  case MAXDELAY:
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Does this setting go in the status being encoded? Always in a full one (dirty == NULL)
+static inline bool changed(uint64_t const *dirty,enum status_type type){
+  return dirty == NULL || (dirty[type / 64] >> (type % 64) & 1);
+}
+
+/* Answers to commands and polls (full == true) are always a full STATUS, as is everything when status.refresh is 0.
+   Otherwise periodic updates are STATUS_DELTAs: the measurements, which change all the time, plus the settings
+   commands have changed since the last status on this stream (0 = metadata group, 1 = the channel's own status group).
+   The first on a stream, every status.refresh'th, and the first after a command that set anything but a setting
+   are full */
+int send_radio_status(struct sockaddr const *sock,struct frontend const *frontend,chan_t *chan,bool full){
+  int const stream = sock == (struct sockaddr const *)&chan->status.dest_socket ? 1 : 0;
+  uint64_t * const dirty = chan->status.dirty[stream];
+  if(chan->status.refresh <= 0 || chan->status.since_full[stream] == 0 || chan->status.since_full[stream] >= chan->status.refresh)
+    full = true;
+  if(!full && (dirty[0] | dirty[1] | dirty[2] | dirty[3]) != 0){
+    for(int type = 0; type < 256; type++){
+      if((dirty[type / 64] >> (type % 64) & 1) && !is_setting(type)){
+	full = true;
+	break;
+      }
+    }
+  }
   uint8_t packet[PKTSIZE];
   chan->status.packets_out++;
-  unsigned long const len = encode_radio_status(frontend,chan,packet,sizeof(packet));
+  unsigned long const len = encode_radio_status(frontend,chan,packet,sizeof(packet),full ? NULL : dirty);
+  memset(dirty,0,sizeof chan->status.dirty[stream]);
+  chan->status.since_full[stream] = full ? 1 : chan->status.since_full[stream] + 1;
+  int const r = send_status_packet(sock,chan,packet,len);
+  if(chan->spectrum.fragment_offset > 0)
+    send_bin_fragments(sock,chan);
+  return r;
+}
+
+/* Spectrum responses too big for one packet (e.g., 16k float bins or 64k byte bins) are split into fragments of
+   BIN_FRAGMENT bytes of bin data. The first rides in the status packet; the rest follow immediately in short STATUS
+   packets. All carry the same BIN_SEQUENCE, plus BIN_OFFSET, the index of their first bin in BIN_DATA (FFT order)
+   or BIN_BYTE_DATA (frequency order) as it would appear unfragmented. Each BIN_RICE_DATA fragment is coded on its own.
+   decode_radio_status() puts them back together
+*/
+static void encode_bins(uint8_t **bp,chan_t const *chan,uint8_t const *levels,int offset,int count){
+  if(count > chan->spectrum.bin_count - offset)
+    count = chan->spectrum.bin_count - offset;
+  if(chan->demod_type == SPECT_DEMOD)
+    encode_vector(bp,BIN_DATA,chan->spectrum.bin_data + offset,count);
+  else if(chan->spectrum.compression != BIN_RICE || encode_rice_bins(bp,BIN_RICE_DATA,levels + offset,count) == 0)
+    encode_string(bp,BIN_BYTE_DATA,levels + offset,count); // Fall back to the raw levels when they don't compress
+}
+
+static void send_bin_fragments(struct sockaddr const *sock,chan_t *chan){
+  int const bin_count = chan->spectrum.bin_count;
+  int const per = chan->demod_type == SPECT_DEMOD ? BIN_FRAGMENT / sizeof(float) : BIN_FRAGMENT;
+  uint8_t *levels = NULL;
+  if(chan->demod_type == SPECT2_DEMOD){
+    if((levels = malloc(bin_count)) == NULL){
+      chan->spectrum.fragment_offset = 0;
+      return;
+    }
+    encode_byte_data(chan,levels); // Same as the first fragment's, since nothing has changed
+  }
+  uint8_t packet[PKTSIZE];
+  for(int offset = chan->spectrum.fragment_offset; offset < bin_count; offset += per){
+    uint8_t *bp = packet;
+    *bp++ = STATUS;
+    encode_int32(&bp,OUTPUT_SSRC,chan->output.rtp.ssrc);
+    encode_int64(&bp,COMMAND_TAG,chan->status.tag);
+    encode_int(&bp,BIN_COUNT,bin_count);
+    encode_int32(&bp,BIN_SEQUENCE,chan->spectrum.sequence);
+    if(levels != NULL){
+      encode_float(&bp,SPECTRUM_BASE,chan->spectrum.base);
+      encode_float(&bp,SPECTRUM_STEP,chan->spectrum.step);
+    }
+    encode_int(&bp,BIN_OFFSET,offset);
+    encode_bins(&bp,chan,levels,offset,per);
+    encode_eol(&bp);
+    send_status_packet(sock,chan,packet,bp - packet);
+  }
+  chan->spectrum.fragment_offset = 0;
+  free(levels);
+}
+
+// Send an already encoded packet to a status destination
+int send_status_packet(struct sockaddr const *sock,chan_t *chan,uint8_t const *packet,unsigned long len){
   // I had been forcing metadata to the ttl != 0 socket even when ttl = 0, but this creates a potential problem when
   // 1. Multiple radiod are running on the same system;
   // 2. The same SSRC is in use by more than one radiod;
@@ -505,9 +798,68 @@ bool decode_radio_commands(chan_t *chan,uint8_t const *buffer,int length){
 	chan->spectrum.overlap = x;
       }
       break;
+    case BIN_COMPRESSION:
+      {
+	enum bin_compression const c = decode_int(cp,optlen);
+	if(c == BIN_UNCOMPRESSED || c == BIN_RICE)
+	  chan->spectrum.compression = c;
+      }
+      break;
+    case SPECTRUM_TAP:
+      chan->spectrum.tap = decode_bool(cp,optlen);
+      break;
+    case SPECTRUM_DIRECT:
+      chan->spectrum.direct = decode_bool(cp,optlen);
+      break;
+    case OCCUPANCY_THRESHOLD:
+      {
+	double const x = decode_float(cp,optlen);
+	if(x >= 0)
+	  chan->spectrum.occupancy_threshold = x;
+      }
+      break;
+    case OCCUPANCY_INTERVAL:
+      {
+	double const x = decode_float(cp,optlen);
+	if(x >= 0)
+	  chan->spectrum.occupancy_interval = x;
+      }
+      break;
+    case SPECTRUM_HISTORY:
+      {
+	int const x = decode_int(cp,optlen);
+	if(x >= 0)
+	  chan->spectrum.history_rows = x;
+      }
+      break;
+    case HISTORY_START:
+      chan->spectrum.history_start = decode_int64(cp,optlen);
+      break;
+    case HISTORY_END:
+      chan->spectrum.history_end = decode_int64(cp,optlen);
+      break;
+    case SPECTRUM_DETECTOR:
+      {
+	enum spectrum_detector const d = decode_int(cp,optlen);
+	if(d >= DETECT_AVERAGE && d < N_DETECTOR){
+	  chan->spectrum.detector = d;
+	  chan->spectrum.hold_freq = NAN; // Restart any hold
+	}
+      }
+      break;
+    case SPECTRUM_PERCENTILE:
+      {
+	double const x = decode_float(cp,optlen);
+	if(x >= 0 && x <= 100)
+	  chan->spectrum.percentile = x;
+      }
+      break;
     case STATUS_INTERVAL:
       chan->status.output_interval = abs(decode_int(cp,optlen));
       break;
+    case STATUS_REFRESH:
+      chan->status.refresh = abs(decode_int(cp,optlen));
+      break;
     case OUTPUT_ENCODING:
       {
 	enum encoding encoding = decode_int(cp,optlen);
@@ -680,26 +1032,31 @@ bool decode_radio_commands(chan_t *chan,uint8_t const *buffer,int length){
 // Encode contents of frontend and chan structures as command or status packet
 // packet argument must be long enough!!
 // Convert values from internal to engineering units
-static unsigned long encode_radio_status(struct frontend const *frontend,chan_t *chan,uint8_t *packet, unsigned long len){
+// Encode the full status, or with dirty != NULL a STATUS_DELTA leaving out the settings not marked in it
+static unsigned long encode_radio_status(struct frontend const *frontend,chan_t *chan,uint8_t *packet, unsigned long len,uint64_t const *dirty){
   memset(packet,0,len);
   uint8_t *bp = packet;
 
-  *bp++ = STATUS; // 0 = status, 1 = command
+  *bp++ = dirty == NULL ? STATUS : STATUS_DELTA; // 0 = status, 1 = command
 
   // parameters valid in all modes
   encode_int32(&bp,OUTPUT_SSRC,chan->output.rtp.ssrc); // Now used as channel ID, so present in all modes
   encode_int64(&bp,COMMAND_TAG,chan->status.tag); // at top to make it easier to spot in dumps
   encode_int64(&bp,CMD_CNT,chan->status.packets_in); // integer
   if(strlen(frontend->description) > 0)
-    encode_string(&bp,DESCRIPTION,frontend->description,strlen(frontend->description));
+    if(changed(dirty,DESCRIPTION))
+      encode_string(&bp,DESCRIPTION,frontend->description,strlen(frontend->description));
 
   encode_int32(&bp,LIFETIME,chan->lifetime);
-  encode_socket(&bp,STATUS_DEST_SOCKET,&chan->frontend->metadata_dest_socket);
+  if(changed(dirty,STATUS_DEST_SOCKET))
+    encode_socket(&bp,STATUS_DEST_SOCKET,&chan->frontend->metadata_dest_socket);
   int64_t now = gps_time_ns();
   encode_int64(&bp,GPS_TIME,now);
   encode_int64(&bp,INPUT_SAMPLES,chan->filter.out.sample_index);
-  encode_int32(&bp,INPUT_SAMPRATE,(uint32_t)llrint(frontend->samprate)); // Already defined on the wire as integer Hz, shouldn't change now
-  encode_bool(&bp,FE_ISREAL,frontend->isreal);
+  if(changed(dirty,INPUT_SAMPRATE))
+    encode_int32(&bp,INPUT_SAMPRATE,(uint32_t)llrint(frontend->samprate)); // Already defined on the wire as integer Hz, shouldn't change now
+  if(changed(dirty,FE_ISREAL))
+    encode_bool(&bp,FE_ISREAL,frontend->isreal);
   encode_double(&bp,CALIBRATE,frontend->calibrate);
   if(!isnan(frontend->rf_gain) && isfinite(frontend->rf_gain))
     encode_float(&bp,RF_GAIN,frontend->rf_gain);
@@ -716,15 +1073,18 @@ static unsigned long encode_radio_status(struct frontend const *frontend,chan_t
   }
   encode_float(&bp,FE_LOW_EDGE,frontend->min_IF);
   encode_float(&bp,FE_HIGH_EDGE,frontend->max_IF);
-  encode_int32(&bp,AD_BITS_PER_SAMPLE,frontend->bitspersample);
+  if(changed(dirty,AD_BITS_PER_SAMPLE))
+    encode_int32(&bp,AD_BITS_PER_SAMPLE,frontend->bitspersample);
 
   // Tuning
   encode_double(&bp,RADIO_FREQUENCY,chan->tune.freq); // Hz
   encode_double(&bp,FIRST_LO_FREQUENCY,frontend->frequency); // Hz
   encode_double(&bp,SECOND_LO_FREQUENCY,chan->tune.second_LO); // Hz
 
-  encode_int32(&bp,FILTER_BLOCKSIZE,frontend->in.ilen);
-  encode_int32(&bp,FILTER_FIR_LENGTH,frontend->in.impulse_length);
+  if(changed(dirty,FILTER_BLOCKSIZE))
+    encode_int32(&bp,FILTER_BLOCKSIZE,frontend->in.ilen);
+  if(changed(dirty,FILTER_FIR_LENGTH))
+    encode_int32(&bp,FILTER_FIR_LENGTH,frontend->in.impulse_length);
   encode_int32(&bp,FILTER_DROPS,chan->filter.out.block_drops);  // count
 
   // Adjust for A/D width
@@ -733,6 +1093,12 @@ static unsigned long encode_radio_status(struct frontend const *frontend,chan_t
   encode_int64(&bp,AD_OVER,frontend->overranges);
   if(frontend->overranges != 0)
     encode_int64(&bp,SAMPLES_SINCE_OVER,frontend->samp_since_over);
+  if(frontend->xfer_queue != 0){
+    encode_int32(&bp,FE_XFER_QUEUE,frontend->xfer_queue);
+    encode_int32(&bp,FE_XFER_SIZE,frontend->xfer_size);
+    encode_int64(&bp,FE_XFER_FAILURES,frontend->xfer_failures);
+    encode_vector(&bp,FE_XFER_LATENCY,frontend->xfer_latency,sizeof frontend->xfer_latency / sizeof frontend->xfer_latency[0]);
+  }
   if(!isnan(chan->sig.n0) && isfinite(chan->sig.n0) && chan->sig.n0 > 0)
     encode_float(&bp,NOISE_DENSITY,power2dB(chan->sig.n0));
 
@@ -743,9 +1109,12 @@ static unsigned long encode_radio_status(struct frontend const *frontend,chan_t
     if(len > 0 && len < sizeof(chan->preset))
       encode_string(&bp,PRESET,chan->preset,len);
   }
-  encode_float(&bp,KAISER_BETA,chan->filter.kaiser_beta); // Dimensionless
-  encode_float(&bp,LOW_EDGE,chan->filter.min_IF); // Hz
-  encode_float(&bp,HIGH_EDGE,chan->filter.max_IF); // Hz
+  if(changed(dirty,KAISER_BETA))
+    encode_float(&bp,KAISER_BETA,chan->filter.kaiser_beta); // Dimensionless
+  if(changed(dirty,LOW_EDGE))
+    encode_float(&bp,LOW_EDGE,chan->filter.min_IF); // Hz
+  if(changed(dirty,HIGH_EDGE))
+    encode_float(&bp,HIGH_EDGE,chan->filter.max_IF); // Hz
   encode_int32(&bp,OUTPUT_SAMPRATE,chan->output.samprate); // Hz
   encode_float(&bp,BASEBAND_POWER,power2dB(chan->sig.bb_power));
   encode_int32(&bp,OUTPUT_CHANNELS,chan->output.channels);
@@ -757,19 +1126,26 @@ static unsigned long encode_radio_status(struct frontend const *frontend,chan_t
     if(chan->pll.enable){
       encode_float(&bp,FREQ_OFFSET,chan->sig.foffset);     // Hz; used differently in linear and fm
       encode_bool(&bp,PLL_LOCK,chan->pll.lock);
-      encode_bool(&bp,PLL_SQUARE,chan->pll.square);
+      if(changed(dirty,PLL_SQUARE))
+	encode_bool(&bp,PLL_SQUARE,chan->pll.square);
       encode_float(&bp,PLL_PHASE,chan->pll.cphase); // radians
-      encode_float(&bp,PLL_BW,chan->pll.loop_bw);   // hz
+      if(changed(dirty,PLL_BW))
+	encode_float(&bp,PLL_BW,chan->pll.loop_bw);   // hz
       encode_int64(&bp,PLL_WRAPS,chan->pll.rotations); // count of complete 360-deg rotations of PLL phase - SIGNED
       encode_float(&bp,PLL_SNR,power2dB(chan->pll.snr)); // abs ratio -> dB
     }
-    encode_bool(&bp,ENVELOPE,chan->linear.env);
-    encode_double(&bp,SHIFT_FREQUENCY,chan->tune.shift); // Hz
+    if(changed(dirty,ENVELOPE))
+      encode_bool(&bp,ENVELOPE,chan->linear.env);
+    if(changed(dirty,SHIFT_FREQUENCY))
+      encode_double(&bp,SHIFT_FREQUENCY,chan->tune.shift); // Hz
     encode_bool(&bp,AGC_ENABLE,chan->linear.agc);
     if(chan->linear.agc){
-      encode_float(&bp,AGC_HANGTIME,chan->linear.hangtime); // sec
-      encode_float(&bp,AGC_THRESHOLD,voltage2dB(chan->linear.threshold)); // amplitude -> dB
-      encode_float(&bp,AGC_RECOVERY_RATE,voltage2dB(chan->linear.recovery_rate)); // amplitude/ -> dB/sec
+      if(changed(dirty,AGC_HANGTIME))
+	encode_float(&bp,AGC_HANGTIME,chan->linear.hangtime); // sec
+      if(changed(dirty,AGC_THRESHOLD))
+	encode_float(&bp,AGC_THRESHOLD,voltage2dB(chan->linear.threshold)); // amplitude -> dB
+      if(changed(dirty,AGC_RECOVERY_RATE))
+	encode_float(&bp,AGC_RECOVERY_RATE,voltage2dB(chan->linear.recovery_rate)); // amplitude/ -> dB/sec
     }
     encode_bool(&bp,INDEPENDENT_SIDEBAND,chan->filter2.out.isb);
     encode_float(&bp,GAIN,voltage2dB(chan->output.gain));
@@ -780,7 +1156,8 @@ static unsigned long encode_radio_status(struct frontend const *frontend,chan_t
       encode_float(&bp,PL_DEVIATION,chan->fm.tone_deviation);
     }
     encode_float(&bp,FREQ_OFFSET,chan->sig.foffset);     // Hz; used differently in linear and fm
-    encode_bool(&bp,THRESH_EXTEND,chan->fm.threshold);
+    if(changed(dirty,THRESH_EXTEND))
+      encode_bool(&bp,THRESH_EXTEND,chan->fm.threshold);
     encode_float(&bp,PEAK_DEVIATION,chan->fm.pdeviation); // Hz
     if(chan->fm.rate > 0)
       encode_float(&bp,DEEMPH_TC,-1.0/(log1p(-chan->fm.rate) * chan->output.samprate)); // ad-hoc
@@ -791,7 +1168,8 @@ static unsigned long encode_radio_status(struct frontend const *frontend,chan_t
   case WFM_DEMOD:
     // Relevant only when squelches are active
     encode_float(&bp,FREQ_OFFSET,chan->sig.foffset);     // Hz; used differently in linear and fm
-    encode_bool(&bp,THRESH_EXTEND,chan->fm.threshold);
+    if(changed(dirty,THRESH_EXTEND))
+      encode_bool(&bp,THRESH_EXTEND,chan->fm.threshold);
     encode_float(&bp,PEAK_DEVIATION,chan->fm.pdeviation); // Hz
     if(chan->fm.rate > 0)
       encode_float(&bp,DEEMPH_TC,-1.0/(log1p(-chan->fm.rate) * FULL_SAMPRATE)); // ad-hoc
@@ -810,24 +1188,54 @@ static unsigned long encode_radio_status(struct frontend const *frontend,chan_t
     encode_float(&bp,NOISE_BW,chan->spectrum.noise_bw);
     encode_int(&bp,SPECTRUM_AVG,chan->spectrum.fft_avg);
     encode_float(&bp, SPECTRUM_OVERLAP, chan->spectrum.overlap);
+    encode_float(&bp,SPECTRUM_LATENCY,chan->spectrum.latency);
+    if(changed(dirty,SPECTRUM_TAP))
+      encode_bool(&bp,SPECTRUM_TAP,chan->spectrum.tap);
+    if(changed(dirty,SPECTRUM_DIRECT))
+      encode_bool(&bp,SPECTRUM_DIRECT,chan->spectrum.direct);
+    encode_float(&bp,OCCUPANCY_THRESHOLD,chan->spectrum.occupancy_threshold);
+    if(chan->spectrum.occupancy_threshold > 0)
+      if(changed(dirty,OCCUPANCY_INTERVAL))
+	encode_float(&bp,OCCUPANCY_INTERVAL,chan->spectrum.occupancy_interval);
+    if(changed(dirty,SPECTRUM_HISTORY))
+      encode_int(&bp,SPECTRUM_HISTORY,chan->spectrum.history_rows);
+    encode_int(&bp,SPECTRUM_DETECTOR,chan->spectrum.detector);
+    if(chan->spectrum.detector == DETECT_PERCENTILE)
+      if(changed(dirty,SPECTRUM_PERCENTILE))
+	encode_float(&bp,SPECTRUM_PERCENTILE,chan->spectrum.percentile);
     // encode bin data here? maybe change this, it can be a lot
     // Also need to unwrap this, frequency data is dc....max positive max negative...least negative
     if(chan->spectrum.bin_data == NULL)
       break;
-    if(chan->demod_type == SPECT_DEMOD)
-      encode_vector(&bp,BIN_DATA,chan->spectrum.bin_data,chan->spectrum.bin_count);
-    else {
-      uint8_t *bins = malloc(chan->spectrum.bin_count);
-      if(bins == NULL){
-	fprintf(stderr,"malloc of spectrum data failed\n");
-      } else if(!isnan(chan->spectrum.base) && isfinite(chan->spectrum.base)
-		&& !isnan(chan->spectrum.step) && isfinite(chan->spectrum.step)){
+    {
+      uint8_t *levels = NULL;
+      if(chan->demod_type == SPECT2_DEMOD){
+	if(isnan(chan->spectrum.base) || !isfinite(chan->spectrum.base)
+	   || isnan(chan->spectrum.step) || !isfinite(chan->spectrum.step))
+	  break;
+	levels = malloc(chan->spectrum.bin_count);
+	if(levels == NULL){
+	  fprintf(stderr,"malloc of spectrum data failed\n");
+	  break;
+	}
 	encode_float(&bp,SPECTRUM_BASE, chan->spectrum.base);
 	encode_float(&bp,SPECTRUM_STEP, chan->spectrum.step);
-	encode_byte_data(chan,bins);
-	encode_string(&bp,BIN_BYTE_DATA,bins,chan->spectrum.bin_count);
-	free(bins);
+	encode_int(&bp,BIN_COMPRESSION,chan->spectrum.compression);
+	encode_byte_data(chan,levels);
+      }
+      int const size = chan->demod_type == SPECT_DEMOD ? sizeof(float) : 1;
+      long const room = ((long)len - (bp - packet) - STATUS_RESERVE) / size; // Bins that fit with the rest of the status
+      if(chan->spectrum.bin_count <= room)
+	encode_bins(&bp,chan,levels,0,chan->spectrum.bin_count);
+      else {
+	// Send the first fragment here, the rest from send_radio_status()
+	chan->spectrum.sequence++;
+	encode_int32(&bp,BIN_SEQUENCE,chan->spectrum.sequence);
+	encode_int(&bp,BIN_OFFSET,0);
+	encode_bins(&bp,chan,levels,0,BIN_FRAGMENT / size);
+	chan->spectrum.fragment_offset = BIN_FRAGMENT / size;
       }
+      free(levels);
     }
     break;
   default:
@@ -835,7 +1243,8 @@ static unsigned long encode_radio_status(struct frontend const *frontend,chan_t
   }
   // Stuff not relevant in spectrum analysis mode
   if(chan->demod_type != SPECT_DEMOD && chan->demod_type != SPECT2_DEMOD){
-    encode_bool(&bp,SNR_SQUELCH,chan->squelch.snr_enable);
+    if(changed(dirty,SNR_SQUELCH))
+      encode_bool(&bp,SNR_SQUELCH,chan->squelch.snr_enable);
     encode_float(&bp,SQUELCH_OPEN,power2dB(chan->squelch.open));
     encode_float(&bp,SQUELCH_CLOSE,power2dB(chan->squelch.close));
     encode_int32(&bp,RTP_TIMESNAP,chan->output.rtp.timestamp);
@@ -855,11 +1264,18 @@ static unsigned long encode_radio_status(struct frontend const *frontend,chan_t
       encode_int(&bp,OPUS_APPLICATION,chan->opus.application);
       encode_int(&bp,OPUS_FEC,chan->opus.fec);
       encode_bool(&bp,OPUS_DTX,chan->opus.dtx);
+      if(chan->opus.queue != NULL){
+	encode_float(&bp,OPUS_LATENCY,chan->opus.latency);
+	encode_int(&bp,OPUS_BACKLOG,opus_backlog(chan));
+      }
     }
-    encode_float(&bp,HEADROOM,voltage2dB(chan->output.headroom)); // amplitude -> dB
+    if(changed(dirty,HEADROOM))
+      encode_float(&bp,HEADROOM,voltage2dB(chan->output.headroom)); // amplitude -> dB
     // Doppler info
-    encode_double(&bp,DOPPLER_FREQUENCY,chan->tune.doppler); // Hz
-    encode_double(&bp,DOPPLER_FREQUENCY_RATE,chan->tune.doppler_rate); // Hz
+    if(changed(dirty,DOPPLER_FREQUENCY))
+      encode_double(&bp,DOPPLER_FREQUENCY,chan->tune.doppler); // Hz
+    if(changed(dirty,DOPPLER_FREQUENCY_RATE))
+      encode_double(&bp,DOPPLER_FREQUENCY_RATE,chan->tune.doppler_rate); // Hz
 
     // Source address we're using to send data
     // Get the local socket for the output stream
@@ -876,11 +1292,17 @@ static unsigned long encode_radio_status(struct frontend const *frontend,chan_t
     encode_socket(&bp,OUTPUT_DATA_DEST_SOCKET,&chan->output.dest_socket);
     encode_int32(&bp,OUTPUT_TTL,chan->output.ttl);
     encode_byte(&bp,RTP_PT,chan->output.rtp.type);
-    encode_int32(&bp,STATUS_INTERVAL,chan->status.output_interval);
+    if(changed(dirty,STATUS_INTERVAL))
+      encode_int32(&bp,STATUS_INTERVAL,chan->status.output_interval);
     encode_int(&bp,OUTPUT_ENCODING,chan->output.encoding);
-    encode_int(&bp,MAXDELAY,chan->output.maxdelay);
+    if(changed(dirty,MAXDELAY))
+      encode_int(&bp,MAXDELAY,chan->output.maxdelay);
   }
   encode_int64(&bp,OUTPUT_METADATA_PACKETS,chan->status.packets_out);
+  if(changed(dirty,STATUS_REFRESH))
+    encode_int(&bp,STATUS_REFRESH,chan->status.refresh);
+  encode_int64(&bp,COMMAND_DROPS,chan->status.cmd_drops);
+  encode_int64(&bp,COMMANDS_COALESCED,chan->status.cmd_coalesced);
   // Don't send test points unless they're in use
   if(!isnan(chan->tp1))
     encode_float(&bp,TP1,chan->tp1);
@@ -888,6 +1310,7 @@ static unsigned long encode_radio_status(struct frontend const *frontend,chan_t
     encode_float(&bp,TP2,chan->tp2);
   encode_int64(&bp,SETOPTS,chan->options);
   encode_int64(&bp,OUTPUT_ERRORS,chan->output.errors);
+  encode_int64(&bp,OUTPUT_DROPS,chan->output.drops);
   encode_eol(&bp);
 
   return bp - packet;
@@ -104,6 +104,7 @@ static double set_correct_freq(struct sdr *sdr,double freq);
 //static void do_rtlsdr_agc(struct sdr *);
 static void rx_callback(uint8_t *buf,uint32_t len, void *ctx);
 static double true_freq(uint64_t freq);
+static void set_format(struct frontend *frontend,dictionary const *dictionary,char const *section);
 
 
 int rtlsdr_setup(struct frontend *frontend,dictionary const * const dictionary,char const *section){
@@ -121,6 +122,7 @@ int rtlsdr_setup(struct frontend *frontend,dictionary const * const dictionary,c
       return -1; // Not for us
   }
   config_validate_section(stderr,dictionary,section,Rtlsdr_keys,NULL);
+  set_format(frontend,dictionary,section);
   sdr->dev = -1;
   {
     char const *p = config_getstring(dictionary,section,"description",Description ? Description : "rtl-sdr");
@@ -218,11 +220,6 @@ int rtlsdr_setup(struct frontend *frontend,dictionary const * const dictionary,c
       fprintf(stderr,"rtlsdr_set_bias_tee(%d) failed\n",sdr->bias);
     }
   }
-  frontend->samprate = config_getint(dictionary,section,"samprate",DEFAULT_SAMPRATE);
-  if(frontend->samprate <= 0){
-    fprintf(stderr,"Invalid sample rate, reverting to default\n");
-    frontend->samprate = DEFAULT_SAMPRATE;
-  }
   {
     int ret = rtlsdr_set_sample_rate(sdr->device,(uint32_t)frontend->samprate);
     if(ret != 0){
@@ -236,9 +233,6 @@ int rtlsdr_setup(struct frontend *frontend,dictionary const * const dictionary,c
     if(p != NULL)
       init_frequency = parse_frequency(p,false);
   }
-
-  frontend->calibrate = config_getdouble(dictionary,section,"calibrate",0);
-  frontend->rf_level_cal = NAN; // uncalibrated, probably varies wildly with frequency
   if(init_frequency != 0){
     set_correct_freq(sdr,init_frequency);
     frontend->lock = true;
@@ -247,16 +241,66 @@ int rtlsdr_setup(struct frontend *frontend,dictionary const * const dictionary,c
   fprintf(stderr,"%s, samprate %'lf Hz, agc %d, gain %d, bias %d, direct sampling %d, init freq %'.3lf Hz, calibrate %.3lg\n",
 	  frontend->description,frontend->samprate,sdr->agc,sdr->gain,sdr->bias,sdr->direct_sampling,
 	  init_frequency, frontend->calibrate);
+  return 0;
+}
 
-
+// Sample format, rate and IF range, shared by rtlsdr_setup() and rtlsdr_mock_setup()
+// Must precede the first scale_AD()
+static void set_format(struct frontend * const frontend,dictionary const * const dictionary,char const * const section){
+  frontend->isreal = false; // Make sure the right kind of filter gets created!
+  frontend->bitspersample = 8;
+  frontend->samprate = config_getint(dictionary,section,"samprate",DEFAULT_SAMPRATE);
+  if(frontend->samprate <= 0){
+    fprintf(stderr,"Invalid sample rate, reverting to default\n");
+    frontend->samprate = DEFAULT_SAMPRATE;
+  }
+  frontend->calibrate = config_getdouble(dictionary,section,"calibrate",0);
+  frontend->rf_level_cal = NAN; // uncalibrated, probably varies wildly with frequency
  // Just estimates - get the real number somewhere
   frontend->min_IF = -0.47 * frontend->samprate;
   frontend->max_IF = 0.47 * frontend->samprate;
-  frontend->isreal = false; // Make sure the right kind of filter gets created!
-  frontend->bitspersample = 8;
+}
+
+// fe-bench -m: the driver with librtlsdr's transport replaced by canned buffers
+// No device, so the tuner gain stays at zero
+int rtlsdr_mock_setup(struct frontend * const frontend,dictionary const * const dictionary,char const * const section){
+  assert(dictionary != NULL);
+  struct sdr * const sdr = (struct sdr *)calloc(1,sizeof(struct sdr));
+  assert(sdr != NULL);
+  sdr->frontend = frontend;
+  frontend->context = sdr;
+  set_format(frontend,dictionary,section);
+  strlcpy(frontend->description,"rtl-sdr mock",sizeof(frontend->description));
+  sdr->scale = scale_AD(frontend);
   return 0;
 }
 
+// What rtlsdr_read_async() hands rx_callback()
+struct mock_transfer {
+  struct frontend *frontend;
+  uint32_t len;
+  uint8_t buf[];
+};
+
+// Encode 'count' values (interleaved I/Q, +/-1 = full scale) as one excess-128 buffer as librtlsdr would deliver it
+// librtlsdr has no failed transfers, so samples == NULL gives NULL. free() the result when done
+void *rtlsdr_mock_transfer(struct frontend * const frontend,float const * const samples,int const count){
+  if(samples == NULL)
+    return NULL;
+  struct mock_transfer * const transfer = calloc(1,sizeof(*transfer) + count);
+  assert(transfer != NULL);
+  transfer->frontend = frontend;
+  transfer->len = count;
+  for(int i=0; i < count; i++)
+    transfer->buf[i] = (uint8_t)(mock_ad_code(samples[i],8) + 128);
+  return transfer;
+}
+
+void rtlsdr_mock_callback(void * const p){
+  struct mock_transfer * const transfer = p;
+  rx_callback(transfer->buf,transfer->len,transfer->frontend);
+}
+
 
 static void *rtlsdr_read_thread(void *arg){
   struct sdr * const sdr = arg;
@@ -212,6 +212,31 @@ void *hton_rtp(void * const data, struct rtp_header const * const rtp){
 }
 
 
+// Step through the RTP packets in a datagram, which may be a bundle of them (see rtp.h)
+// Start with *offset = 0. Returns the length of the next packet and points *pkt at it, or 0 when there are no more
+int next_rtp(uint8_t const *buffer,int size,int *offset,uint8_t const **pkt){
+  if(size >= RTP_BUNDLE_HDR && buffer[0] == RTP_BUNDLE_MAGIC0 && buffer[1] == RTP_BUNDLE_MAGIC1){
+    if(*offset == 0)
+      *offset = RTP_BUNDLE_HDR;
+    if(*offset + RTP_BUNDLE_PKTHDR > size)
+      return 0;
+    int const len = buffer[*offset] << 8 | buffer[*offset + 1];
+    if(len < RTP_MIN_SIZE || *offset + RTP_BUNDLE_PKTHDR + len > size){
+      *offset = size; // Corrupt or truncated; give up on the rest
+      return 0;
+    }
+    *pkt = buffer + *offset + RTP_BUNDLE_PKTHDR;
+    *offset += RTP_BUNDLE_PKTHDR + ((len + 3) & ~3);
+    return len;
+  }
+  // Ordinary RTP
+  if(*offset != 0 || size <= 0)
+    return 0;
+  *offset = size;
+  *pkt = buffer;
+  return size;
+}
+
 // Process sequence number and timestamp in incoming RTP header:
 // count dropped and duplicated packets, but it gets confused
 // Determine timestamp jump from the next expected one
@@ -19,6 +19,21 @@
 #define OPUS_SAMPRATE (48000)
 #define PKTSIZE 65536 // Largest possible IP datagram, in case we use jumbograms
 
+/* Bundled RTP (radiod per-channel option "bundle"): complete RTP packets from several channels
+   carried in one UDP datagram, to cut the packet rate of big rasters of narrow channels. Big-endian:
+     0: 'K' 'B'   magic. 'K' (0x4b) has 01 in the top two bits, so it can't be an RTP version 2 header
+     2: count     16 bits, packets in the bundle
+     4: packets, each:
+          length  16 bits, of the RTP packet (header and payload)
+          zero    16 bits
+          the RTP packet, zero padded to a multiple of 4 bytes so the next one is aligned
+   Use next_rtp() to walk through a datagram that might be either kind
+*/
+#define RTP_BUNDLE_MAGIC0 'K'
+#define RTP_BUNDLE_MAGIC1 'B'
+#define RTP_BUNDLE_HDR 4    // bytes before the first packet
+#define RTP_BUNDLE_PKTHDR 4 // bytes before each packet
+
 struct string_table {
   char *str;
   int value;
@@ -128,6 +143,8 @@ struct packet {
 // Convert between internal and wire representations of RTP header
 void const *ntoh_rtp(struct rtp_header *,void const *);
 void *hton_rtp(void *, struct rtp_header const *);
+// Step through the RTP packets in a received datagram, bundled or not
+int next_rtp(uint8_t const *buffer,int size,int *offset,uint8_t const **pkt);
 
 int add_pt(int type, int samprate, int channels, enum encoding encoding);
 // Function to process incoming RTP packet headers
@@ -53,6 +53,8 @@ static double const AGC_LOWER_LIMIT = -26.0;   // Increase RF gain if level is b
 static int const AGC_INTERVAL = 1;           // Seconds between runs of AGC loop
 static double const START_GAIN = 10.0;         // Initial VGA gain, dB
 static double const PTC  = 0.1; // 100 ms time constant for computing Power_smooth
+#define LAT_BINS 64             // Transfer completion interval histogram bins, each 1/LAT_SCALE of a transfer time
+static int const LAT_SCALE = 8;
 static double const DEFAULT_GAINCAL = +1.4;
 
 // Reference frequency for Si5351 clock generator
@@ -104,6 +106,21 @@ struct sdrstate {
   unsigned int reqsize;    // Request size in number of packets
   unsigned long success_count;  // Number of successful transfers
   unsigned long failure_count;  // Number of failed transfers
+  unsigned int bufsize;         // Bytes allocated for each data buffer, >= reqsize * pktsize
+
+  // Transfer timing, measured in rx_callback(), summarized once per second by adapt_queue()
+  // In adaptive mode the transfer pool (then request size) grows up to the configured limits
+  // when transfers fail, completion gaps eat into the queued time, or callbacks run long
+  bool adaptive;
+  unsigned int queuedepth_max;
+  unsigned int reqsize_max;
+  int64_t last_completion;      // gps_time_ns() of previous completion
+  int64_t lat_binwidth;         // ns per histogram bin
+  unsigned long lat_hist[LAT_BINS+1]; // last bin is overflow
+  int64_t max_interval;         // ns, this period
+  int64_t max_callback;         // ns, this period
+  int64_t adapt_time;           // Time of next adapt_queue() run
+  unsigned long adapt_failures; // failure_count at last run
 
   // RF Hardware
   double high_threshold;
@@ -147,6 +164,10 @@ struct sdrstate {
 
 static void load_rx888s(char const *firmware);
 static void rx_callback(struct libusb_transfer *transfer);
+static struct sdrstate *new_sdrstate(struct frontend *frontend,dictionary const *dictionary,char const *section);
+static double config_samprate(dictionary const *dictionary,char const *section);
+static void set_undersample(struct sdrstate *sdr,dictionary const *dictionary,char const *section);
+static double set_xfer_timing(struct sdrstate *sdr);
 static int rx888_usb_init(struct sdrstate *sdr,const char *firmware,unsigned int queuedepth,unsigned int reqsize);
 static void rx888_set_dither_and_randomizer(struct sdrstate *sdr,bool dither,bool randomizer);
 static void rx888_set_att(struct sdrstate *sdr,double att,bool vhf);
@@ -157,6 +178,7 @@ static int rx888_start_rx(struct sdrstate *sdr,libusb_transfer_cb_fn callback);
 static void rx888_stop_rx(struct sdrstate *sdr);
 static void rx888_close(struct sdrstate *sdr);
 static void free_transfer_buffers(unsigned char **databuffers,struct libusb_transfer **transfers,unsigned int queuedepth);
+static void adapt_queue(struct sdrstate *sdr);
 static double val2gain(int g);
 static int gain2val(double gain);
 static void *proc_rx888(void *arg);
@@ -193,6 +215,7 @@ static char const *Rx888_keys[] = {
   "atten", // fixed attenuator gain, dB. Either -10 or +10 is interprepted as 10 dB of attenuation
   "clock-rate-log", // Log measured sample rate every minute even when within tolerance
   "clock-step-logging", // Master enable for the RX888 sample-loss/offset-step monitor (default off)
+  "adaptive", // grow USB queue depth and request size at run time
   "clock-step-threshold", // |RTP<->GPS offset move| (sec) over an interval to log as sample loss; default 0.05
   "description",
   "device",
@@ -206,9 +229,11 @@ static char const *Rx888_keys[] = {
   "gainmode", // Obsolete
   "library",
   "queuedepth",
+  "queuedepth-max", // upper limit in adaptive mode, default 32
   "rand",    // Hardware randomizer, probably doesn't help reduce spurs but it should be tested
   "reference", // Clock reference, default 27 MHz (unlike 10 MHz, nobody cares if that gets into your receiver)
   "reqsize",
+  "reqsize-max", // upper limit in adaptive mode, default 64
   "rfatten", // synonym for atten
   "rfgain", // synonym for gain
   "rxgain", // synomym for gain
@@ -229,15 +254,7 @@ int rx888_setup(struct frontend * const frontend,dictionary const * const dictio
       return -1; // Not for us
   }
   config_validate_section(stderr,dictionary,section,Rx888_keys,NULL);
-  struct sdrstate * const sdr = calloc(1,sizeof(struct sdrstate));
-  assert(sdr != NULL);
-  // Cross-link generic and hardware-specific control structures
-  sdr->frontend = frontend;
-  frontend->context = sdr;
-  frontend->isreal = true; // Make sure the right kind of filter gets created!
-  frontend->bitspersample = 16; // For gain scaling
-  frontend->rf_agc = true; // On by default unless gain or atten is specified
-  sdr->serial = 0;
+  struct sdrstate * const sdr = new_sdrstate(frontend,dictionary,section);
   {
     char const *p = config_getstring(dictionary,section,"serial",NULL); // is serial specified?
     if(p != NULL)
@@ -255,6 +272,23 @@ int rx888_setup(struct frontend * const frontend,dictionary const * const dictio
     fprintf(stderr,"Invalid request size %d, using 32\n",reqsize);
     reqsize = 32;
   }
+  sdr->adaptive = config_getboolean(dictionary,section,"adaptive",false);
+  sdr->queuedepth_max = queuedepth;
+  sdr->reqsize_max = reqsize;
+  if(sdr->adaptive){
+    int qmax = config_getint(dictionary,section,"queuedepth-max",32);
+    if(qmax < queuedepth || qmax > 64){
+      fprintf(stderr,"Invalid queuedepth-max %d, using %d\n",qmax,queuedepth > 32 ? queuedepth : 32);
+      qmax = queuedepth > 32 ? queuedepth : 32;
+    }
+    int rmax = config_getint(dictionary,section,"reqsize-max",64);
+    if(rmax < reqsize || rmax > 64){
+      fprintf(stderr,"Invalid reqsize-max %d, using 64\n",rmax);
+      rmax = 64;
+    }
+    sdr->queuedepth_max = qmax;
+    sdr->reqsize_max = rmax;
+  }
   // Firmware file is now empty by default. We ignore unloaded devices and
   // wait for rx888_boot to load one so it appears as 0xf1
   char const *firmware = config_getstring(dictionary,section,"firmware","");
@@ -268,8 +302,6 @@ int rx888_setup(struct frontend * const frontend,dictionary const * const dictio
   sdr->gpios = 0;
   // Enable/disable dithering
   sdr->dither = config_getboolean(dictionary,section,"dither",false);
-  // Enable/output output randomization
-  sdr->randomizer = config_getboolean(dictionary,section,"rand",false);
   rx888_set_dither_and_randomizer(sdr,sdr->dither,sdr->randomizer);
   // RTP<->GPS offset / sample-loss monitor (opt-in; OFF by default so stock
   // radiod behaviour is unchanged for legacy users — see agc_rx888)
@@ -277,14 +309,6 @@ int rx888_setup(struct frontend * const frontend,dictionary const * const dictio
   sdr->clock_step_threshold = config_getdouble(dictionary,section,"clock-step-threshold",0.05); // seconds
   sdr->clock_rate_log = config_getboolean(dictionary,section,"clock-rate-log",false);
 
-  // RF Gain calibration
-  // WA2ZKD measured several rx888s with very consistent results
-  // e.g., -90 dBm gives -91.4 dBFS with 0 dB VGA gain and 0 dB attenuation
-  // If you use a preamp or converter, add its gain to gaincal
-  // Note: sign convention has flipped dec 2025 to have units of dBm/FS vs FS/dbm
-  // ie. an input of +1.4 dBm gives 0 dBFS with atten == rfgain == 0
-  frontend->rf_level_cal = config_getdouble(dictionary,section,"gaincal",DEFAULT_GAINCAL);
-
   // Attenuation, default 0
   double att = fabs(config_getdouble(dictionary,section,"att",9999));
   att = fabs(config_getdouble(dictionary,section,"atten",att));
@@ -325,36 +349,10 @@ int rx888_setup(struct frontend * const frontend,dictionary const * const dictio
     if(p != NULL)
       reference = parse_frequency(p,false);
   }
-  double samprate = DEFAULT_SAMPRATE;
-  {
-    char const *p = config_getstring(dictionary,section,"samprate",NULL);
-    if(p != NULL)
-      samprate = parse_frequency(p,false);
-  }
-  if(samprate < MIN_SAMPRATE || samprate > MAX_SAMPRATE){
-    fprintf(stderr,"Invalid sample rate %'lf ",samprate);
-    samprate = samprate < MIN_SAMPRATE ? MIN_SAMPRATE : MAX_SAMPRATE; // must be one or the other
-    fprintf(stderr,"forcing %'lf\n",samprate);
-  }
   sdr->reference = reference;
-  samprate = rx888_set_samprate(sdr,samprate); // Update to actual samprate, if different
+  double const samprate = rx888_set_samprate(sdr,config_samprate(dictionary,section)); // Update to actual samprate, if different
   frontend->samprate = samprate;
-
-  sdr->undersample = config_getint(dictionary,section,"undersample",1);
-  if(sdr->undersample < 1){
-    fprintf(stderr,"rx888 undersample must be >= 1, ignoring\n");
-    sdr->undersample = 1;
-  }
-  // note intentional integer truncation, ie undersample = 1 -> frequency = 0
-  frontend->frequency = frontend->samprate * sdr->undersample / 2;
-  if(sdr->undersample & 1){
-    // Somewhat arbitrary. See https://ka7oei.blogspot.com/2024/12/frequency-response-of-rx-888-sdr-at.html
-    frontend->min_IF = 15000;
-    frontend->max_IF = NYQUIST * samprate;
-  } else {
-    frontend->min_IF = -NYQUIST * samprate;
-    frontend->max_IF = -15000;
-  }
+  set_undersample(sdr,dictionary,section);
   // start clock
   si5351_write_byte(sdr,SI5351_REGISTER_PLL_RESET,SI5351_VALUE_PLLA_RESET);
   // power on clock 0
@@ -390,13 +388,7 @@ int rx888_setup(struct frontend * const frontend,dictionary const * const dictio
   sdr->low_threshold = config_getdouble(dictionary,section,"agc-low-threshold",AGC_LOWER_LIMIT);
   sdr->high_threshold = config_getdouble(dictionary,section,"agc-high-threshold",AGC_UPPER_LIMIT);
 
-  double xfer_time = (double)(sdr->reqsize * sdr->pktsize) / (sizeof(int16_t) * frontend->samprate);
-  // Compute exponential smoothing constant
-  // Use double to avoid denormalized addition
-  // value is 1 - exp(-blocktime/tc), but use expm1() function to save precision
-
-  sdr->power_smooth = -expm1(-xfer_time/PTC);
-
+  double const xfer_time = set_xfer_timing(sdr);
   fprintf(stderr,"RX888 AGC %s, nominal gain %.1f dB, actual gain %.1f dB, atten %.1f dB, gain cal %.1f dBm, dither %s, randomizer %s, USB queue depth %d, USB request size %'d * pktsize %'d = %'d bytes (%g sec)\n",
 	  frontend->rf_agc ? "on" : "off",
 	  gain,
@@ -410,6 +402,8 @@ int rx888_setup(struct frontend * const frontend,dictionary const * const dictio
 	  sdr->pktsize,
 	  sdr->reqsize * sdr->pktsize,
 	  xfer_time);
+  if(sdr->adaptive)
+    fprintf(stderr,"RX888 adaptive USB queue, limits: depth %d, request size %d\n",sdr->queuedepth_max,sdr->reqsize_max);
 
 #if defined(__x86_64__)
 #ifdef CACHED_STORE
@@ -463,6 +457,133 @@ int rx888_setup(struct frontend * const frontend,dictionary const * const dictio
   return 0;
 }
 
+// Driver state and the configuration that doesn't touch the hardware, shared by rx888_setup() and rx888_mock_setup()
+static struct sdrstate *new_sdrstate(struct frontend * const frontend,dictionary const * const dictionary,char const * const section){
+  struct sdrstate * const sdr = calloc(1,sizeof(struct sdrstate));
+  assert(sdr != NULL);
+  // Cross-link generic and hardware-specific control structures
+  sdr->frontend = frontend;
+  frontend->context = sdr;
+  frontend->isreal = true; // Make sure the right kind of filter gets created!
+  frontend->bitspersample = 16; // For gain scaling
+  frontend->rf_agc = true; // On by default unless gain or atten is specified
+  sdr->serial = 0;
+  // Enable/output output randomization
+  sdr->randomizer = config_getboolean(dictionary,section,"rand",false);
+
+  // RF Gain calibration
+  // WA2ZKD measured several rx888s with very consistent results
+  // e.g., -90 dBm gives -91.4 dBFS with 0 dB VGA gain and 0 dB attenuation
+  // If you use a preamp or converter, add its gain to gaincal
+  // Note: sign convention has flipped dec 2025 to have units of dBm/FS vs FS/dbm
+  // ie. an input of +1.4 dBm gives 0 dBFS with atten == rfgain == 0
+  frontend->rf_level_cal = config_getdouble(dictionary,section,"gaincal",DEFAULT_GAINCAL);
+  return sdr;
+}
+
+// Requested sample rate, forced into range. The si5351 may not hit it exactly
+static double config_samprate(dictionary const * const dictionary,char const * const section){
+  double samprate = DEFAULT_SAMPRATE;
+  {
+    char const *p = config_getstring(dictionary,section,"samprate",NULL);
+    if(p != NULL)
+      samprate = parse_frequency(p,false);
+  }
+  if(samprate < MIN_SAMPRATE || samprate > MAX_SAMPRATE){
+    fprintf(stderr,"Invalid sample rate %'lf ",samprate);
+    samprate = samprate < MIN_SAMPRATE ? MIN_SAMPRATE : MAX_SAMPRATE; // must be one or the other
+    fprintf(stderr,"forcing %'lf\n",samprate);
+  }
+  return samprate;
+}
+
+// Nyquist zone and usable IF range; needs frontend->samprate
+static void set_undersample(struct sdrstate * const sdr,dictionary const * const dictionary,char const * const section){
+  struct frontend * const frontend = sdr->frontend;
+  sdr->undersample = config_getint(dictionary,section,"undersample",1);
+  if(sdr->undersample < 1){
+    fprintf(stderr,"rx888 undersample must be >= 1, ignoring\n");
+    sdr->undersample = 1;
+  }
+  // note intentional integer truncation, ie undersample = 1 -> frequency = 0
+  frontend->frequency = frontend->samprate * sdr->undersample / 2;
+  if(sdr->undersample & 1){
+    // Somewhat arbitrary. See https://ka7oei.blogspot.com/2024/12/frequency-response-of-rx-888-sdr-at.html
+    frontend->min_IF = 15000;
+    frontend->max_IF = NYQUIST * frontend->samprate;
+  } else {
+    frontend->min_IF = -NYQUIST * frontend->samprate;
+    frontend->max_IF = -15000;
+  }
+}
+
+// Everything that follows the transfer size: power smoothing, latency histogram resolution, front end status
+// Called at setup and whenever adapt_queue() changes the queue. Returns the transfer time in seconds
+static double set_xfer_timing(struct sdrstate * const sdr){
+  struct frontend * const frontend = sdr->frontend;
+  double const xfer_time = (double)(sdr->reqsize * sdr->pktsize) / (sizeof(int16_t) * frontend->samprate);
+  // Compute exponential smoothing constant
+  // Use double to avoid denormalized addition
+  // value is 1 - exp(-blocktime/tc), but use expm1() function to save precision
+  sdr->power_smooth = -expm1(-xfer_time/PTC);
+  sdr->lat_binwidth = (int64_t)(BILLION * xfer_time) / LAT_SCALE;
+  if(sdr->lat_binwidth < 1)
+    sdr->lat_binwidth = 1;
+  frontend->xfer_queue = sdr->queuedepth;
+  frontend->xfer_size = sdr->reqsize * sdr->pktsize;
+  return xfer_time;
+}
+
+// fe-bench -m: the driver with its USB transport replaced by canned transfers
+// Same state and configuration as rx888_setup(), minus the device. Gain and attenuation stay fixed,
+// no si5351 rounds the sample rate, and we never go RUNNING so rx_callback() never resubmits to libusb
+int rx888_mock_setup(struct frontend * const frontend,dictionary const * const dictionary,char const * const section){
+  assert(dictionary != NULL);
+  struct sdrstate * const sdr = new_sdrstate(frontend,dictionary,section);
+  frontend->rf_agc = false;
+  frontend->rf_gain = START_GAIN;
+  frontend->rf_atten = 0;
+  frontend->samprate = config_samprate(dictionary,section);
+  set_undersample(sdr,dictionary,section);
+  strlcpy(frontend->description,"rx888 mock",sizeof(frontend->description));
+  sdr->queuedepth = sdr->queuedepth_max = 1; // fe-bench's transfers, one at a time
+  sdr->scale = scale_AD(frontend);
+  return 0;
+}
+
+// Encode 'count' samples (+/-1 = full scale) as one USB transfer as the FX3 would deliver it, randomizer and all
+// samples == NULL gives a failed transfer. The transfer and its buffer are one block; free() it when done
+// The transfer length becomes the request size, so power smoothing and latency bins follow it
+void *rx888_mock_transfer(struct frontend * const frontend,float const * const samples,int const count){
+  struct sdrstate * const sdr = (struct sdrstate *)frontend->context;
+  struct libusb_transfer * const transfer = calloc(1,sizeof(*transfer) + count * sizeof(int16_t));
+  assert(transfer != NULL);
+  transfer->buffer = (unsigned char *)(transfer + 1);
+  transfer->user_data = sdr;
+  transfer->length = count * sizeof(int16_t);
+  if(samples == NULL){
+    transfer->status = LIBUSB_TRANSFER_ERROR;
+    return transfer;
+  }
+  transfer->status = LIBUSB_TRANSFER_COMPLETED;
+  transfer->actual_length = transfer->length;
+  int16_t * const buf = (int16_t *)transfer->buffer;
+  for(int i=0; i < count; i++){
+    int16_t x = mock_ad_code(samples[i],16);
+    if(sdr->randomizer && (x & 1))
+      x ^= ~1; // LTC2208 randomizer: lsb set flips all the others
+    buf[i] = x;
+  }
+  sdr->reqsize = sdr->reqsize_max = 1;
+  sdr->pktsize = transfer->length;
+  set_xfer_timing(sdr);
+  return transfer;
+}
+
+void rx888_mock_callback(void * const transfer){
+  rx_callback((struct libusb_transfer *)transfer);
+}
+
 // Come back here after common stuff has been set up (filters, etc)
 int rx888_startup(struct frontend * const frontend){
   struct sdrstate * const sdr = (struct sdrstate *)frontend->context;
@@ -530,6 +651,9 @@ static void *proc_rx888(void *arg){
   stick_core();
   {
     sdr->last_count_time = sdr->last_callback_time = gps_time_ns();
+    sdr->last_completion = 0;
+    sdr->adapt_time = sdr->last_callback_time + BILLION;
+    sdr->adapt_failures = sdr->failure_count;
     int ret __attribute__ ((unused));
     ret = rx888_start_rx(sdr,rx_callback);
     assert(ret == 0);
@@ -559,6 +683,9 @@ static void *proc_rx888(void *arg){
       fprintf(stderr,"handle_events returned %d\n",ret);
       break;
     }
+    // Runs on this thread, same as the callbacks, so the transfer list needs no locking
+    if(gps_time_ns() >= sdr->adapt_time)
+      adapt_queue(sdr);
   }
   rx888_stop_rx(sdr);
   // Can't do anything without the front end; quit entirely
@@ -756,7 +883,7 @@ static int convert(float *restrict wptr,int16_t const *restrict samples, int sam
   for(int i = 0; i < sampcount; i ++){
     int16_t x = samples[i];
     if(randomize)
-      x ^= (x << 15) >> 14;
+      x ^= (int16_t)(x << 15) >> 14; // cast so the mask is 16 bits, as in convert_avx2()
     *energy += (int32_t)x * x;
     if(x > 32766 || x < -32766)
       clip_count++;
@@ -772,8 +899,19 @@ void rx_callback(struct libusb_transfer * const transfer){
   assert(transfer != NULL);
   struct sdrstate * const restrict sdr = (struct sdrstate *)transfer->user_data;
   struct frontend * const restrict frontend = sdr->frontend;
+  int64_t const start = gps_time_ns();
 
   sdr->xfers_in_progress--;
+  if(sdr->last_completion != 0){
+    int64_t const interval = start - sdr->last_completion;
+    int64_t bin = interval / sdr->lat_binwidth;
+    if(bin > LAT_BINS)
+      bin = LAT_BINS;
+    sdr->lat_hist[bin]++;
+    if(interval > sdr->max_interval)
+      sdr->max_interval = interval;
+  }
+  sdr->last_completion = start;
 
   if(transfer->status == LIBUSB_TRANSFER_NO_DEVICE){
     sdr->device_gone = true;
@@ -785,6 +923,7 @@ void rx_callback(struct libusb_transfer * const transfer){
       fprintf(stderr,"Transfer %p callback status %s received %d bytes.\n",transfer,
 	      libusb_error_name(transfer->status), transfer->actual_length);
     if(atomic_load(&sdr->state) == RUNNING) {
+      transfer->length = sdr->reqsize * sdr->pktsize; // May have grown
       if(libusb_submit_transfer(transfer) == 0)
         sdr->xfers_in_progress++;
     }
@@ -819,11 +958,92 @@ void rx_callback(struct libusb_transfer * const transfer){
 
   frontend->samples += sampcount; // Count original samples
   if(atomic_load(&sdr->state) == RUNNING) {
+    transfer->length = sdr->reqsize * sdr->pktsize; // May have grown
     if(libusb_submit_transfer(transfer) == 0)
       sdr->xfers_in_progress++;
   }
   sdr->last_callback_time = gps_time_ns();  // Reset watchdog only after read has succeeded
   write_rfilter(&frontend->in,NULL,sampcount); // Update write pointer, invoke FFT if block is complete
+  int64_t const duration = gps_time_ns() - start; // includes the FFT when this callback completes a block
+  if(duration > sdr->max_callback)
+    sdr->max_callback = duration;
+}
+
+// Summarize transfer timing into the front end status and, in adaptive mode,
+// grow the transfer pool or request size when the margin against overrun looks thin.
+// Called once per second from proc_rx888(), the same thread that runs the callbacks
+static void adapt_queue(struct sdrstate * const sdr){
+  struct frontend * const frontend = sdr->frontend;
+  double const xfer_time = (double)(sdr->reqsize * sdr->pktsize) / (sizeof(int16_t) * frontend->samprate);
+  sdr->adapt_time = gps_time_ns() + BILLION;
+
+  // Median and 99th percentile from the histogram, reported as the upper edge of their bins
+  unsigned long total = 0;
+  for(int i=0; i <= LAT_BINS; i++)
+    total += sdr->lat_hist[i];
+  if(total != 0){
+    unsigned long count = 0;
+    int median = -1, p99 = -1;
+    for(int i=0; i <= LAT_BINS; i++){
+      count += sdr->lat_hist[i];
+      if(median < 0 && 2 * count >= total)
+	median = i;
+      if(p99 < 0 && 100 * count >= 99 * total){
+	p99 = i;
+	break;
+      }
+    }
+    frontend->xfer_latency[0] = (median + 1) * sdr->lat_binwidth * 1e-9;
+    frontend->xfer_latency[1] = (p99 + 1) * sdr->lat_binwidth * 1e-9;
+  }
+  frontend->xfer_latency[2] = sdr->max_interval * 1e-9;
+  frontend->xfer_latency[3] = sdr->max_callback * 1e-9;
+  frontend->xfer_failures = sdr->failure_count;
+
+  unsigned long const new_failures = sdr->failure_count - sdr->adapt_failures;
+  double const max_interval = sdr->max_interval * 1e-9;
+  double const max_callback = sdr->max_callback * 1e-9;
+  sdr->adapt_failures = sdr->failure_count;
+  memset(sdr->lat_hist,0,sizeof sdr->lat_hist);
+  sdr->max_interval = sdr->max_callback = 0;
+
+  // Queued transfers cover queuedepth * xfer_time of stalls; grow when half of that was used
+  if(!sdr->adaptive || total == 0)
+    goto done;
+  if(new_failures == 0 && max_interval < 0.5 * sdr->queuedepth * xfer_time && max_callback < 0.5 * xfer_time)
+    goto done;
+
+  if(sdr->queuedepth < sdr->queuedepth_max){
+    unsigned int const step = sdr->queuedepth / 4 > 1 ? sdr->queuedepth / 4 : 1;
+    unsigned int const target = sdr->queuedepth + step < sdr->queuedepth_max ? sdr->queuedepth + step : sdr->queuedepth_max;
+    unsigned char const ep = 1 | LIBUSB_ENDPOINT_IN;
+    unsigned int i;
+    for(i = sdr->queuedepth; i < target; i++){
+      if(sdr->databuffers[i] == NULL)
+	sdr->databuffers[i] = (u_char *)malloc(sdr->bufsize);
+      if(sdr->transfers[i] == NULL)
+	sdr->transfers[i] = libusb_alloc_transfer(0);
+      if(sdr->databuffers[i] == NULL || sdr->transfers[i] == NULL)
+	break;
+      libusb_fill_bulk_transfer(sdr->transfers[i],sdr->dev_handle,ep,sdr->databuffers[i],
+				sdr->reqsize * sdr->pktsize,rx_callback,(void *)sdr,0);
+      if(libusb_submit_transfer(sdr->transfers[i]) != 0)
+	break;
+      sdr->xfers_in_progress++;
+    }
+    if(i == sdr->queuedepth)
+      goto done; // Couldn't add any
+    fprintf(stderr,"RX888 USB queue depth %u -> %u (failures +%lu, max completion gap %.1f ms, max callback %.1f ms)\n",
+	    sdr->queuedepth,i,new_failures,1000*max_interval,1000*max_callback);
+    sdr->queuedepth = i;
+  } else if(sdr->reqsize < sdr->reqsize_max){
+    unsigned int const target = 2 * sdr->reqsize < sdr->reqsize_max ? 2 * sdr->reqsize : sdr->reqsize_max;
+    fprintf(stderr,"RX888 USB request size %u -> %u (failures +%lu, max completion gap %.1f ms, max callback %.1f ms)\n",
+	    sdr->reqsize,target,new_failures,1000*max_interval,1000*max_callback);
+    sdr->reqsize = target; // Picked up by each transfer as it's resubmitted
+  }
+ done:;
+  set_xfer_timing(sdr); // Smoothing and histogram resolution follow the (possibly new) transfer time
 }
 
 static int rx888_usb_init(struct sdrstate *const sdr,const char * const firmware,unsigned int const queuedepth,unsigned int const reqsize){
@@ -997,18 +1217,21 @@ static int rx888_usb_init(struct sdrstate *const sdr,const char * const firmware
   device_list = NULL;
   device = NULL;
 
-  sdr->databuffers = (u_char **)calloc(queuedepth,sizeof(u_char *));
+  // Arrays sized for adaptive growth; buffers for entries beyond queuedepth are allocated as needed
+  unsigned int const maxdepth = sdr->queuedepth_max > queuedepth ? sdr->queuedepth_max : queuedepth;
+  sdr->bufsize = (sdr->reqsize_max > reqsize ? sdr->reqsize_max : reqsize) * sdr->pktsize;
+  sdr->databuffers = (u_char **)calloc(maxdepth,sizeof(u_char *));
   if(sdr->databuffers == NULL){
     fprintf(stderr,"Failed to allocate data buffers\n");
     goto end;
   }
-  sdr->transfers = (struct libusb_transfer **)calloc(queuedepth,sizeof(struct libusb_transfer *));
+  sdr->transfers = (struct libusb_transfer **)calloc(maxdepth,sizeof(struct libusb_transfer *));
   if(sdr->transfers == NULL){
     fprintf(stderr,"Failed to allocate transfer buffers\n");
     goto end;
   }
   for(unsigned int i = 0; i < queuedepth; i++){
-    sdr->databuffers[i] = (u_char *)malloc(reqsize * sdr->pktsize);
+    sdr->databuffers[i] = (u_char *)malloc(sdr->bufsize);
     if(sdr->databuffers[i] == NULL)
       goto end;
     sdr->transfers[i] = libusb_alloc_transfer(0);
@@ -1248,7 +1471,8 @@ static void rx888_stop_rx(struct sdrstate *sdr){
 
 static void rx888_close(struct sdrstate *sdr){
   assert(sdr != NULL);
-  free_transfer_buffers(sdr->databuffers,sdr->transfers,sdr->queuedepth);
+  // Arrays are sized for adaptive growth, unused entries are NULL
+  free_transfer_buffers(sdr->databuffers,sdr->transfers,sdr->queuedepth_max);
   sdr->databuffers = NULL;
   sdr->transfers = NULL;
 
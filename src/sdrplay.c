@@ -148,6 +148,7 @@ static int start_rx(struct sdrstate *sdr,sdrplay_api_StreamCallback_t rx_callbac
 static void rx_callback(int16_t *xi,int16_t *xq,sdrplay_api_StreamCbParamsT *params,unsigned int numSamples,unsigned int reset,void *cbContext);
 static void event_callback(sdrplay_api_EventT eventId,sdrplay_api_TunerSelectT tuner,sdrplay_api_EventParamsT *params,void *cbContext);
 static void show_device_params(struct sdrstate *sdr);
+static void set_format(struct frontend *frontend,dictionary *Dictionary,char const *section);
 
 static char const *Sdrplay_keys[] = {
   "am-notch",
@@ -252,12 +253,7 @@ int sdrplay_setup(struct frontend * const frontend,dictionary * const Dictionary
     return -1;
   }
   frontend->samprate = get_samplerate(sdr);
-  frontend->isreal = false;
-  frontend->bitspersample = 16;
-  frontend->calibrate = config_getdouble(Dictionary,section,"calibrate",0);
-  frontend->min_IF = -0.46 * frontend->samprate;
-  frontend->max_IF = +0.46 * frontend->samprate;
-  frontend->rf_level_cal = NAN; // varies wildly with frequency; uncalibrated
+  set_format(frontend,Dictionary,section);
 
   // Need to know the initial frequency beforehand because of RF att/LNA state
   double init_frequency = 0;
@@ -358,6 +354,63 @@ int sdrplay_setup(struct frontend * const frontend,dictionary * const Dictionary
   return 0;
 }
 
+// Sample format and everything derived from the sample rate, shared by sdrplay_setup() and sdrplay_mock_setup()
+static void set_format(struct frontend * const frontend,dictionary * const Dictionary,char const * const section){
+  frontend->isreal = false;
+  frontend->bitspersample = 16;
+  frontend->calibrate = config_getdouble(Dictionary,section,"calibrate",0);
+  frontend->min_IF = -0.46 * frontend->samprate;
+  frontend->max_IF = +0.46 * frontend->samprate;
+  frontend->rf_level_cal = NAN; // varies wildly with frequency; uncalibrated
+}
+
+// fe-bench -m: the driver with the SDRplay API service replaced by canned stream callbacks
+// No device, so no gain reduction and no decimation: the sample rate is taken as configured
+int sdrplay_mock_setup(struct frontend * const frontend,dictionary * const Dictionary,char const * const section){
+  assert(Dictionary != NULL);
+  struct sdrstate * const sdr = calloc(1,sizeof(struct sdrstate));
+  assert(sdr != NULL);
+  sdr->frontend = frontend;
+  frontend->context = sdr;
+  frontend->samprate = config_getdouble(Dictionary,section,"samprate",MIN_SAMPLE_RATE);
+  set_format(frontend,Dictionary,section);
+  strlcpy(frontend->description,"SDRplay RSP mock",sizeof(frontend->description));
+  sdr->scale = scale_AD(frontend);
+  return 0;
+}
+
+// What the API service hands the stream callback
+struct mock_transfer {
+  struct sdrstate *sdr;
+  sdrplay_api_StreamCbParamsT params;
+  int16_t *xi;
+  int16_t *xq;
+};
+
+// Split 'count' values (interleaved I/Q, +/-1 = full scale) into the separate int16 I and Q arrays the API delivers
+// The API has no failed transfers, so samples == NULL gives NULL. Transfer and arrays are one block; free() it
+void *sdrplay_mock_transfer(struct frontend * const frontend,float const * const samples,int const count){
+  if(samples == NULL)
+    return NULL;
+  int const sampcount = count / 2;
+  struct mock_transfer * const transfer = calloc(1,sizeof(*transfer) + 2 * sampcount * sizeof(int16_t));
+  assert(transfer != NULL);
+  transfer->sdr = frontend->context;
+  transfer->params.numSamples = sampcount;
+  transfer->xi = (int16_t *)(transfer + 1);
+  transfer->xq = transfer->xi + sampcount;
+  for(int i=0; i < sampcount; i++){
+    transfer->xi[i] = mock_ad_code(samples[2*i],16);
+    transfer->xq[i] = mock_ad_code(samples[2*i+1],16);
+  }
+  return transfer;
+}
+
+void sdrplay_mock_callback(void * const p){
+  struct mock_transfer * const transfer = p;
+  rx_callback(transfer->xi,transfer->xq,&transfer->params,transfer->params.numSamples,0,transfer->sdr);
+}
+
 int sdrplay_startup(struct frontend * const frontend){
   struct sdrstate * const sdr = (struct sdrstate *)frontend->context;
   pthread_create(&sdr->monitor_thread,NULL,sdrplay_monitor,sdr);
@@ -27,6 +27,13 @@
 
 static double Power_alpha = 0.01; // Calculate this properly someday
 
+#define MAX_SIGNALS 64 // signal0 ... signal63
+#define CHUNK 64 // Maximum samples per mixing chunk; carrier phase is stepped at this granularity
+#define TILE 2048 // Samples synthesized at a time, sized to stay in L1 cache
+#define NOISE_TABLE_SIZE (1 << 21) // Precomputed gaussian samples (8 MB)
+#define WAVE_BITS 12 // log2 of modulation waveform table size
+#define MOD_STEP_MAX 0.1 // Max modulation phase change per chunk, radians; linear interpolation error ~ MOD_STEP_MAX^2/8 (-58 dBc)
+
 enum modulation {
   CW = 0, // No modulation
   DSB, // AM without a carrier
@@ -47,6 +54,43 @@ static char const *Sig_gen_keys[] = {
   "n0",
   NULL
 };
+// signal0, signal1, ... built at setup time
+static char Signal_key_names[MAX_SIGNALS][16];
+static char const *Signal_keys[MAX_SIGNALS+1];
+
+enum sigtype {
+  SIG_CW,
+  SIG_AM,
+  SIG_DSB,
+  SIG_FM,
+  SIG_NOISE // Wideband noise burst
+};
+static char const *Sigtype_names[] = { "cw", "am", "dsb", "fm", "noise" };
+
+// One synthetic signal in a multi-signal (load generator) configuration
+struct signal {
+  enum sigtype type;
+  double freq; // Absolute carrier frequency, Hz
+  double amplitude; // Peak amplitude
+  double depth; // AM modulation index
+  double deviation; // FM peak deviation, Hz
+  double rate; // Modulating tone frequency, Hz
+  double duty; // Fraction of period the signal is keyed on
+  double period; // Keying period, sec
+
+  // Run-time state
+  long on_samples; // samples on per period
+  long period_samples; // 0 -> always on
+  long gate; // sample position within keying period
+  double complex phase; // carrier phasor at start of next chunk
+  double complex step; // carrier rotation over one full chunk
+  int chunk; // samples per chunk, reduced from CHUNK for fast modulation
+  uint32_t mod_phase; // modulating tone phase, full scale = 2^32
+  uint32_t mod_step; // modulating tone phase increment per sample
+  float complex *wave; // Modulated envelope vs tone phase: 1+m*cos for AM, cos for DSB, exp(j*beta*sin) for FM; one extra entry wraps
+  float rot_re[CHUNK+1]; // carrier rotation over 0...CHUNK samples
+  float rot_im[CHUNK+1];
+};
 
 enum state {
   STOPPED,
@@ -62,6 +106,10 @@ struct sdrstate {
   enum modulation modulation;
   char *source;
   double scale;
+  struct signal *signals; // Multi-signal load generator
+  int nsignals;
+  float *noise_table; // Precomputed gaussian noise, NOISE_TABLE_SIZE entries
+  xoshiro256ss_state rng; // Picks offsets into noise_table
   pthread_t proc_thread;
   _Atomic enum state state;
 };
@@ -72,6 +120,83 @@ double complex complex_gaussian(double);
 double real_gaussian(double);
 double sig_gen_tune(struct frontend * const frontend,double const freq);
 
+// Parse a signal specification of the form
+// type frequency [amplitude] [dev=hz] [rate=hz] [depth=x] [duty=x] [period=sec]
+// e.g., "fm 146.52m -40 dev=5k rate=1k duty=0.5 period=2"
+// amplitude is in dBFS, default -30
+static int parse_signal(struct signal *sig,char const *spec){
+  assert(sig != NULL && spec != NULL);
+  if(sig == NULL || spec == NULL)
+    return -1;
+
+  memset(sig,0,sizeof *sig);
+  sig->amplitude = dB2voltage(-30.0);
+  sig->depth = 0.5;
+  sig->deviation = 5000;
+  sig->rate = 1000;
+  sig->duty = 1.0;
+
+  char *copy = strdup(spec);
+  char *saveptr = NULL;
+  int field = 0;
+  int r = 0;
+  for(char *tok = strtok_r(copy," \t,",&saveptr); tok != NULL; tok = strtok_r(NULL," \t,",&saveptr)){
+    char *eq = strchr(tok,'=');
+    if(eq != NULL){
+      *eq++ = '\0';
+      if(strcasecmp(tok,"dev") == 0 || strcasecmp(tok,"deviation") == 0)
+	sig->deviation = fabs(parse_frequency(eq,false));
+      else if(strcasecmp(tok,"rate") == 0)
+	sig->rate = fabs(parse_frequency(eq,false));
+      else if(strcasecmp(tok,"depth") == 0)
+	sig->depth = fabs(strtod(eq,NULL));
+      else if(strcasecmp(tok,"duty") == 0)
+	sig->duty = strtod(eq,NULL);
+      else if(strcasecmp(tok,"period") == 0)
+	sig->period = fabs(strtod(eq,NULL));
+      else {
+	fprintf(stderr,"sig_gen: unknown signal parameter %s in \"%s\"\n",tok,spec);
+	r = -1;
+      }
+      continue;
+    }
+    switch(field++){
+    case 0:
+      {
+	int i;
+	for(i=0; i < (int)(sizeof Sigtype_names / sizeof Sigtype_names[0]); i++){
+	  if(strcasecmp(tok,Sigtype_names[i]) == 0)
+	    break;
+	}
+	if(i == (int)(sizeof Sigtype_names / sizeof Sigtype_names[0])){
+	  fprintf(stderr,"sig_gen: unknown signal type %s in \"%s\"\n",tok,spec);
+	  r = -1;
+	} else
+	  sig->type = i;
+      }
+      break;
+    case 1:
+      sig->freq = parse_frequency(tok,false);
+      break;
+    case 2:
+      sig->amplitude = dB2voltage(strtod(tok,NULL));
+      break;
+    default:
+      fprintf(stderr,"sig_gen: extra field %s in \"%s\"\n",tok,spec);
+      r = -1;
+      break;
+    }
+  }
+  FREE(copy);
+  if(field < 2 && sig->type != SIG_NOISE){
+    fprintf(stderr,"sig_gen: missing frequency in \"%s\"\n",spec);
+    r = -1;
+  }
+  if(sig->duty <= 0 || sig->duty > 1)
+    sig->duty = 1.0;
+  return r;
+}
+
 int sig_gen_setup(struct frontend * const frontend, dictionary const * const dictionary, char const * const section){
   assert(dictionary != NULL);
   {
@@ -79,7 +204,12 @@ int sig_gen_setup(struct frontend * const frontend, dictionary const * const dic
     if(strcasecmp(device,"sig_gen") != 0 && strcasecmp(device,"siggen") != 0)
       return -1; // Not for us
   }
-  config_validate_section(stderr,dictionary,section,Sig_gen_keys,NULL);
+  for(int i=0; i < MAX_SIGNALS; i++){
+    snprintf(Signal_key_names[i],sizeof Signal_key_names[i],"signal%d",i);
+    Signal_keys[i] = Signal_key_names[i];
+  }
+  Signal_keys[MAX_SIGNALS] = NULL;
+  config_validate_section(stderr,dictionary,section,Sig_gen_keys,Signal_keys);
 
   // Cross-link generic and hardware-specific control structures
   struct sdrstate * const sdr = calloc(1,sizeof *sdr);
@@ -146,6 +276,24 @@ int sig_gen_setup(struct frontend * const frontend, dictionary const * const dic
     if(p != NULL)
       sdr->source = strdup(p);
   }
+  // Additional signals for load generation
+  sdr->signals = calloc(MAX_SIGNALS+1,sizeof *sdr->signals); // +1 for the legacy carrier
+  assert(sdr->signals != NULL);
+  for(int i=0; i < MAX_SIGNALS; i++){
+    char const *p = config_getstring(dictionary,section,Signal_keys[i],NULL);
+    if(p == NULL)
+      continue;
+    if(parse_signal(&sdr->signals[sdr->nsignals],p) == 0)
+      sdr->nsignals++;
+  }
+  // The single carrier is generated by default, or when explicitly given along with other signals
+  if(sdr->nsignals == 0 || config_getstring(dictionary,section,"carrier",NULL) != NULL){
+    struct signal * const sig = &sdr->signals[sdr->nsignals++];
+    sig->type = SIG_CW;
+    sig->freq = sdr->carrier;
+    sig->amplitude = sdr->amplitude;
+    sig->duty = 1.0;
+  }
   {
     double noise = config_getdouble(dictionary,section,"noise",101.0); // Noise amplitude dBFS, default off
     double n0 = config_getdouble(dictionary,section,"n0",101.0); // Noise amplitude dBFS, default off
@@ -208,6 +356,190 @@ static long secondary_callback(void *cb_data, float **data){
   return r;
 }
 
+// Uniform random number in [0,1) from the generator's private RNG
+static double sdr_uniform(struct sdrstate *sdr){
+  return (xoshiro256ss_next(&sdr->rng) >> 11) * 0x1p-53;
+}
+// Random starting index for a run of len samples from the noise table
+static long noise_offset(struct sdrstate *sdr,long len){
+  assert(len < NOISE_TABLE_SIZE);
+  return (long)(((xoshiro256ss_next(&sdr->rng) >> 32) * (uint64_t)(NOISE_TABLE_SIZE - len)) >> 32); // avoids a divide
+}
+
+// Precompute noise table and per-signal rotation tables
+static int init_signals(struct sdrstate *sdr){
+  struct frontend const * const frontend = sdr->frontend;
+  double const samprate = frontend->samprate;
+
+  xoshiro256ss_seed(&sdr->rng,2);
+  sdr->noise_table = malloc(NOISE_TABLE_SIZE * sizeof *sdr->noise_table);
+  assert(sdr->noise_table != NULL);
+  if(sdr->noise_table == NULL)
+    return -1;
+  for(int i=0; i < NOISE_TABLE_SIZE; i++)
+    sdr->noise_table[i] = real_gauss();
+
+  for(int i=0; i < sdr->nsignals; i++){
+    struct signal * const sig = &sdr->signals[i];
+    // Complex front ends are centered on frontend->frequency
+    double const f = (frontend->isreal ? sig->freq : sig->freq - frontend->frequency) / samprate; // cycles/sample
+    for(int k=0; k <= CHUNK; k++){
+      double complex const r = cexp(I * 2 * M_PI * f * k);
+      sig->rot_re[k] = creal(r);
+      sig->rot_im[k] = cimag(r);
+    }
+    // The envelope is interpolated linearly across each chunk, so keep its phase change per chunk small
+    // For FM the carrier phase swings by up to 2*pi*dev/samprate per sample, usually faster than the tone itself
+    sig->chunk = CHUNK;
+    double mod_rate = 0; // fastest envelope phase change, radians/sample
+    if(sig->type == SIG_AM || sig->type == SIG_DSB)
+      mod_rate = 2 * M_PI * sig->rate / samprate;
+    else if(sig->type == SIG_FM)
+      mod_rate = 2 * M_PI * max(sig->rate,sig->deviation) / samprate;
+    if(mod_rate * CHUNK > MOD_STEP_MAX)
+      sig->chunk = max(1,(int)(MOD_STEP_MAX / mod_rate));
+    sig->step = cexp(I * 2 * M_PI * f * sig->chunk); // more accurate than rot[chunk]
+    sig->phase = cexp(I * 2 * M_PI * sdr_uniform(sdr));
+    sig->mod_phase = 0;
+    sig->mod_step = (uint32_t)llrint(ldexp(fmod(sig->rate / samprate,1.0),32));
+    if(sig->type == SIG_AM || sig->type == SIG_DSB || sig->type == SIG_FM){
+      sig->wave = malloc(((1 << WAVE_BITS) + 1) * sizeof *sig->wave);
+      assert(sig->wave != NULL);
+      if(sig->wave == NULL)
+	return -1;
+      double const beta = sig->rate > 0 ? sig->deviation / sig->rate : 0; // FM modulation index
+      for(int k=0; k <= (1 << WAVE_BITS); k++){
+	double const theta = 2 * M_PI * k / (1 << WAVE_BITS);
+	switch(sig->type){
+	case SIG_AM:
+	  sig->wave[k] = 1 + sig->depth * cos(theta);
+	  break;
+	case SIG_DSB:
+	  sig->wave[k] = cos(theta);
+	  break;
+	default: // SIG_FM
+	  sig->wave[k] = cexp(I * beta * sin(theta));
+	  break;
+	}
+      }
+    }
+    if(sig->period > 0 && sig->duty < 1){
+      sig->period_samples = lrint(sig->period * samprate);
+      sig->on_samples = lrint(sig->duty * sig->period_samples);
+      sig->gate = lrint(sdr_uniform(sdr) * sig->period_samples) % max(1L,sig->period_samples); // stagger bursts
+    } else
+      sig->period_samples = 0;
+  }
+  return 0;
+}
+
+// Modulated envelope at tone phase p, linearly interpolated between table entries
+static inline float complex wave_at(struct signal const *sig,uint32_t p){
+  uint32_t const i = p >> (32 - WAVE_BITS);
+  float const frac = ldexpf((float)(p & ((1U << (32 - WAVE_BITS)) - 1)),-(32 - WAVE_BITS));
+  return sig->wave[i] + frac * (sig->wave[i+1] - sig->wave[i]);
+}
+
+// Add one signal into n samples (real) or n complex samples (interleaved) at o
+// Carrier phase is stepped once per chunk and the modulated envelope is interpolated linearly across it,
+// so the inner loops are simple multiply-adds against the precomputed rotation table and auto-vectorize.
+// Chunks are cut short at keying transitions so bursts start and stop on the exact sample
+static void mix_signal(struct sdrstate *sdr,struct signal *sig,float * restrict const o,long const n,bool const isreal){
+  long len;
+  for(long c=0; c < n; c += len){
+    len = min((long)sig->chunk,n - c);
+    bool on = true;
+    if(sig->period_samples > 0){
+      on = sig->gate < sig->on_samples;
+      len = min(len,(on ? sig->on_samples : sig->period_samples) - sig->gate); // to next transition
+      sig->gate += len;
+      if(sig->gate >= sig->period_samples)
+	sig->gate -= sig->period_samples;
+    }
+    if(on){
+      if(sig->type == SIG_NOISE){
+	long const nf = isreal ? len : 2 * len;
+	float * restrict const p = isreal ? o + c : o + 2 * c;
+	float const * restrict const nt = sdr->noise_table + noise_offset(sdr,nf);
+	float const a = sig->amplitude;
+	for(long k=0; k < nf; k++)
+	  p[k] += a * nt[k];
+      } else {
+	// Complex amplitude at sample k is ph + k * dph
+	double complex ph = sig->amplitude * sig->phase;
+	double complex dph = 0;
+	if(sig->wave != NULL){
+	  float complex const w0 = wave_at(sig,sig->mod_phase);
+	  float complex const w1 = wave_at(sig,sig->mod_phase + sig->mod_step * (uint32_t)len);
+	  dph = ph * (w1 - w0) / len;
+	  ph *= w0;
+	}
+	float const pr = creal(ph);
+	float const pi = cimag(ph);
+	float const dpr = creal(dph);
+	float const dpi = cimag(dph);
+	float const * restrict const rr = sig->rot_re;
+	float const * restrict const ri = sig->rot_im;
+	if(isreal){
+	  float * restrict const p = o + c;
+	  for(long k=0; k < len; k++)
+	    p[k] += (pr + k * dpr) * rr[k] - (pi + k * dpi) * ri[k];
+	} else {
+	  float * restrict const p = o + 2 * c;
+	  for(long k=0; k < len; k++){
+	    float const ar = pr + k * dpr;
+	    float const ai = pi + k * dpi;
+	    p[2*k] += ar * rr[k] - ai * ri[k];
+	    p[2*k+1] += ar * ri[k] + ai * rr[k];
+	  }
+	}
+      }
+    }
+    // Keep advancing while keyed off so phase stays continuous
+    if(sig->type != SIG_NOISE)
+      sig->phase *= (len == sig->chunk) ? sig->step : CMPLX(sig->rot_re[len],sig->rot_im[len]);
+    sig->mod_phase += sig->mod_step * (uint32_t)len; // wraps modulo 2^32
+  }
+}
+
+// Generate n samples of noise plus all signals into out, applying the A/D scale factor
+// out is n floats if isreal, otherwise n interleaved complex samples
+// Returns unscaled energy
+static double synthesize(struct sdrstate *sdr,float * const out,long const n,bool const isreal){
+  float const scale = sdr->scale;
+  float const noise = sdr->noise;
+  double energy = 0;
+
+  for(long t=0; t < n; t += TILE){
+    long const len = min((long)TILE,n - t);
+    long const nf = isreal ? len : 2 * len; // floats in this tile
+    float * restrict const o = isreal ? out + t : out + 2 * t;
+    if(noise != 0){
+      float const * restrict const nt = sdr->noise_table + noise_offset(sdr,nf);
+      for(long k=0; k < nf; k++)
+	o[k] = noise * nt[k];
+    } else
+      memset(o,0,nf * sizeof *o);
+
+    for(int i=0; i < sdr->nsignals; i++)
+      mix_signal(sdr,&sdr->signals[i],o,len,isreal);
+
+    float tile_energy = 0;
+    for(long k=0; k < nf; k++){
+      tile_energy += o[k] * o[k];
+      o[k] *= scale;
+    }
+    energy += tile_energy;
+  }
+  // Keep carrier phasors on the unit circle
+  for(int i=0; i < sdr->nsignals; i++){
+    struct signal * const sig = &sdr->signals[i];
+    if(sig->type != SIG_NOISE)
+      sig->phase /= cabs(sig->phase);
+  }
+  return energy;
+}
+
 static void *proc_sig_gen(void *arg){
   pthread_setname("proc_siggen");
   struct sdrstate * const sdr = (struct sdrstate *)arg;
@@ -217,21 +549,24 @@ static void *proc_sig_gen(void *arg){
 
   realtime(2 + default_prio());
 
+  rand_init();
+  if(init_signals(sdr) != 0)
+    return NULL;
+
   struct osc carrier = {0};
   if(frontend->isreal)
     set_osc(&carrier,sdr->carrier / frontend->samprate,0.0); // No sweep just yet
   else
     set_osc(&carrier,(sdr->carrier - frontend->frequency)/frontend->samprate,0.0); // Offset down
 
-  rand_init();
-
   struct input_state * const is = &Input_state;
   int const mod_samprate = FULL_SAMPRATE; // Fixed for now
   double upsample_ratio = 0;
   float *dac_modulation = NULL;
   long const output_size = lrint(1.5 * Blocktime * frontend->samprate); // allow extra for catchup
 
-  if(sdr->modulation != CW && sdr->source != NULL){
+  // FM from an external source isn't implemented yet
+  if((sdr->modulation == AM || sdr->modulation == DSB) && sdr->source != NULL){
     is->source = popen(sdr->source,"r");
     if(is->source == NULL)
       perror("popen");
@@ -288,12 +623,8 @@ static void *proc_sig_gen(void *arg){
     if(frontend->isreal){
       // Real signal
       float * wptr = frontend->in.input_write_pointer.r;
-      if(sdr->modulation == CW || sdr->modulation == FM){ // FM to be implemented
-	for(long i=0; i < blocksize; i++){
-	  double samp = sdr->amplitude * creal(step_osc(&carrier)) + sdr->noise * real_gauss();
-	  in_energy += samp * samp;
-	  wptr[i] = samp * sdr->scale;
-	}
+      if(is->source == NULL){
+	in_energy = synthesize(sdr,wptr,blocksize,true);
       } else {
 	assert(blocksize <= output_size);
 	long r = src_callback_read(is->secondary_state, upsample_ratio, blocksize, dac_modulation);
@@ -318,12 +649,8 @@ static void *proc_sig_gen(void *arg){
     } else {
       // Front end is complex
       float complex * wptr = frontend->in.input_write_pointer.c;
-      if(sdr->modulation == CW || sdr->modulation == FM){ // FM to be implemented
-	for(long i=0; i < blocksize; i++){
-	  double complex samp = sdr->amplitude * step_osc(&carrier) + sdr->noise * complex_gauss();
-	  in_energy += samp * samp;
-	  wptr[i] = samp * sdr->scale;
-	}
+      if(is->source == NULL){
+	in_energy = synthesize(sdr,(float *)wptr,blocksize,false);
       } else {
 	assert(blocksize <= output_size);
 	long r = src_callback_read(is->secondary_state, upsample_ratio, blocksize, dac_modulation);
@@ -368,6 +695,10 @@ static void *proc_sig_gen(void *arg){
     src_delete(is->primary_state);
   if(is->secondary_state)
     src_delete(is->secondary_state);
+  FREE(dac_modulation);
+  FREE(sdr->noise_table);
+  for(int i=0; i < sdr->nsignals; i++)
+    FREE(sdr->signals[i].wave);
   return NULL;
 }
 int sig_gen_startup(struct frontend *frontend){
@@ -3,6 +3,7 @@
 // Copyright 2023-2026, Phil Karn, KA9Q
 #include <assert.h>
 #include <pthread.h>
+#include <stdatomic.h>
 #include <string.h>
 #include <math.h>
 #include <complex.h>
@@ -15,20 +16,36 @@
 #include "window.h"
 #include "sched.h"
 
-//#define RICE 1
 //#define SPECTRUM_CLIP 1
 //#define FIXED_STEP  1
 
+struct spectrum_engine;
+struct spectrum_avg;
 static void generate_window(chan_t *);
-static void setup_real_fft(chan_t *);
 static void setup_complex_fft(chan_t *);
 static void setup_wideband(chan_t *);
 static void setup_narrowband(chan_t *);
 static void narrowband_poll(chan_t *);
 static void wideband_poll(chan_t *);
-#if RICE
-static void rice(chan_t *);
-#endif
+static void tap_poll(chan_t *);
+static bool use_tap(chan_t const *);
+static bool use_direct(chan_t const *);
+static void set_level_scale(chan_t *);
+static void record_history(chan_t *);
+static void send_history(chan_t *);
+static void delete_history(struct spectrum_history **);
+static bool occupancy_due(chan_t const *);
+static void scan_occupancy(chan_t *,bool);
+static void send_signals(chan_t *);
+static void delete_occupancy(struct spectrum_occupancy **);
+static enum spectrum_detector fft_detector(chan_t const *);
+static void apply_hold(chan_t *);
+static void release_engine(struct spectrum_engine **);
+static void delete_spectrum_avg(struct spectrum_avg **);
+static float const *attach_window(enum window_type,double,int,double *);
+static void release_window(float const **);
+static fftwf_plan attach_plan(int,bool);
+static void release_plan(fftwf_plan *);
 
 // Spectrum analysis thread
 int demod_spectrum(void *arg){
@@ -56,26 +73,19 @@ int demod_spectrum(void *arg){
   int crossover = -1;
   double shape = -1;
   int timeout = 0;
+  bool tap = false;
+  struct filter_in *tapped = NULL; // Reading the front end's power tap
 
   // Main loop
   while(!restart_needed){
     response(chan,response_needed);
     response_needed = false;
+    if(chan->spectrum.history_start != 0)
+      send_history(chan); // After the response to the command asking for it
+    send_signals(chan); // If there's news
 
-    // Look on the single-entry command queue, grab it atomically and execute it
-    pthread_mutex_lock(&chan->status.lock);
-    // Look on the command queue and grab just one atomically
-    for(int i=0;i < CQLEN; i++){
-      if(chan->commands[i].buffer != NULL){
-	restart_needed = decode_radio_commands(chan,chan->commands[i].buffer,
-					       chan->commands[i].length);
-	FREE(chan->commands[i].buffer);
-	chan->commands[i].length = 0;
-	response_needed = true;
-	break;
-      }
-    }
-    pthread_mutex_unlock(&chan->status.lock);
+    // Execute the next command, if any
+    response_needed = next_command(chan,&restart_needed);
     // Must handle possible parameter changes from decode_radio_commands() BEFORE executing the downconverter,
     // which will act immediately on those changes. Otherwise segfaults occur when crossing between wideband and narrowband
     // modes because things are not properly set up for the poll when it comes
@@ -91,12 +101,24 @@ int demod_spectrum(void *arg){
     if(chan->spectrum.rbw != rbw || chan->spectrum.bin_count != bin_count)
       chan->spectrum.fft_n = -1; // force setup;
 
+    if(use_tap(chan) != tap)
+      chan->spectrum.fft_n = -1; // force setup
+
     // fairly major reinitialization required
     if(chan->spectrum.fft_n <= 0){
-      FREE(chan->spectrum.window); // force regeneration on first poll
-      if(chan->spectrum.rbw > chan->spectrum.crossover)
+      release_window(&chan->spectrum.window); // force regeneration on first poll
+      FREE(chan->spectrum.hold);
+      release_engine(&chan->spectrum.engine);
+      detach_power_tap(tapped);
+      tapped = NULL;
+      tap = use_tap(chan);
+      if(chan->spectrum.rbw > chan->spectrum.crossover){
 	setup_wideband(chan);
-      else
+	if(tap && attach_power_tap(&chan->frontend->in) == 0){
+	  tapped = &chan->frontend->in;
+	  chan->spectrum.noise_bw = chan->spectrum.rbw; // Bins are summed over exactly the RBW
+	}
+      } else
 	setup_narrowband(chan);
       // Remember the new values
       rbw = chan->spectrum.rbw;
@@ -107,7 +129,7 @@ int demod_spectrum(void *arg){
     } else if(chan->spectrum.window_type != window_type
 	      || (chan->spectrum.shape != shape && (chan->spectrum.window_type == KAISER_WINDOW
 						    || chan->spectrum.window_type == GAUSSIAN_WINDOW))){
-      FREE(chan->spectrum.window); // force regeneration
+      release_window(&chan->spectrum.window); // force regeneration
       shape = chan->spectrum.shape;
       window_type = chan->spectrum.window_type;
     }
@@ -121,48 +143,62 @@ int demod_spectrum(void *arg){
     // r == 0 is normal return
     // Process receiver data only in narrowband mode
     if(chan->spectrum.rbw <= chan->spectrum.crossover && chan->baseband != NULL){
-      if(chan->spectrum.ring == NULL || chan->spectrum.ring_size < chan->spectrum.fft_avg * chan->spectrum.fft_n){
-
-	// Need a new or bigger baseband ring buffer
-	if(chan->spectrum.ring == NULL)
-	  chan->spectrum.ring_idx = 0; // ? no need to reset on growth vs start?
-
-	int old_ring_size = chan->spectrum.ring_size;
-	chan->spectrum.ring_size = chan->spectrum.fft_avg * chan->spectrum.fft_n;
-	assert(chan->spectrum.ring_size > 0);
-	void *old = chan->spectrum.ring;
-	int newsize =  chan->spectrum.ring_size * sizeof *chan->spectrum.ring;
-	assert(newsize > 0);
-	chan->spectrum.ring = realloc(chan->spectrum.ring,newsize);
-	if(chan->spectrum.ring == NULL){
-	  fprintf(stderr,"spectrum: realloc(%d) failed\n",newsize);
-	  FREE(old); // emulate reallocf() in case the realloc fails
-	  goto quit;
+      if(use_direct(chan)){
+	// The poll reads the filter output block itself, so no ring is needed
+	mirror_free((void **)&chan->spectrum.ring,chan->spectrum.ring_size * sizeof *chan->spectrum.ring);
+	chan->spectrum.ring_size = 0;
+      } else {
+	// One FFT more than the average needs, since the sliding window's FFTs start on a grid
+	if(chan->spectrum.ring == NULL || chan->spectrum.ring_size < (chan->spectrum.fft_avg + 1) * chan->spectrum.fft_n){
+	  // Need a new or bigger baseband ring buffer. It's mirrored so appends and FFTs never have to wrap,
+	  // and a whole number of pages so the mirror lines up
+	  int const ring_size = round_to_page((chan->spectrum.fft_avg + 1) * chan->spectrum.fft_n * sizeof *chan->spectrum.ring)
+	    / sizeof *chan->spectrum.ring;
+	  assert(ring_size > 0);
+	  float complex *ring = mirror_alloc(ring_size * sizeof *ring); // Comes zeroed, which avoids display glitches
+	  if(ring == NULL){
+	    fprintf(stderr,"spectrum: mirror_alloc(%d) failed\n",(int)(ring_size * sizeof *ring));
+	    goto quit;
+	  }
+	  if(chan->spectrum.ring != NULL){
+	    // Keep the old contents, newest last
+	    memcpy(ring,chan->spectrum.ring + chan->spectrum.ring_idx,chan->spectrum.ring_size * sizeof *ring);
+	    mirror_free((void **)&chan->spectrum.ring,chan->spectrum.ring_size * sizeof *ring);
+	    chan->spectrum.ring_idx = chan->spectrum.ring_size;
+	  } else
+	    chan->spectrum.ring_idx = 0;
+	  chan->spectrum.ring = ring;
+	  chan->spectrum.ring_size = ring_size;
 	}
-	// Clear the new space to avoid display glitches
-	assert(newsize >= old_ring_size);
-	memset(chan->spectrum.ring + old_ring_size, 0, (chan->spectrum.ring_size - old_ring_size) * sizeof *chan->spectrum.ring);
-      }
-      assert(chan->spectrum.ring != NULL);
-      for(int i=0; i < chan->sampcount; i++){
-	chan->spectrum.ring[chan->spectrum.ring_idx++] = chan->baseband[i];
-	if(chan->spectrum.ring_idx == chan->spectrum.ring_size)
-	  chan->spectrum.ring_idx = 0; // wrap around
+	assert(chan->spectrum.ring != NULL);
+	// Append the new samples in one copy, running into the mirror if need be
+	int const ring_size = chan->spectrum.ring_size;
+	int n = chan->sampcount;
+	float complex const *in = chan->baseband;
+	if(n > ring_size){
+	  in += n - ring_size; // Only the newest fit
+	  n = ring_size;
+	}
+	memcpy(chan->spectrum.ring + chan->spectrum.ring_idx,in,n * sizeof *in);
+	chan->spectrum.ring_idx = (chan->spectrum.ring_idx + n) % ring_size;
+	chan->spectrum.ring_count += chan->sampcount;
       }
       timeout -= chan->sampcount;
       if(timeout < 0)
 	timeout = 0;
     }
-    if(response_needed){      // Generate new bin data for the next response
+    bool const scan = occupancy_due(chan);
+    if(response_needed || scan){      // Generate new bin data for the next response, or to look for signals
       // Make sure output frequency bin data buffers exist
       if(chan->spectrum.bin_data == NULL || chan->spectrum.bin_count != bin_count){
-	void *old = chan->spectrum.ring;
+	void *old = chan->spectrum.bin_data;
 	chan->spectrum.bin_data = realloc(chan->spectrum.bin_data, chan->spectrum.bin_count * sizeof *chan->spectrum.bin_data);
 	if(chan->spectrum.bin_data == NULL){
 	  FREE(old); // emulate reallocf()
 	  goto quit;
 	}
       }
+      int64_t const poll_start = gps_time_ns();
       if(chan->spectrum.rbw <= chan->spectrum.crossover){
 #if 0
 	// Don't run FFT more often than one FFT's worth of samples
@@ -173,11 +209,14 @@ int demod_spectrum(void *arg){
 #else
 	narrowband_poll(chan);
 #endif
-      } else
+      } else if(tapped != NULL)
+	tap_poll(chan);
+      else
 	wideband_poll(chan);
-#ifdef RICE
-      rice(chan); // experiment with rice encoding
-#endif
+      chan->spectrum.latency = (gps_time_ns() - poll_start) * 1e-9;
+      if(response_needed && chan->demod_type == SPECT2_DEMOD)
+	record_history(chan);
+      scan_occupancy(chan,response_needed);
     }
     // Remember new values in case they change next time
     rbw = chan->spectrum.rbw;
@@ -195,18 +234,470 @@ int demod_spectrum(void *arg){
   chan->spectrum.fft_n = 0;
   delete_filter_output(&chan->filter.out);
   chan->baseband = NULL;
-  destroy_plan(&chan->spectrum.plan);
-  FREE(chan->spectrum.window);
+  release_plan(&chan->spectrum.plan);
+  release_engine(&chan->spectrum.engine);
+  detach_power_tap(tapped);
+  delete_spectrum_avg(&chan->spectrum.avg);
+  delete_history(&chan->spectrum.history);
+  delete_occupancy(&chan->spectrum.occupancy);
+  FREE(chan->spectrum.hold);
+  release_window(&chan->spectrum.window);
   FREE(chan->spectrum.bin_data);
-  FREE(chan->spectrum.ring);
+  mirror_free((void **)&chan->spectrum.ring,chan->spectrum.ring_size * sizeof *chan->spectrum.ring);
   chan->spectrum.ring_size = 0;
   return chan->demod_type == INVALID_DEMOD ? -1 : 0;
 }
 
+/* Averaged power spectra
+   The FFTs to be averaged are shared among the FFT worker threads (when they have no forward FFTs to do)
+   and the calling thread, one at a time so a worker is never away from the forward FFTs for more than one.
+   Each task sums the ones it did into its own partial sums, so nothing is locked per bin.
+   The buffers and the work descriptors persist between polls
+
+   When the caller can say where its data sits in the sample stream (a->sliding), the FFTs instead start on a
+   fixed grid of multiples of the stride, and each one's power spectrum is kept in a ring of fft_avg slots.
+   A poll then computes only the FFTs that have come due since the last one and updates a running sum,
+   so polls faster than the averaging span cost much less than fft_avg FFTs each
+*/
+#define SPECTRUM_TASKS 8 // Max ways to split up one poll
+#define SLIDING_MAX_BYTES (64 << 20) // Limit on the kept spectra; above this, every poll does all its FFTs
+
+struct avg_task {
+  struct spectrum_avg *avg;
+  struct fft_work work;  // For submit_fft_work()
+  int size;              // fft_n our buffers were allocated for
+  void *in;              // float or float complex
+  float complex *out;
+  float *sum;
+};
+
+struct spectrum_avg {
+  // Set by the caller of average_spectrum()
+  fftwf_plan plan;
+  float const *window;
+  int fft_n;
+  bool real;             // Real input, r2c transform
+  void const *ring;      // Input samples, float or float complex
+  int ring_size;         // Samples
+  bool mirrored;         // Can be read past the end (the A/D ring buffer)
+  int start;             // Ring index of the first FFT's input
+  int stride;            // Samples between successive FFTs
+  int fft_avg;           // Number of FFTs
+  int bins;              // fft_n/2+1 (real) or fft_n (complex)
+  enum spectrum_detector detector; // How the FFTs are combined; DETECT_AVERAGE, _PEAK, _MIN or _PERCENTILE
+  float percentile;      // 0-1
+  float *quantile;       // Running percentile estimates, carried between polls
+  int quantile_size;
+  bool sliding;          // Use the sliding window; start is then ignored
+  int64_t newest;        // Samples ever written to the ring...
+  int write;             // ...up to this index
+
+  // Sliding window state, carried between polls
+  float *store;          // fft_avg power spectra; FFT k in slot k % fft_avg
+  int64_t *key;          // The k in each slot, -1 if none
+  float *total;          // Sum of the stored spectra, for DETECT_AVERAGE
+  int64_t last_key;      // Newest k stored, -1 if none
+  int since_sum;         // Spectra added to total since it was last summed from scratch
+  int64_t next_key;      // First FFT of this poll to compute
+  // What the state was made for
+  int store_fft_n;
+  int store_bins;
+  int store_avg;
+  int store_stride;
+  float const *store_window;
+  enum spectrum_detector store_detector;
+
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  int count;             // FFTs in this poll
+  _Atomic int next_iter; // Next one for a task to take
+  int pending;           // Tasks not yet finished
+  struct avg_task task[SPECTRUM_TASKS];
+  float *power;          // Result buffer kept here for narrowband polls
+  int power_size;
+};
+
+static struct spectrum_avg *create_spectrum_avg(void){
+  struct spectrum_avg * const a = calloc(1,sizeof *a);
+  assert(a != NULL);
+  pthread_mutex_init(&a->lock,NULL);
+  pthread_cond_init(&a->cond,NULL);
+  for(int i=0; i < SPECTRUM_TASKS; i++){
+    a->task[i].avg = a;
+    a->task[i].work.arg = &a->task[i];
+  }
+  return a;
+}
+
+static void delete_spectrum_avg(struct spectrum_avg **ap){
+  struct spectrum_avg * const a = *ap;
+  if(a == NULL)
+    return;
+  *ap = NULL;
+  for(int i=0; i < SPECTRUM_TASKS; i++){
+    fftwf_free(a->task[i].in);
+    fftwf_free(a->task[i].out);
+    fftwf_free(a->task[i].sum);
+  }
+  fftwf_free(a->power);
+  fftwf_free(a->quantile);
+  fftwf_free(a->store);
+  fftwf_free(a->total);
+  FREE(a->key);
+  pthread_cond_destroy(&a->cond);
+  pthread_mutex_destroy(&a->lock);
+  free(a);
+}
+
+// Keep these simple so the compiler vectorizes them
+static inline void window_real(float * restrict out,float const * restrict in,float const * restrict window,int n){
+  for(int i=0; i < n; i++)
+    out[i] = window[i] * in[i];
+}
+static inline void window_complex(float complex * restrict out,float complex const * restrict in,float const * restrict window,int n){
+  float * restrict const o = (float *)out;
+  float const * restrict const x = (float const *)in;
+  for(int i=0; i < n; i++){
+    o[2*i] = window[i] * x[2*i];
+    o[2*i+1] = window[i] * x[2*i+1];
+  }
+}
+static inline void accumulate_power(float * restrict sum,float complex const * restrict in,int n){
+  float const * restrict const x = (float const *)in;
+  for(int i=0; i < n; i++)
+    sum[i] += x[2*i] * x[2*i] + x[2*i+1] * x[2*i+1];
+}
+static inline void peak_power(float * restrict peak,float complex const * restrict in,int n){
+  float const * restrict const x = (float const *)in;
+  for(int i=0; i < n; i++)
+    peak[i] = fmaxf(peak[i],x[2*i] * x[2*i] + x[2*i+1] * x[2*i+1]);
+}
+static inline void min_power(float * restrict low,float complex const * restrict in,int n){
+  float const * restrict const x = (float const *)in;
+  for(int i=0; i < n; i++)
+    low[i] = fminf(low[i],x[2*i] * x[2*i] + x[2*i+1] * x[2*i+1]);
+}
+static inline void bin_power(float * restrict p,float complex const * restrict in,int n){
+  float const * restrict const x = (float const *)in;
+  for(int i=0; i < n; i++)
+    p[i] = x[2*i] * x[2*i] + x[2*i+1] * x[2*i+1];
+}
+/* Running estimate of the p'th quantile of each bin (stochastic approximation)
+   Each estimate moves up by a factor (1 + eta*p) when a new value is above it and down by (1 - eta*(1-p)) otherwise.
+   In the log domain those steps balance where a fraction p of the values lie below, and being multiplicative
+   they track weak and strong bins alike. Steady-state jitter is about eta*4.3 dB
+*/
+#define QUANTILE_ETA 0.05f
+static inline void update_quantile(float * restrict q,float const * restrict x,int n,float p){
+  float const up = 1 + QUANTILE_ETA * p;
+  float const down = 1 - QUANTILE_ETA * (1 - p);
+  for(int i=0; i < n; i++)
+    q[i] = q[i] > 0 ? q[i] * (x[i] > q[i] ? up : down) : x[i]; // Start with the first value
+}
+
+// Window and transform the fft_n samples at ring index pos into t->out
+static void window_fft(struct spectrum_avg const *a,struct avg_task *t,int pos){
+  int const fft_n = a->fft_n;
+  // Contiguous unless it wraps around a ring that isn't mirrored
+  int const first = (a->mirrored || pos + fft_n <= a->ring_size) ? fft_n : a->ring_size - pos;
+  if(a->real){
+    float const *ring = a->ring;
+    window_real(t->in,ring + pos,a->window,first);
+    window_real((float *)t->in + first,ring,a->window + first,fft_n - first);
+    fftwf_execute_dft_r2c(a->plan,t->in,t->out);
+  } else {
+    float complex const *ring = a->ring;
+    window_complex(t->in,ring + pos,a->window,first);
+    window_complex((float complex *)t->in + first,ring,a->window + first,fft_n - first);
+    fftwf_execute_dft(a->plan,t->in,t->out);
+  }
+}
+
+/* The FFTs of a poll are shared out one at a time: each call of a task takes the next one, so an FFT worker
+   goes back to its forward FFTs after each, and whoever is free does more of them. Returns false when they're all taken */
+static bool task_done(struct avg_task *t){
+  struct spectrum_avg * const a = t->avg;
+  pthread_mutex_lock(&a->lock);
+  if(--a->pending == 0)
+    pthread_cond_signal(&a->cond);
+  pthread_mutex_unlock(&a->lock);
+  return false;
+}
+
+static bool avg_task(void *arg){
+  struct avg_task * const t = arg;
+  struct spectrum_avg * const a = t->avg;
+  int const iter = atomic_fetch_add_explicit(&a->next_iter,1,memory_order_relaxed);
+  if(iter >= a->count)
+    return task_done(t);
+  window_fft(a,t,(a->start + iter * a->stride) % a->ring_size);
+  switch(a->detector){
+  default:
+    accumulate_power(t->sum,t->out,a->bins);
+    break;
+  case DETECT_PEAK:
+    peak_power(t->sum,t->out,a->bins);
+    break;
+  case DETECT_MIN:
+    min_power(t->sum,t->out,a->bins);
+    break;
+  case DETECT_PERCENTILE:
+    // The estimates are shared, but updating them is cheap next to the FFT
+    bin_power(t->sum,t->out,a->bins);
+    pthread_mutex_lock(&a->lock);
+    update_quantile(a->quantile,t->sum,a->bins,a->percentile);
+    pthread_mutex_unlock(&a->lock);
+    break;
+  }
+  return true;
+}
+
+// Compute FFT next_key + (the next iter) of the sliding window into its slot
+static bool slide_task(void *arg){
+  struct avg_task * const t = arg;
+  struct spectrum_avg * const a = t->avg;
+  int const iter = atomic_fetch_add_explicit(&a->next_iter,1,memory_order_relaxed);
+  if(iter >= a->count)
+    return task_done(t);
+  int64_t const k = a->next_key + iter;
+  int64_t pos = a->write - (a->newest - k * a->stride); // Ring index of FFT k
+  pos %= a->ring_size;
+  if(pos < 0)
+    pos += a->ring_size;
+  window_fft(a,t,(int)pos);
+  float * const p = a->store + (k % a->fft_avg) * a->bins;
+  bin_power(p,t->out,a->bins);
+  if(a->detector == DETECT_PERCENTILE){
+    // Each FFT now goes into the estimates only once
+    pthread_mutex_lock(&a->lock);
+    update_quantile(a->quantile,p,a->bins,a->percentile);
+    pthread_mutex_unlock(&a->lock);
+  }
+  return true;
+}
+
+// Run func on ntasks tasks: ntasks-1 FFT workers and us. Returns when all a->count FFTs are done
+static void run_tasks(struct spectrum_avg *a,bool (*func)(void *),int ntasks){
+  atomic_store_explicit(&a->next_iter,0,memory_order_relaxed);
+  a->pending = ntasks;
+  for(int i=1; i < ntasks; i++){
+    a->task[i].work.func = func;
+    submit_fft_work(&a->task[i].work);
+  }
+  while((*func)(&a->task[0]))
+    ; // Our share, however much that turns out to be
+
+  pthread_mutex_lock(&a->lock);
+  while(a->pending > 0)
+    pthread_cond_wait(&a->cond,&a->lock);
+  pthread_mutex_unlock(&a->lock);
+}
+
+// Sliding window version of average_spectrum()
+static void slide_spectrum(struct spectrum_avg *a,float *result,double gain){
+  int const bins = a->bins;
+  int const fft_avg = a->fft_avg;
+  if(a->store_fft_n != a->fft_n || a->store_bins != bins || a->store_avg != fft_avg || a->store_stride != a->stride
+     || a->store_window != a->window || a->store_detector != a->detector){
+    // Start over
+    fftwf_free(a->store);
+    fftwf_free(a->total);
+    FREE(a->key);
+    a->store = fftwf_alloc_real((size_t)fft_avg * bins);
+    a->total = fftwf_alloc_real(bins);
+    a->key = malloc(fft_avg * sizeof *a->key);
+    assert(a->store != NULL && a->total != NULL && a->key != NULL);
+    for(int i=0; i < fft_avg; i++)
+      a->key[i] = -1;
+    memset(a->total,0,bins * sizeof *a->total);
+    a->last_key = -1;
+    a->since_sum = 0;
+    a->store_fft_n = a->fft_n;
+    a->store_bins = bins;
+    a->store_avg = fft_avg;
+    a->store_stride = a->stride;
+    a->store_window = a->window;
+    a->store_detector = a->detector;
+  }
+  if(a->newest < a->fft_n){
+    memset(result,0,bins * sizeof *result); // Not even one yet
+    return;
+  }
+  // The window is the newest fft_avg FFTs that are complete
+  int64_t const last = (a->newest - a->fft_n) / a->stride;
+  int64_t first = last - fft_avg + 1 > 0 ? last - fft_avg + 1 : 0;
+  int64_t const oldest = (a->newest - a->ring_size + a->stride - 1) / a->stride; // Still in the ring
+  if(first < oldest)
+    first = oldest;
+  a->next_key = a->last_key + 1 > first ? a->last_key + 1 : first;
+  int const count = a->next_key <= last ? (int)(last - a->next_key + 1) : 0;
+  bool const resum = a->since_sum + count >= fft_avg; // Cheaper than adding and subtracting, and ends any drift
+  if(a->detector == DETECT_AVERAGE && !resum){
+    // Out with the ones they replace
+    for(int64_t k = a->next_key; k <= last; k++){
+      int const slot = k % fft_avg;
+      if(a->key[slot] >= 0){
+	float const * restrict const p = a->store + slot * bins;
+	for(int i=0; i < bins; i++)
+	  a->total[i] -= p[i];
+      }
+    }
+  }
+  if(count > 0){
+    int ntasks = N_worker_threads + 1; // Workers plus us
+    if(ntasks > SPECTRUM_TASKS)
+      ntasks = SPECTRUM_TASKS;
+    if(ntasks > count)
+      ntasks = count;
+    for(int i=0; i < ntasks; i++){
+      struct avg_task * const t = &a->task[i];
+      if(t->size != a->fft_n){
+	fftwf_free(t->in);
+	fftwf_free(t->out);
+	fftwf_free(t->sum);
+	t->in = fftwf_alloc_complex(a->fft_n);
+	t->out = fftwf_alloc_complex(a->fft_n);
+	t->sum = fftwf_alloc_real(a->fft_n);
+	assert(t->in != NULL && t->out != NULL && t->sum != NULL);
+	t->size = a->fft_n;
+      }
+    }
+    a->count = count;
+    run_tasks(a,slide_task,ntasks);
+    for(int64_t k = a->next_key; k <= last; k++)
+      a->key[k % fft_avg] = k;
+    a->last_key = last;
+  }
+  if(a->detector == DETECT_AVERAGE){
+    if(resum){
+      memset(a->total,0,bins * sizeof *a->total);
+      for(int slot=0; slot < fft_avg; slot++){
+	if(a->key[slot] < first)
+	  continue; // None yet (or left over, which can't happen once resummed)
+	float const * restrict const p = a->store + slot * bins;
+	for(int i=0; i < bins; i++)
+	  a->total[i] += p[i];
+      }
+      a->since_sum = 0;
+    } else {
+      for(int64_t k = a->next_key; k <= last; k++){
+	float const * restrict const p = a->store + (k % fft_avg) * bins;
+	for(int i=0; i < bins; i++)
+	  a->total[i] += p[i];
+      }
+      a->since_sum += count;
+    }
+  }
+  int const n = (int)(last - first + 1); // Less than fft_avg only at the very start
+  switch(a->detector){
+  default:
+    for(int i=0; i < bins; i++)
+      result[i] = a->total[i] > 0 ? (float)(gain * a->total[i] / n) : 0; // Rounding can leave it slightly negative
+    break;
+  case DETECT_PEAK:
+  case DETECT_MIN:
+    {
+      bool const peak = a->detector == DETECT_PEAK;
+      for(int i=0; i < bins; i++)
+	result[i] = peak ? 0 : INFINITY;
+      for(int slot=0; slot < fft_avg; slot++){
+	if(a->key[slot] < first)
+	  continue;
+	float const * restrict const p = a->store + slot * bins;
+	if(peak){
+	  for(int i=0; i < bins; i++)
+	    result[i] = fmaxf(result[i],p[i]);
+	} else {
+	  for(int i=0; i < bins; i++)
+	    result[i] = fminf(result[i],p[i]);
+	}
+      }
+      for(int i=0; i < bins; i++)
+	result[i] = isfinite(result[i]) ? (float)(gain * result[i]) : 0;
+    }
+    break;
+  case DETECT_PERCENTILE:
+    for(int i=0; i < bins; i++)
+      result[i] = isfinite(a->quantile[i]) ? (float)(gain * a->quantile[i]) : 0;
+    break;
+  }
+}
+
+// Combine a->fft_avg power spectra into result[a->bins] with a->detector, scaled by gain
+// gain is for a single FFT; the average is taken here
+static void average_spectrum(struct spectrum_avg *a,float *result,double gain){
+  if(a->detector == DETECT_PERCENTILE && a->quantile_size != a->bins){
+    fftwf_free(a->quantile);
+    a->quantile = fftwf_alloc_real(a->bins);
+    assert(a->quantile != NULL);
+    memset(a->quantile,0,a->bins * sizeof *a->quantile); // Restart the estimates
+    a->quantile_size = a->bins;
+  }
+  if(a->sliding && a->stride > 0 && (size_t)a->fft_avg * a->bins * sizeof(float) <= SLIDING_MAX_BYTES){
+    slide_spectrum(a,result,gain);
+    return;
+  }
+  int ntasks = N_worker_threads + 1; // Workers plus us
+  if(ntasks > SPECTRUM_TASKS)
+    ntasks = SPECTRUM_TASKS;
+  if(ntasks > a->fft_avg)
+    ntasks = a->fft_avg;
+  if(a->start < 0)
+    a->start += a->ring_size;
+
+  for(int i=0; i < ntasks; i++){
+    struct avg_task * const t = &a->task[i];
+    if(t->size != a->fft_n){
+      // (Re)allocate persistent buffers, big enough for complex input
+      fftwf_free(t->in);
+      fftwf_free(t->out);
+      fftwf_free(t->sum);
+      t->in = fftwf_alloc_complex(a->fft_n);
+      t->out = fftwf_alloc_complex(a->fft_n);
+      t->sum = fftwf_alloc_real(a->fft_n);
+      assert(t->in != NULL && t->out != NULL && t->sum != NULL);
+      t->size = a->fft_n;
+    }
+    if(a->detector == DETECT_MIN){
+      for(int k=0; k < a->bins; k++)
+	t->sum[k] = INFINITY;
+    } else
+      memset(t->sum,0,a->bins * sizeof *t->sum);
+  }
+  a->count = a->fft_avg;
+  run_tasks(a,avg_task,ntasks);
+
+  for(int k=0; k < a->bins; k++){
+    float s;
+    switch(a->detector){
+    default:
+      s = 0;
+      for(int i=0; i < ntasks; i++)
+	s += a->task[i].sum[k];
+      s /= a->fft_avg;
+      break;
+    case DETECT_PEAK:
+      s = 0;
+      for(int i=0; i < ntasks; i++)
+	s = fmaxf(s,a->task[i].sum[k]);
+      break;
+    case DETECT_MIN:
+      s = INFINITY;
+      for(int i=0; i < ntasks; i++)
+	s = fminf(s,a->task[i].sum[k]);
+      break;
+    case DETECT_PERCENTILE:
+      s = a->quantile[k];
+      break;
+    }
+    result[k] = isfinite(s) ? (float)(gain * s) : 0; // Don't pollute with infinities or NANs
+  }
+}
+
 static void narrowband_poll(chan_t *chan){
   // Narrowband mode poll
-
-  if(chan->spectrum.ring == NULL)
+  bool const direct = use_direct(chan);
+  if(direct ? chan->baseband == NULL : chan->spectrum.ring == NULL)
       return; // Needed
 
   struct frontend const * restrict const frontend = chan->frontend;
@@ -221,88 +712,252 @@ static void narrowband_poll(chan_t *chan){
   if(chan->spectrum.plan == NULL)
     setup_complex_fft(chan); // narrowband always uses complex
 
-  fftwf_plan restrict const plan = chan->spectrum.plan;
-  assert(plan != NULL);
+  assert(chan->spectrum.plan != NULL);
 
   if(chan->spectrum.window == NULL)
     generate_window(chan);
 
-  float const * restrict const window = chan->spectrum.window;
-
-  // Most recent data from receive ring buffer
-  float complex const * restrict const ring = chan->spectrum.ring;
-  int const ring_size = chan->spectrum.ring_size;
+  // Most recent data from receive ring buffer, or the current filter output block
+  int const ring_size = direct ? chan->sampcount : chan->spectrum.ring_size;
   int const fft_n = chan->spectrum.fft_n;
   assert(fft_n > 0); // should be set by narrowband_setup()
-  float complex * restrict fft_in = fftwf_alloc_complex(fft_n);
-  assert(fft_in != NULL);
-  float complex * restrict fft_out = fftwf_alloc_complex(fft_n);
-  assert(fft_out != NULL);
 
   // This check actually isn't necessary because ring_size is calculated from fft_avg assuming no overlap
+  // (or, when direct, use_direct() checked that they all fit)
   assert(chan->spectrum.fft_avg >= 1);
   double const avg_limit = floor(1 + (( ring_size / fft_n) - 1) / (1-chan->spectrum.overlap));
   assert(chan->spectrum.fft_avg <= avg_limit);  // so the assertion shouldn't fail
   int const fft_avg = chan->spectrum.fft_avg > avg_limit ? lrint(avg_limit) : chan->spectrum.fft_avg;
-  int rp = chan->spectrum.ring_idx - lrint(fft_n * (1 + (fft_avg - 1)*(1-chan->spectrum.overlap)));
-  if(rp < 0)
-    rp += ring_size;
-  assert(rp >= 0); // with limit, shouldn't wrap more than once
+
+  if(chan->spectrum.avg == NULL)
+    chan->spectrum.avg = create_spectrum_avg();
+  struct spectrum_avg * const a = chan->spectrum.avg;
+  if(a->power_size != fft_n){
+    fftwf_free(a->power);
+    a->power = fftwf_alloc_real(fft_n);
+    assert(a->power != NULL);
+    a->power_size = fft_n;
+  }
+  a->plan = chan->spectrum.plan;
+  a->window = chan->spectrum.window;
+  a->fft_n = fft_n;
+  a->real = false;
+  a->bins = fft_n;
+  a->ring = direct ? chan->baseband : chan->spectrum.ring;
+  a->ring_size = ring_size;
+  a->mirrored = !direct; // The ring is; the block isn't, but use_direct() made sure it's read within its bounds
+  a->stride = fft_n - lrint(fft_n * chan->spectrum.overlap);
+  a->start = (direct ? chan->sampcount : chan->spectrum.ring_idx) - lrint(fft_n * (1 + (fft_avg - 1)*(1-chan->spectrum.overlap)));
+  a->fft_avg = fft_avg;
+  a->detector = fft_detector(chan);
+  a->percentile = chan->spectrum.percentile / 100;
+  a->sliding = !direct; // Each block is all new anyway
+  a->newest = chan->spectrum.ring_count;
+  a->write = chan->spectrum.ring_idx;
+  assert(a->start >= -ring_size); // with limit, shouldn't wrap more than once
 
   // scale each bin value for our FFT
   // squared because the we're scaling the output of complex norm, not the input bin values
   // Unlike wideband, no adjustment for a real front end because the downconverter corrects the gain
-  double const gain = 1.0 / ((double)fft_n * fft_n * fft_avg);
-
-  for(int iter=0; iter < fft_avg; iter++){
-    // Copy and window raw baseband
-    for(int i = 0; i < fft_n; i++){
-      assert(rp >= 0 && rp < ring_size);
-      fft_in[i] = ring[rp++] * window[i];
-      if(rp >= ring_size)
-	rp -= ring_size;
-    }
-    fftwf_execute_dft(plan,fft_in,fft_out);
-    // DC to Nyquist-1, then -Nyquist to -1
-    int fr = 0;
-    for(int i=0; i < bin_count; i++){
-      if(i == bin_count/2)
-	fr = fft_n - i; // skip over excess FFT bins at edges
-      assert(fr >= 0 && fr < fft_n);
-      double const p = cnrm((double complex)fft_out[fr++]); // use double for improved accuracy when summing?
-      assert(isfinite(p));
-      if(isfinite(p))
-	bin_data[i] += gain * p; // Don't pollute with infinities or NANs
-    }
-    // rp now points to *next* buffer, so move it back if there's overlap
-    rp -= lrint(fft_n * chan->spectrum.overlap);
-    if(rp < 0)
-      rp += ring_size;
-  }
-  fftwf_free(fft_in);
-  fftwf_free(fft_out);
-  double min_power = INFINITY;
-  double max_power = 0;
+  double const gain = 1.0 / ((double)fft_n * fft_n);
+  average_spectrum(a,a->power,gain);
 
-  // scaling for byte bin format
+  // DC to Nyquist-1, then -Nyquist to -1
+  int fr = 0;
   for(int i=0; i < bin_count; i++){
-    if(bin_data[i] < min_power)
-      min_power = bin_data[i];
-    if(bin_data[i] > max_power)
-      max_power = bin_data[i];
+    if(i == bin_count/2)
+      fr = fft_n - i; // skip over excess FFT bins at edges
+    assert(fr >= 0 && fr < fft_n);
+    bin_data[i] = a->power[fr++];
   }
-  if(max_power > 0 && min_power > 0){
-#if SPECTRUM_CLIP
-    chan->spectrum.base = power2dB(chan->sig.n0 * chan->spectrum.noise_bw);
-#else
-    chan->spectrum.base = power2dB(min_power);
-#endif
-#if FIXED_STEP
-    chan->spectrum.step = 0.5; // 0.5 dB fixed
-#else
-    chan->spectrum.step = (1./256.) * (power2dB(max_power) - chan->spectrum.base); // dB range
-#endif
+  apply_hold(chan);
+  set_level_scale(chan);
+}
+
+/* Shared wideband spectrum engine
+   Wideband spectrum channels on the same front end with the same FFT size, window, overlap and averaging
+   (e.g., several web clients watching the same band) share one set of FFTs over the A/D ring.
+   The engine computes the averaged power spectrum of the whole front end bandwidth on its own thread,
+   at most once per block time, whenever some channel asks for it. Each channel then copies out the bins around its own center
+*/
+struct spectrum_engine {
+  struct spectrum_engine *next;
+  int refs;            // Channels using it, protected by Engine_lock
+  // What's shared
+  struct frontend const *frontend;
+  int fft_n;
+  enum window_type window_type;
+  double shape;
+  double overlap;
+  int fft_avg;
+  enum spectrum_detector detector;
+  double percentile;
+
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;   // Requests to the engine thread and results from it
+  bool busy;             // Computation requested or in progress
+  bool stop;
+  int64_t result_time;   // When the current result was started, GPS ns
+  uint64_t sample_index; // frontend->samples at the start of its input
+  int bins;              // fft_n/2+1 for real front ends, fft_n for complex
+  float *power;          // Current result, FFT order (DC first), scaled like bin_data
+  float *work;           // Result being computed
+  float const *window;   // From the cache, like the plan
+  fftwf_plan plan;
+  struct spectrum_avg *avg;
+};
+static struct spectrum_engine *Engines;
+static pthread_mutex_t Engine_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static bool engine_matches(struct spectrum_engine const *e,chan_t const *chan){
+  return e->frontend == chan->frontend
+    && e->fft_n == chan->spectrum.fft_n
+    && e->window_type == chan->spectrum.window_type
+    && (e->shape == chan->spectrum.shape || (e->window_type != KAISER_WINDOW && e->window_type != GAUSSIAN_WINDOW))
+    && e->overlap == chan->spectrum.overlap
+    && e->fft_avg == chan->spectrum.fft_avg
+    && e->detector == fft_detector(chan)
+    && (e->percentile == chan->spectrum.percentile || e->detector != DETECT_PERCENTILE);
+}
+
+// Compute the averaged power spectrum of the newest data in the A/D ring into e->work
+static void engine_compute(struct spectrum_engine *e){
+  struct frontend const * restrict const frontend = e->frontend;
+  struct spectrum_avg * const a = e->avg;
+  int const fft_n = e->fft_n;
+  int const fft_avg = e->fft_avg;
+  int const adjust = lrint(fft_n * (1 + (fft_avg - 1)*(1-e->overlap)));
+  // Read the count once and derive the write position from it; the front end keeps writing.
+  // frontend->samples won't do, drivers update it before or after the pointer as they please
+  uint64_t const samples = atomic_load_explicit(&frontend->in.written,memory_order_acquire);
+  e->sample_index = samples - adjust;
+
+  // Read the newest data from the A/D ring buffer, which is mirrored so an FFT can run past its end
+  a->plan = e->plan;
+  a->window = e->window;
+  a->fft_n = fft_n;
+  a->real = frontend->isreal;
+  a->bins = e->bins;
+  a->ring = frontend->in.input_buffer;
+  a->mirrored = true;
+  a->stride = lrint(fft_n * (1. - e->overlap)); // move forward fraction of a buffer
+  a->fft_avg = fft_avg;
+  a->detector = e->detector;
+  a->percentile = e->percentile / 100;
+  a->sliding = true;
+  a->newest = samples;
+  if(frontend->isreal){
+    a->ring_size = frontend->in.input_buffer_size / sizeof(float);
+    a->write = (frontend->in.impulse_length - 1 + samples) % a->ring_size; // Where create_filter_input() started writing
+    a->start = a->write - adjust;
+    // An inverted spectrum is handled when the bins are copied out
+    // +3dB to include the virtual conjugate spectrum
+    average_spectrum(a,e->work,2./((double)fft_n * fft_n));
+  } else {
+    a->ring_size = frontend->in.input_buffer_size / sizeof(float complex);
+    a->write = (frontend->in.impulse_length - 1 + samples) % a->ring_size; // Where create_filter_input() started writing
+    a->start = a->write - adjust;
+    average_spectrum(a,e->work,1./((double)fft_n * fft_n));
+  }
+}
+
+static void *engine_thread(void *arg){
+  struct spectrum_engine * const e = arg;
+  pthread_setname("spect eng");
+
+  pthread_mutex_lock(&e->lock);
+  while(true){
+    while(!e->busy && !e->stop)
+      pthread_cond_wait(&e->cond,&e->lock);
+    if(e->stop)
+      break;
+    pthread_mutex_unlock(&e->lock);
+    int64_t const start = gps_time_ns();
+    engine_compute(e);
+    pthread_mutex_lock(&e->lock);
+    float *tmp = e->power;
+    e->power = e->work;
+    e->work = tmp;
+    e->result_time = start;
+    e->busy = false;
+    pthread_cond_broadcast(&e->cond);
+  }
+  pthread_mutex_unlock(&e->lock);
+  return NULL;
+}
+
+// Find or create an engine for this channel's parameters
+static struct spectrum_engine *attach_engine(chan_t const *chan){
+  pthread_mutex_lock(&Engine_lock);
+  struct spectrum_engine *e;
+  for(e = Engines; e != NULL; e = e->next){
+    if(engine_matches(e,chan))
+      break;
+  }
+  if(e == NULL){
+    e = calloc(1,sizeof *e);
+    assert(e != NULL);
+    e->frontend = chan->frontend;
+    e->fft_n = chan->spectrum.fft_n;
+    e->window_type = chan->spectrum.window_type;
+    e->shape = chan->spectrum.shape;
+    e->overlap = chan->spectrum.overlap;
+    e->fft_avg = chan->spectrum.fft_avg;
+    e->detector = fft_detector(chan);
+    e->percentile = chan->spectrum.percentile;
+    e->bins = e->frontend->isreal ? e->fft_n/2 + 1 : e->fft_n;
+    e->power = calloc(e->bins,sizeof *e->power);
+    e->work = calloc(e->bins,sizeof *e->work);
+    assert(e->power != NULL && e->work != NULL);
+    e->window = attach_window(e->window_type,e->shape,e->fft_n,NULL);
+    e->plan = attach_plan(e->fft_n,e->frontend->isreal);
+    assert(e->window != NULL && e->plan != NULL);
+    e->avg = create_spectrum_avg();
+    e->result_time = INT64_MIN;
+    pthread_mutex_init(&e->lock,NULL);
+    pthread_cond_init(&e->cond,NULL);
+    pthread_create(&e->thread,NULL,engine_thread,e);
+    e->next = Engines;
+    Engines = e;
+    if(Verbose > 1)
+      fprintf(stderr,"new wide spectrum engine: fft size %d, window %d, avg %d\n",e->fft_n,e->window_type,e->fft_avg);
+  }
+  e->refs++;
+  pthread_mutex_unlock(&Engine_lock);
+  return e;
+}
+
+static void release_engine(struct spectrum_engine **ep){
+  struct spectrum_engine * const e = *ep;
+  if(e == NULL)
+    return;
+  *ep = NULL;
+  pthread_mutex_lock(&Engine_lock);
+  if(--e->refs > 0){
+    pthread_mutex_unlock(&Engine_lock);
+    return;
   }
+  for(struct spectrum_engine **pp = &Engines; *pp != NULL; pp = &(*pp)->next){
+    if(*pp == e){
+      *pp = e->next;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&Engine_lock);
+  pthread_mutex_lock(&e->lock);
+  e->stop = true;
+  pthread_cond_broadcast(&e->cond);
+  pthread_mutex_unlock(&e->lock);
+  pthread_join(e->thread,NULL);
+  release_plan(&e->plan);
+  delete_spectrum_avg(&e->avg);
+  pthread_cond_destroy(&e->cond);
+  pthread_mutex_destroy(&e->lock);
+  FREE(e->power);
+  FREE(e->work);
+  release_window(&e->window);
+  free(e);
 }
 
 static void wideband_poll(chan_t *chan){
@@ -322,203 +977,217 @@ static void wideband_poll(chan_t *chan){
   int const fft_n = chan->spectrum.fft_n;
   assert(fft_n > 0); // should be set by setup_wideband()
 
-  if(chan->spectrum.plan == NULL){
-    if(chan->frontend->isreal)
-      setup_real_fft(chan);
-    else
-      setup_complex_fft(chan);
-  }
-  fftwf_plan restrict const plan = chan->spectrum.plan;
-  assert(plan != NULL);
-
   // should be set up just before we were called
   int const bin_count = chan->spectrum.bin_count;
   float * restrict const bin_data = chan->spectrum.bin_data;
   assert(bin_count > 0 && bin_data != NULL);
   memset(bin_data,0, bin_count * sizeof *bin_data); // zero output data
 
+  // Limit averaging to amount on hand. also done in radio_status.c, belt and suspenders for now
+  size_t const sample_size = frontend->isreal ? sizeof (float) : sizeof (float complex);
+  double const avg_limit = floor(1 + ((frontend->in.input_buffer_size / (sample_size * fft_n)) - 1) / (1-chan->spectrum.overlap));
+  if((double)chan->spectrum.fft_avg > avg_limit)
+    chan->spectrum.fft_avg = (int)avg_limit;
+  assert(chan->spectrum.fft_avg >= 1);
+
   if(chan->spectrum.window == NULL)
     generate_window(chan);
-  float const * restrict const window = chan->spectrum.window;
-  assert(window != NULL);
+  assert(chan->spectrum.window != NULL);
+
+  if(chan->spectrum.engine != NULL && !engine_matches(chan->spectrum.engine,chan))
+    release_engine(&chan->spectrum.engine);
+  if(chan->spectrum.engine == NULL)
+    chan->spectrum.engine = attach_engine(chan);
+  struct spectrum_engine * const e = chan->spectrum.engine;
 
   // Asynchronously read newest data from input buffer
   // scale fft bin shift down to size of analysis FFT, which is smaller than the input FFT
   int const shift = (int)(chan->filter.bin_shift * (int64_t)fft_n / master->points);
 
-  // scale each bin value for our FFT
-  // squared because the we're scaling the output of complex norm, not the input bin values
-  // we only see one side of the spectrum for real inputs
-  // Limit averaging to the data on hand
-
+  // Use the engine's current result if it's no more than a block old, otherwise get a new one
+  int64_t const oldest = gps_time_ns() - (int64_t)(Blocktime * BILLION);
+  pthread_mutex_lock(&e->lock);
+  while(e->result_time < oldest){
+    if(!e->busy){
+      e->busy = true;
+      pthread_cond_broadcast(&e->cond);
+    }
+    pthread_cond_wait(&e->cond,&e->lock);
+  }
+  float const * restrict const power = e->power;
+  chan->filter.out.sample_index = e->sample_index; // since it's not done by a filter output route
   if(frontend->isreal){
-    // Point into raw SDR A/D input ring buffer
-    // We're reading from a mirrored buffer so it will automatically wrap back to the beginning
-    // as long as it doesn't go past twice the buffer length
-    // Limit averaging to amount on hand. also done in radio_status.c, belt and suspenders for now
-    double const avg_limit = floor(1 + ((frontend->in.input_buffer_size / (sizeof (float) * fft_n)) - 1) / (1-chan->spectrum.overlap));
-    if((double)chan->spectrum.fft_avg > avg_limit)
-      chan->spectrum.fft_avg = (int)avg_limit;
-    int const fft_avg = chan->spectrum.fft_avg;
-    assert(fft_avg >= 1);
-    int const adjust = lrint(fft_n * (1 + (fft_avg - 1)*(1-chan->spectrum.overlap)));
-    chan->filter.out.sample_index = frontend->samples - adjust; // since it's not done by a filter output route
-    float const *input = frontend->in.input_write_pointer.r - adjust;
-    while(input < (float *)frontend->in.input_buffer)
-      input += frontend->in.input_buffer_size / sizeof *input; // bring it back into the buffer
-    float * restrict fft_in = fftwf_alloc_real(fft_n);
-    assert(fft_in != NULL);
-    float complex * restrict fft_out = fftwf_alloc_complex(fft_n/2 + 1); // r2c has only the positive frequencies
-    assert(fft_out != NULL);
-    double const gain = 2./(double)((int64_t)fft_avg * fft_n * fft_n); // +3dB to include the virtual conjugate spectrum
-    for(int iter=0; iter < fft_avg; iter++){
-      // Copy and window raw A/D
-      if(shift >= 0){
-	// Upright spectrum
-	for(int i=0; i < fft_n; i++)
-	  fft_in[i] = window[i] * input[i];
-      } else {
-	// Invert spectrum by flipping sign of every other sample - UNTESTED
-	// equivalent to multiplication by a sinusoid at the Nyquist rate
-	// If FFT N is odd, just forget the odd last sample.
-	// We don't have to track the sign flip phase because we're only summing energy
-	for(int i=0; i < fft_n-1; i += 2){
-	  fft_in[i] = window[i] * input[i];
-	  fft_in[i+1] = -window[i+1] * input[i+1];
-	}
-	if(fft_n & 1)
-	  fft_in[fft_n-1] = 0;
-      }
-      fftwf_execute_dft_r2c(plan,fft_in,fft_out);
-
-      // Spectrum is always right side up
-      // Start with DC + positive frequencies, then wrap to negative
-      int binp = shift >= 0 ? shift : fft_n/2 + shift; // what if fft_n is odd?
-      assert(binp >= 0);
-      for(int i=0;i < bin_count && binp < fft_n/2+1 ; i++,binp++){
-	if(i == bin_count/2)
-	  binp -= bin_count; // crossed into negative output rang, Wrap input back to lowest frequency requested
-
-	double const p = cnrm(fft_out[binp]);
-	assert(isfinite(p));
-	if(isfinite(p))
-	  bin_data[i] += gain * p;
-      }
-      input += lrint(fft_n * (1. - chan->spectrum.overlap)); // move forward fraction of a buffer
-      if(input > (float *)frontend->in.input_buffer + frontend->in.input_buffer_size / sizeof *input)
-	input -= frontend->in.input_buffer_size / sizeof *input;
+    // Spectrum is always right side up
+    // Start with DC + positive frequencies, then wrap to negative
+    // An inverted spectrum (shift < 0) would have been flipped by negating every other input sample,
+    // which swaps bin k with bin fft_n/2 - k
+    int binp = shift >= 0 ? shift : fft_n/2 + shift; // what if fft_n is odd?
+    assert(binp >= 0);
+    for(int i=0;i < bin_count && binp < fft_n/2+1 ; i++,binp++){
+      if(i == bin_count/2)
+	binp -= bin_count; // crossed into negative output rang, Wrap input back to lowest frequency requested
+      if(binp < 0)
+	continue; // Below the front end's coverage
+      bin_data[i] = shift >= 0 ? power[binp] : power[fft_n/2 - binp];
     }
-    fftwf_free(fft_in);
-    fftwf_free(fft_out);
   } else {
-    // Complex front end (frontend->isreal == false)
-    // Find starting points to read in input A/D stream
-    // Limit averaging to amount on hand
-    double const avg_limit = floor(1 + ((frontend->in.input_buffer_size / (sizeof (float complex) * fft_n)) - 1) / (1-chan->spectrum.overlap));
-    if((double)chan->spectrum.fft_avg > avg_limit)
-      chan->spectrum.fft_avg = (int)avg_limit;
-    int const fft_avg = chan->spectrum.fft_avg;
-    assert(fft_avg >= 1);
-    int const adjust = lrint(fft_n * (1 + (fft_avg - 1)*(1-chan->spectrum.overlap)));
-    chan->filter.out.sample_index = frontend->samples - adjust; // since it's not done by a filter output route
-    float complex const * restrict input = frontend->in.input_write_pointer.c - adjust;
-    chan->filter.out.sample_index = frontend->samples; // since it's not done by a filter output route
-    input += (input < (float complex *)frontend->in.input_buffer) ? frontend->in.input_buffer_size / sizeof *input : 0; // backward wrap
-    float complex * restrict fft_in = fftwf_alloc_complex(fft_n);
-    assert(fft_in != NULL);
-    float complex * restrict fft_out = fftwf_alloc_complex(fft_n);
-    assert(fft_out != NULL);
-    double const gain = 1./(double)((int64_t)fft_avg * fft_n * fft_n); // check this
-    for(int iter=0; iter < fft_avg; iter++){
-      // Copy and window raw A/D
-      for(int i=0; i < fft_n; i++)
-	fft_in[i] = window[i] * input[i];
-
-      fftwf_execute_dft(plan,fft_in,fft_out);
-
-#if 0 // another KA9Q fix attempt
-      int i = bin_count/2; // most negative output bin
-      int binp = shift - bin_count/2; // most negative input bin needed
-      if(binp > fft_n/2)
-	break; // Already past upper end of input
-      if(binp < 0)
-	binp += fft_n; // starts in negative input frequencies
-
-      if(binp < 0){
-	// below lowest input frequency. Skip a bit, brother
-	i -= binp;
-	binp = 0;
-	if(i >= bin_count)
-	  i -= bin_count; // crossed into positive output range
-	if(i >= bin_count)
-	  break; // still too high
-      }
-      do {
-	assert(binp >=0 && binp < fft_n);
-	assert(i >= 0 && i < bin_count);
-	double const p = cnrm(fft_out[binp]);
-	assert(isfinite(p));
-	if(isfinite(p)) // Don't pollute integrator with bad data
-	  bin_data[i] += gain * p;
-	if(++binp == fft_n)
-	  binp = 0; // wrap round to DC
-	if(++i == bin_count)
-	  i = 0;    // wrap to DC
-      } while (binp != fft_n/2 && i != bin_count/2);
-#else  // KE5GDB
-      /* Copy requested bins to user. Input and output are both in FFT order:
-	 bins 0 ... n/2-1 are DC and the positive frequencies, bins n/2 ... n-1 are the
-	 negative frequencies, most negative first. So output bin i sits at signed offset
-	 'offset' from the requested center frequency, which is itself at signed input bin
-	 'shift' from the front end's center frequency.
-	 Bins falling outside the front end's coverage are left at zero.
-	 (fixed by KE5GDB)
-      */
-      for(int i=0; i < bin_count; i++){
-	int const offset = i < bin_count/2 ? i : i - bin_count; // signed output frequency, bins
-	int const b = shift + offset;                           // signed input frequency, bins
-	if(b < -fft_n/2 || b >= (fft_n+1)/2)
-	  continue; // Outside the front end passband
-	int const binp = b >= 0 ? b : b + fft_n; // back to FFT order
-	assert(binp >= 0 && binp < fft_n);
-	double const p = cnrm(fft_out[binp]);
-	assert(isfinite(p));
-	if(isfinite(p))
-	  bin_data[i] += gain * p;
+    /* Copy requested bins to user. Input and output are both in FFT order:
+       bins 0 ... n/2-1 are DC and the positive frequencies, bins n/2 ... n-1 are the
+       negative frequencies, most negative first. So output bin i sits at signed offset
+       'offset' from the requested center frequency, which is itself at signed input bin
+       'shift' from the front end's center frequency.
+       Bins falling outside the front end's coverage are left at zero.
+       (fixed by KE5GDB)
+    */
+    for(int i=0; i < bin_count; i++){
+      int const offset = i < bin_count/2 ? i : i - bin_count; // signed output frequency, bins
+      int const b = shift + offset;                           // signed input frequency, bins
+      if(b < -fft_n/2 || b >= (fft_n+1)/2)
+	continue; // Outside the front end passband
+      int const binp = b >= 0 ? b : b + fft_n; // back to FFT order
+      assert(binp >= 0 && binp < fft_n);
+      bin_data[i] = power[binp];
+    }
+  }
+  pthread_mutex_unlock(&e->lock);
+
+  apply_hold(chan);
+  set_level_scale(chan);
+}
+
+/* Coarse wideband spectrum summed straight from the front end's forward FFT (see read_power_tap() in filter.c)
+   Costs almost nothing beyond the FFTs the downconverter already does, but the master FFT is unwindowed,
+   so strong signals leak farther than with the analysis windows. And the averaging time is the interval
+   since the last response; SPECTRUM_AVG and SPECTRUM_OVERLAP don't apply.
+   Only when asked (SPECTRUM_TAP) and the RBW is at least the master FFT's bin spacing
+*/
+static bool use_tap(chan_t const *chan){
+  struct frontend const * const frontend = chan->frontend;
+  if(!chan->spectrum.tap || frontend == NULL || frontend->in.points <= 0)
+    return false;
+  return chan->spectrum.rbw > chan->spectrum.crossover
+    && chan->spectrum.rbw >= frontend->samprate / (double)frontend->in.points;
+}
+
+/* Narrowband FFTs run straight on the downconverter's output block, without the ring, when asked (SPECTRUM_DIRECT)
+   and the block holds all SPECTRUM_AVG of them with their overlap. That takes an RBW of roughly 1/Blocktime per FFT
+   or more, e.g., 200 Hz for 4 FFTs at 50% overlap with 20 ms blocks. Otherwise the ring is used as usual
+*/
+static bool use_direct(chan_t const *chan){
+  if(!chan->spectrum.direct || chan->spectrum.rbw > chan->spectrum.crossover || chan->spectrum.fft_n <= 0)
+    return false;
+  int const fft_n = chan->spectrum.fft_n;
+  int const span = lrint(fft_n * (1 + (chan->spectrum.fft_avg - 1)*(1-chan->spectrum.overlap)));
+  return span <= chan->filter.out.olen;
+}
+
+static void tap_poll(chan_t *chan){
+  struct frontend const * restrict const frontend = chan->frontend;
+  struct filter_in * const master = chan->filter.out.master;
+  if(frontend == NULL || master == NULL)
+    return;
+
+  int const bin_count = chan->spectrum.bin_count;
+  float * restrict const bin_data = chan->spectrum.bin_data;
+  assert(bin_count > 0 && bin_data != NULL);
+  memset(bin_data,0, bin_count * sizeof *bin_data); // zero output data
+
+  int blocks = 0;
+  uint64_t sample_index = 0;
+  float const * restrict const power = read_power_tap(master,&blocks,&sample_index);
+  if(power != NULL){
+    chan->filter.out.sample_index = sample_index;
+    int const N = master->points;
+    double const hzperbin = frontend->samprate / (double)N;
+    double const width = chan->spectrum.rbw / hzperbin; // Master bins per output bin, >= 1
+    // Our center frequency relative to the front end's, in master bins, set by downconvert()
+    double const center = -(chan->tune.doppler + chan->tune.second_LO) / hzperbin;
+    /* Each block is an N-point transform, so a tone at a bin center comes out with |X|^2 = (amplitude * N)^2.
+       Blocks overlap by M-1 samples; that makes successive blocks correlated but doesn't change the expected power.
+       +3dB for real input to include the virtual conjugate spectrum, as in wideband mode */
+    double const gain = (frontend->isreal ? 2. : 1.) / ((double)blocks * N * N);
+    for(int i=0; i < bin_count; i++){
+      int const offset = i < bin_count/2 ? i : i - bin_count; // signed output frequency, bins, FFT order
+      // Master bin k covers [k, k+1) on this scale; sum the master bins under [lo, hi), partial ones at the edges
+      double const lo = center + (offset - 0.5) * width + 0.5;
+      double const hi = lo + width;
+      double sum = 0;
+      for(int k = (int)floor(lo); k < hi; k++){
+	int binp;
+	if(frontend->isreal){
+	  binp = abs(k); // Negative frequencies are images of positive ones
+	  if(binp >= master->bins)
+	    continue;
+	} else {
+	  if(k < -N/2 || k >= (N+1)/2)
+	    continue; // Outside the front end passband
+	  binp = k >= 0 ? k : k + N;
+	}
+	sum += (fmin(k + 1,hi) - fmax(k,lo)) * power[binp];
       }
-#endif
-      // Back to previous buffer
-      input -= lrint(fft_n * (1. - chan->spectrum.overlap));
-      if(input < (float complex *)frontend->in.input_buffer)
-	input += frontend->in.input_buffer_size / sizeof *input; // backward wrap
+      bin_data[i] = (float)(gain * sum);
     }
-    fftwf_free(fft_in);
-    fftwf_free(fft_out);
   }
+  unlock_power_tap(master);
+  apply_hold(chan);
+  set_level_scale(chan);
+}
+
+// What each poll computes for the channel's detector; the holds are done afterward by apply_hold()
+static enum spectrum_detector fft_detector(chan_t const *chan){
+  return chan->spectrum.detector == DETECT_MAX_AVERAGE ? DETECT_AVERAGE : chan->spectrum.detector;
+}
+
+/* Hold the highest (or lowest) value of each bin across responses for DETECT_PEAK, DETECT_MIN and DETECT_MAX_AVERAGE
+   The hold starts over when the channel is retuned or set up again, or the detector is sent again.
+   In tap mode each poll is an average, so DETECT_PEAK and DETECT_MIN hold averages
+*/
+static void apply_hold(chan_t *chan){
+  enum spectrum_detector const d = chan->spectrum.detector;
+  int const bin_count = chan->spectrum.bin_count;
+  float * restrict const bin_data = chan->spectrum.bin_data;
+  if(d != DETECT_PEAK && d != DETECT_MIN && d != DETECT_MAX_AVERAGE){
+    FREE(chan->spectrum.hold);
+    return;
+  }
+  if(chan->spectrum.hold == NULL || chan->spectrum.hold_freq != chan->tune.freq){
+    FREE(chan->spectrum.hold);
+    chan->spectrum.hold = malloc(bin_count * sizeof *chan->spectrum.hold);
+    assert(chan->spectrum.hold != NULL);
+    memcpy(chan->spectrum.hold,bin_data,bin_count * sizeof *chan->spectrum.hold);
+    chan->spectrum.hold_freq = chan->tune.freq;
+    return;
+  }
+  float * restrict const hold = chan->spectrum.hold;
+  for(int i=0; i < bin_count; i++){
+    hold[i] = d == DETECT_MIN ? fminf(hold[i],bin_data[i]) : fmaxf(hold[i],bin_data[i]);
+    bin_data[i] = hold[i];
+  }
+}
+
+// Choose the level range for the byte bin format from the bin powers
+static void set_level_scale(chan_t *chan){
   double min_power = INFINITY;
   double max_power = 0;
 
-  // scaling for byte bin format
-  for(int i=0; i < bin_count; i++){
-    if(bin_data[i] < min_power)
-      min_power = bin_data[i];
-    if(bin_data[i] > max_power)
-      max_power = bin_data[i];
+  for(int i=0; i < chan->spectrum.bin_count; i++){
+    if(chan->spectrum.bin_data[i] < min_power)
+      min_power = chan->spectrum.bin_data[i];
+    if(chan->spectrum.bin_data[i] > max_power)
+      max_power = chan->spectrum.bin_data[i];
   }
   if(max_power > 0 && min_power > 0){
 #if SPECTRUM_CLIP
     chan->spectrum.base = power2dB(chan->sig.n0 * chan->spectrum.noise_bw);
-
 #else
     chan->spectrum.base = power2dB(min_power);
 #endif
 #if FIXED_STEP
-    chan->spectrum.step = 0.5; // 0.25 dB fixed
+    chan->spectrum.step = 0.5; // 0.5 dB fixed
 #else
     chan->spectrum.step = ldexp(power2dB(max_power) - chan->spectrum.base,-8); // dB range
 #endif
   }
-
 }
 
 // Fill a buffer with compact frequency bin data, 1 byte each
@@ -543,66 +1212,600 @@ void encode_byte_data(chan_t const *chan, uint8_t *buffer){
       wbin = 0;  // Continuing through dc and positive frequencies
   }
 }
-// Generate normalized sampling window
-// the generation functions are symmetric so lengthen them by one point to make them periodic
+/* Waterfall history
+   The byte levels of each v2 spectrum response are also kept in a ring of up to chan->spectrum.history_rows rows,
+   so a client that just started, or missed some responses, can ask for the past rows with HISTORY_START
+   (and optionally HISTORY_END) instead of starting with an empty waterfall. Nothing is recomputed.
+   The rows go out in HISTORY packets, each with as many rows as fit in about HISTORY_PACKET bytes (at least one),
+   and HISTORY_REMAINING telling how many more are coming. Each row is a GPS_TIME, RADIO_FREQUENCY,
+   SPECTRUM_BASE and SPECTRUM_STEP followed by BIN_BYTE_DATA (or BIN_RICE_DATA, as set by BIN_COMPRESSION)
+   A row of more than HISTORY_FRAGMENT bins goes in pieces, one per packet, each repeating the row's entries
+   and adding BIN_OFFSET, the index of its first bin. Each Rice-coded piece is coded on its own
+   The history starts over when the RBW or bin count changes
+*/
+#define HISTORY_MAX_BYTES (16 << 20) // Limit on history levels per channel
+#define HISTORY_PACKET 1400          // Target packet size, about one Ethernet frame
+#define HISTORY_FRAGMENT 8192        // Most bins of a row in one packet
+#define HISTORY_ROW_ENTRIES 64       // Room for a row's entries other than its levels
+
+struct history_row {
+  int64_t time;   // GPS ns
+  double freq;    // Center frequency, Hz
+  float base;     // dB at level 0
+  float step;     // dB/level
+};
+
+struct spectrum_history {
+  int rows;       // Capacity
+  int bin_count;  // Levels per row
+  double rbw;
+  int count;      // Rows held
+  int next;       // Next row to write
+  struct history_row *row;
+  uint8_t *levels; // rows * bin_count
+};
+
+static void delete_history(struct spectrum_history **hp){
+  struct spectrum_history * const h = *hp;
+  if(h == NULL)
+    return;
+  *hp = NULL;
+  FREE(h->row);
+  FREE(h->levels);
+  free(h);
+}
+
+// Save the levels of the response just computed
+static void record_history(chan_t *chan){
+  int const bin_count = chan->spectrum.bin_count;
+  int rows = chan->spectrum.history_rows;
+  if(rows > HISTORY_MAX_BYTES / bin_count)
+    rows = HISTORY_MAX_BYTES / bin_count;
+  struct spectrum_history *h = chan->spectrum.history;
+  if(rows <= 0){
+    delete_history(&chan->spectrum.history);
+    return;
+  }
+  if(chan->spectrum.bin_data == NULL || !isfinite(chan->spectrum.base) || !isfinite(chan->spectrum.step))
+    return;
+
+  if(h != NULL && (h->rows != rows || h->bin_count != bin_count || h->rbw != chan->spectrum.rbw)){
+    delete_history(&chan->spectrum.history); // Start over
+    h = NULL;
+  }
+  if(h == NULL){
+    h = calloc(1,sizeof *h);
+    assert(h != NULL);
+    h->row = calloc(rows,sizeof *h->row);
+    h->levels = malloc((size_t)rows * bin_count);
+    if(h->row == NULL || h->levels == NULL){
+      delete_history(&h);
+      return;
+    }
+    h->rows = rows;
+    h->bin_count = bin_count;
+    h->rbw = chan->spectrum.rbw;
+    chan->spectrum.history = h;
+  }
+  struct history_row * const r = &h->row[h->next];
+  r->time = gps_time_ns();
+  r->freq = chan->tune.freq;
+  r->base = chan->spectrum.base;
+  r->step = chan->spectrum.step;
+  encode_byte_data(chan,h->levels + (size_t)h->next * bin_count);
+  if(++h->next == h->rows)
+    h->next = 0;
+  if(h->count < h->rows)
+    h->count++;
+}
+
+// Send the rows asked for with HISTORY_START/HISTORY_END, oldest first
+static void send_history(chan_t *chan){
+  int64_t const start = chan->spectrum.history_start;
+  int64_t const end = chan->spectrum.history_end > 0 ? chan->spectrum.history_end : INT64_MAX;
+  chan->spectrum.history_start = chan->spectrum.history_end = 0;
+  struct spectrum_history const * const h = chan->spectrum.history;
+
+  int const oldest = h == NULL ? 0 : (h->next - h->count + h->rows) % h->rows;
+  int remaining = 0;
+  for(int i=0; h != NULL && i < h->count; i++){
+    int64_t const t = h->row[(oldest + i) % h->rows].time;
+    if(t >= start && t <= end)
+      remaining++;
+  }
+  uint8_t packet[PKTSIZE];
+  int i = 0;
+  int offset = 0; // Next bin of a row being sent in pieces
+  do {
+    // Send even when there's nothing, so the client knows
+    uint8_t *bp = packet;
+    *bp++ = HISTORY;
+    encode_int32(&bp,OUTPUT_SSRC,chan->output.rtp.ssrc);
+    encode_int64(&bp,COMMAND_TAG,chan->status.tag);
+    if(h != NULL){
+      encode_float(&bp,RESOLUTION_BW,h->rbw);
+      encode_int(&bp,BIN_COUNT,h->bin_count);
+    }
+    uint8_t const * const first = bp;
+    while(remaining > 0){
+      int const n = (oldest + i) % h->rows;
+      struct history_row const * const r = &h->row[n];
+      if(r->time < start || r->time > end){
+	i++;
+	continue;
+      }
+      int count = h->bin_count - offset;
+      if(count > HISTORY_FRAGMENT)
+	count = HISTORY_FRAGMENT;
+      // Past the first row, stop at about HISTORY_PACKET; never past the buffer, leaving room for HISTORY_REMAINING
+      long const limit = bp == first ? (long)sizeof packet - HISTORY_ROW_ENTRIES : HISTORY_PACKET;
+      if((bp - packet) + count + HISTORY_ROW_ENTRIES > limit)
+	break;
+      uint8_t const * const levels = h->levels + (size_t)n * h->bin_count + offset;
+      encode_int64(&bp,GPS_TIME,r->time);
+      encode_double(&bp,RADIO_FREQUENCY,r->freq);
+      encode_float(&bp,SPECTRUM_BASE,r->base);
+      encode_float(&bp,SPECTRUM_STEP,r->step);
+      if(count < h->bin_count)
+	encode_int(&bp,BIN_OFFSET,offset);
+      if(chan->spectrum.compression != BIN_RICE || encode_rice_bins(&bp,BIN_RICE_DATA,levels,count) == 0)
+	encode_string(&bp,BIN_BYTE_DATA,levels,count);
+      offset += count;
+      if(offset < h->bin_count)
+	break; // The rest of the row in the next packet
+      offset = 0;
+      i++;
+      remaining--;
+    }
+    encode_int(&bp,HISTORY_REMAINING,remaining);
+    encode_eol(&bp);
+    send_status_packet((struct sockaddr *)&chan->frontend->metadata_dest_socket,chan,packet,bp - packet);
+  } while(remaining > 0);
+}
+
+/* Band occupancy
+   With OCCUPANCY_THRESHOLD set, each new spectrum (a poll's, or a scan's every OCCUPANCY_INTERVAL when nobody polls)
+   is searched for signals so clients like skimmers don't have to fetch and search the spectra themselves.
+   The noise floor of each bin is the 25th percentile of its OCCUPANCY_SEGMENT-bin segment, interpolated between
+   segment centers and smoothed over scans, so signals much narrower than a segment barely raise it.
+   A run of bins over the floor by the threshold (bridging one-bin gaps) is a signal. Signals are matched to those of
+   earlier scans by overlap and dropped OCCUPANCY_HOLD after they were last seen. Every poll, and every scan where one
+   starts or ends, sends SIGNALS packets listing them; one that has ended is listed once more.
+   Everything starts over when the channel is retuned or its RBW or bin count changes
+*/
+#define OCCUPANCY_SEGMENT 32
+#define OCCUPANCY_SMOOTH 0.1f         // Fraction of each new floor estimate taken
+#define OCCUPANCY_HOLD BILLION        // 1 s, GPS ns
+#define OCCUPANCY_MAX 256             // Signals tracked
+#define SIGNALS_PACKET HISTORY_PACKET // Target packet size
+
+struct signal {
+  double freq;      // Center, weighted by power over the floor, Hz
+  double low,high;  // Edges, Hz
+  float snr;        // Strongest bin over the floor, dB
+  int64_t first;    // GPS ns
+  int64_t last;
+  bool seen;        // Matched in this scan
+};
+
+struct spectrum_occupancy {
+  int bin_count;
+  double rbw;
+  double freq;      // Channel center
+  int64_t last_scan;
+  float *floor;     // Noise floor, frequency order (lowest first); NAN until the first scan
+  float *segment;   // Floor estimate for each segment
+  int count;
+  struct signal signal[OCCUPANCY_MAX];
+  bool changed;     // Something to send
+};
+
+static void delete_occupancy(struct spectrum_occupancy **op){
+  struct spectrum_occupancy * const o = *op;
+  if(o == NULL)
+    return;
+  *op = NULL;
+  FREE(o->floor);
+  FREE(o->segment);
+  free(o);
+}
+
+// True when nobody has polled for OCCUPANCY_INTERVAL, so it's time to scan on our own
+static bool occupancy_due(chan_t const *chan){
+  if(!(chan->spectrum.occupancy_threshold > 0) || !(chan->spectrum.occupancy_interval > 0))
+    return false;
+  struct spectrum_occupancy const * const o = chan->spectrum.occupancy;
+  return o == NULL || gps_time_ns() - o->last_scan >= (int64_t)(chan->spectrum.occupancy_interval * BILLION);
+}
+
+static int compare_float(void const *a,void const *b){
+  float const x = *(float const *)a;
+  float const y = *(float const *)b;
+  return (x > y) - (x < y);
+}
+
+// Power in bin i, frequency order
+static inline float occupancy_bin(chan_t const *chan,int i){
+  int const bin_count = chan->spectrum.bin_count;
+  return chan->spectrum.bin_data[(i + bin_count/2) % bin_count];
+}
+
+// Update the noise floor and the signals from the bins just computed. A poll always sends the list
+static void scan_occupancy(chan_t *chan,bool poll){
+  int const bin_count = chan->spectrum.bin_count;
+  if(!(chan->spectrum.occupancy_threshold > 0) || bin_count < 1 || chan->spectrum.bin_data == NULL){
+    delete_occupancy(&chan->spectrum.occupancy);
+    return;
+  }
+  struct spectrum_occupancy *o = chan->spectrum.occupancy;
+  if(o != NULL && (o->bin_count != bin_count || o->rbw != chan->spectrum.rbw || o->freq != chan->tune.freq))
+    delete_occupancy(&chan->spectrum.occupancy); // Start over
+  o = chan->spectrum.occupancy;
+  int const seg = bin_count < OCCUPANCY_SEGMENT ? bin_count : OCCUPANCY_SEGMENT;
+  int const nseg = bin_count / seg; // The last one takes the leftovers
+  if(o == NULL){
+    o = calloc(1,sizeof *o);
+    assert(o != NULL);
+    o->floor = malloc(bin_count * sizeof *o->floor);
+    o->segment = malloc(nseg * sizeof *o->segment);
+    assert(o->floor != NULL && o->segment != NULL);
+    for(int i=0; i < bin_count; i++)
+      o->floor[i] = NAN;
+    o->bin_count = bin_count;
+    o->rbw = chan->spectrum.rbw;
+    o->freq = chan->tune.freq;
+    o->changed = true; // Let clients know the old signals are gone
+    chan->spectrum.occupancy = o;
+  }
+  int64_t const now = gps_time_ns();
+  o->last_scan = now;
+  if(poll)
+    o->changed = true;
+
+  // Noise floor
+  for(int s=0; s < nseg; s++){
+    int const first = s * seg;
+    int const n = s == nseg-1 ? bin_count - first : seg;
+    float sorted[2 * OCCUPANCY_SEGMENT]; // The last segment is less than two
+    for(int i=0; i < n; i++)
+      sorted[i] = occupancy_bin(chan,first + i);
+    qsort(sorted,n,sizeof *sorted,compare_float);
+    o->segment[s] = sorted[n/4];
+  }
+  for(int i=0; i < bin_count; i++){
+    float x = (i + 0.5f) / seg - 0.5f; // In segments from the center of the first
+    if(x < 0)
+      x = 0;
+    else if(x > nseg - 1)
+      x = nseg - 1;
+    int const s = (int)x;
+    float const t = x - s;
+    float const est = s + 1 < nseg ? (1 - t) * o->segment[s] + t * o->segment[s+1] : o->segment[s];
+    o->floor[i] = isnan(o->floor[i]) ? est : o->floor[i] + OCCUPANCY_SMOOTH * (est - o->floor[i]);
+  }
+
+  // Signals
+  for(int k=0; k < o->count; k++)
+    o->signal[k].seen = false;
+  float const threshold = dB2power(chan->spectrum.occupancy_threshold);
+  double const rbw = chan->spectrum.rbw;
+  double const low_freq = chan->tune.freq - (bin_count/2) * rbw; // Center of bin 0
+  for(int i=0; i < bin_count;){
+    if(!(occupancy_bin(chan,i) > threshold * o->floor[i])){
+      i++;
+      continue;
+    }
+    // A run of bins over the threshold, allowing gaps of one
+    int const first = i;
+    int last = i;
+    double sum = 0, moment = 0;
+    float peak = 0;
+    for(; i < bin_count; i++){
+      float const p = occupancy_bin(chan,i);
+      if(p > threshold * o->floor[i])
+	last = i;
+      else if(i > last + 1)
+	break;
+      float const excess = p - o->floor[i];
+      if(excess > 0){
+	sum += excess;
+	moment += excess * i;
+      }
+      if(o->floor[i] > 0 && p / o->floor[i] > peak)
+	peak = p / o->floor[i];
+    }
+    double const low = low_freq + (first - 0.5) * rbw;
+    double const high = low_freq + (last + 0.5) * rbw;
+    double const freq = sum > 0 ? low_freq + rbw * moment / sum : (low + high) / 2;
+    // Same as one already known?
+    struct signal *sig = NULL;
+    for(int k=0; k < o->count; k++){
+      struct signal * const t = &o->signal[k];
+      if(!t->seen && t->last + OCCUPANCY_HOLD >= now && t->low < high && t->high > low){
+	sig = t;
+	break;
+      }
+    }
+    if(sig == NULL){
+      if(o->count == OCCUPANCY_MAX)
+	continue; // Full
+      sig = &o->signal[o->count++];
+      sig->first = now;
+      o->changed = true;
+    }
+    sig->freq = freq;
+    sig->low = low;
+    sig->high = high;
+    sig->snr = power2dB(peak);
+    sig->last = now;
+    sig->seen = true;
+  }
+  for(int k=0; k < o->count; k++){
+    if(o->signal[k].last + OCCUPANCY_HOLD < now)
+      o->changed = true; // Ended; listed once more, then dropped by send_signals()
+  }
+}
+
+// Send the signals in SIGNALS packets, if anything has changed
+static void send_signals(chan_t *chan){
+  struct spectrum_occupancy * const o = chan->spectrum.occupancy;
+  if(o == NULL || !o->changed)
+    return;
+  o->changed = false;
+  int64_t const now = o->last_scan;
+  uint8_t packet[PKTSIZE];
+  int next = 0;
+  do {
+    // Send even when there's nothing, so clients know
+    uint8_t *bp = packet;
+    *bp++ = SIGNALS;
+    encode_int32(&bp,OUTPUT_SSRC,chan->output.rtp.ssrc);
+    encode_int64(&bp,GPS_TIME,now);
+    encode_double(&bp,RADIO_FREQUENCY,chan->tune.freq);
+    encode_float(&bp,OCCUPANCY_THRESHOLD,chan->spectrum.occupancy_threshold);
+    encode_int(&bp,SIGNAL_COUNT,o->count);
+    for(; next < o->count && (bp - packet) + 64 <= SIGNALS_PACKET; next++){
+      struct signal const * const sig = &o->signal[next];
+      encode_double(&bp,SIGNAL_FREQUENCY,sig->freq);
+      encode_float(&bp,SIGNAL_BANDWIDTH,sig->high - sig->low);
+      encode_float(&bp,SIGNAL_SNR,sig->snr);
+      encode_int64(&bp,SIGNAL_FIRST,sig->first);
+      encode_int64(&bp,SIGNAL_LAST,sig->last); // Before GPS_TIME when it has ended
+    }
+    encode_eol(&bp);
+    send_status_packet((struct sockaddr *)&chan->frontend->metadata_dest_socket,chan,packet,bp - packet);
+  } while(next < o->count);
+
+  // Drop the ones that have ended, now that they've been reported
+  int n = 0;
+  for(int k=0; k < o->count; k++){
+    if(o->signal[k].last + OCCUPANCY_HOLD >= now)
+      o->signal[n++] = o->signal[k];
+  }
+  o->count = n;
+}
+
+// Get this channel's analysis window from the cache
 static void generate_window(chan_t *chan){
   assert(chan != NULL);
   if(chan->spectrum.fft_n == 0)
     return; // can't do anything until we know the size
 
   int const fft_n = chan->spectrum.fft_n;
-  FREE(chan->spectrum.window);
-  chan->spectrum.window = malloc((1 + fft_n) * sizeof *chan->spectrum.window);
-  assert(chan->spectrum.window != NULL);
-  switch(chan->spectrum.window_type){
+  double power;
+  float const *window = attach_window(chan->spectrum.window_type,chan->spectrum.shape,fft_n,&power);
+  assert(window != NULL);
+  release_window(&chan->spectrum.window); // After, in case it's the same one
+  chan->spectrum.window = window;
+
+  // Noise bandwidth of each bin in bins is the sum of the squared window values
+  // Scale to the actual bin bandwidth
+  // This also has to be divided by the square of the sum of the window values, but that's already normalized to 1
+  chan->spectrum.noise_bw = power * chan->spectrum.rbw / fft_n;
+}
+
+/* Cache of analysis windows and FFT plans
+   Zooming a spectrum display changes the RBW or bin count, and with them the FFT size, at every step.
+   Windows and plans are kept here by type and size, shared with reference counts among spectrum channels
+   and wideband engines, so each is made only once. The CACHE_IDLE most recently used ones that are no longer
+   in use are also kept for when the user zooms back
+*/
+#define CACHE_IDLE 16
+
+struct cached_window {
+  struct cached_window *next;
+  int refs;
+  enum window_type type;
+  double shape;  // Kaiser β or gaussian σ, 0 for the others
+  int n;
+  double power;  // Sum of the squared values
+  float *window;
+};
+struct cached_plan {
+  struct cached_plan *next;
+  int refs;
+  int n;
+  bool real;     // r2c, otherwise complex forward
+  fftwf_plan plan;
+};
+// Both lists are kept in order of most recent use
+static struct cached_window *Windows;
+static struct cached_plan *Plans;
+static pthread_mutex_t Cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Generate normalized sampling window
+// the generation functions are symmetric so lengthen them by one point to make them periodic
+static float *make_window(enum window_type type,double shape,int fft_n){
+  float * const window = malloc((1 + fft_n) * sizeof *window);
+  assert(window != NULL);
+  switch(type){
   default:
   case KAISER_WINDOW: // If β == 0, same as rectangular
-    make_kaiserf(chan->spectrum.window,fft_n+1,chan->spectrum.shape);
+    make_kaiserf(window,fft_n+1,shape);
     break;
   case RECT_WINDOW:
     for(int i=0; i < fft_n; i++)
-      chan->spectrum.window[i] = 1;
+      window[i] = 1;
     break;
   case BLACKMAN_WINDOW:
     for(int i=0; i < fft_n; i++)
-      chan->spectrum.window[i] = blackman_window(i,fft_n+1);
+      window[i] = blackman_window(i,fft_n+1);
     break;
   case EXACT_BLACKMAN_WINDOW:
     for(int i=0; i < fft_n; i++)
-      chan->spectrum.window[i] = exact_blackman_window(i,fft_n+1);
+      window[i] = exact_blackman_window(i,fft_n+1);
     break;
   case BLACKMAN_HARRIS_WINDOW:
     for(int i=0; i < fft_n; i++)
-      chan->spectrum.window[i] = blackman_harris_window(i,fft_n+1);
+      window[i] = blackman_harris_window(i,fft_n+1);
     break;
   case GAUSSIAN_WINDOW:
     // Reuse kaiser β as σ parameter
     // note σ = 0 is a pathological value for gaussian, it's an impulse with infinite sidelobes
-    gaussian_window_alpha(chan->spectrum.window, fft_n+1,chan->spectrum.shape, false); // we normalize them all below
+    gaussian_window_alpha(window, fft_n+1,shape, false); // we normalize them all below
     break;
   case HANN_WINDOW:
     for(int i=0; i < fft_n; i++)
-      chan->spectrum.window[i] = hann_window(i,fft_n+1);
+      window[i] = hann_window(i,fft_n+1);
     break;
   case HAMMING_WINDOW:
     for(int i=0; i < fft_n; i++)
-      chan->spectrum.window[i] = hamming_window(i,fft_n+1);
+      window[i] = hamming_window(i,fft_n+1);
     break;
   case HP5FT_WINDOW:
     for(int i=0; i < fft_n; i++)
-      chan->spectrum.window[i] = hp5ft_window(i,fft_n+1);
+      window[i] = hp5ft_window(i,fft_n+1);
     break;
   }
-  normalize_windowf(chan->spectrum.window,fft_n);
+  normalize_windowf(window,fft_n);
+  return window;
+}
 
-  // Compute noise bandwidth of each bin in bins
-  chan->spectrum.noise_bw = 0;
-  for(int i=0; i < fft_n; i++)
-    chan->spectrum.noise_bw += (double)chan->spectrum.window[i] * chan->spectrum.window[i];
+// Free unused entries beyond the most recent CACHE_IDLE. Caller holds Cache_lock
+static void trim_cache(void){
+  int idle = 0;
+  for(struct cached_window **wp = &Windows; *wp != NULL;){
+    struct cached_window * const w = *wp;
+    if(w->refs == 0 && ++idle > CACHE_IDLE){
+      *wp = w->next;
+      free(w->window);
+      free(w);
+    } else
+      wp = &w->next;
+  }
+  idle = 0;
+  for(struct cached_plan **pp = &Plans; *pp != NULL;){
+    struct cached_plan * const p = *pp;
+    if(p->refs == 0 && ++idle > CACHE_IDLE){
+      *pp = p->next;
+      destroy_plan(&p->plan);
+      free(p);
+    } else
+      pp = &p->next;
+  }
+}
 
-  // Scale to the actual bin bandwidth
-  // This also has to be divided by the square of the sum of the window values, but that's already normalized to 1
-  chan->spectrum.noise_bw *= chan->spectrum.rbw / fft_n;
+// Return a normalized window of fft_n points, and optionally its power. Free with release_window()
+static float const *attach_window(enum window_type type,double shape,int fft_n,double *power){
+  if(type != KAISER_WINDOW && type != GAUSSIAN_WINDOW)
+    shape = 0; // Doesn't matter
+  pthread_mutex_lock(&Cache_lock);
+  struct cached_window *w;
+  for(struct cached_window **wp = &Windows; (w = *wp) != NULL; wp = &w->next){
+    if(w->type == type && w->shape == shape && w->n == fft_n){
+      *wp = w->next; // Move to the front
+      break;
+    }
+  }
+  if(w == NULL){
+    // Made under the lock so two channels asking at once don't both do it
+    w = calloc(1,sizeof *w);
+    assert(w != NULL);
+    w->type = type;
+    w->shape = shape;
+    w->n = fft_n;
+    w->window = make_window(type,shape,fft_n);
+    for(int i=0; i < fft_n; i++)
+      w->power += (double)w->window[i] * w->window[i];
+  }
+  w->next = Windows;
+  Windows = w;
+  w->refs++;
+  pthread_mutex_unlock(&Cache_lock);
+  if(power != NULL)
+    *power = w->power;
+  return w->window;
+}
+
+static void release_window(float const **window){
+  if(window == NULL || *window == NULL)
+    return;
+  pthread_mutex_lock(&Cache_lock);
+  for(struct cached_window *w = Windows; w != NULL; w = w->next){
+    if(w->window == *window){
+      assert(w->refs > 0);
+      if(--w->refs == 0)
+	trim_cache();
+      break;
+    }
+  }
+  pthread_mutex_unlock(&Cache_lock);
+  *window = NULL;
+}
+
+// Return a forward FFT plan, r2c if real, for arrays from fftwf_alloc_*(). Free with release_plan()
+static fftwf_plan attach_plan(int fft_n,bool real){
+  pthread_mutex_lock(&Cache_lock);
+  struct cached_plan *p;
+  for(struct cached_plan **pp = &Plans; (p = *pp) != NULL; pp = &p->next){
+    if(p->n == fft_n && p->real == real){
+      *pp = p->next;
+      break;
+    }
+  }
+  if(p == NULL){
+    p = calloc(1,sizeof *p);
+    assert(p != NULL);
+    p->n = fft_n;
+    p->real = real;
+    if(real){
+      float *in = fftwf_alloc_real(fft_n);
+      float complex *out = fftwf_alloc_complex(fft_n/2+1);
+      assert(in != NULL && out != NULL);
+      p->plan = plan_r2c(fft_n,in,out);
+      fftwf_free(in);
+      fftwf_free(out);
+    } else {
+      float complex *in = fftwf_alloc_complex(fft_n);
+      float complex *out = fftwf_alloc_complex(fft_n);
+      assert(in != NULL && out != NULL);
+      p->plan = plan_complex(fft_n,in,out,FFTW_FORWARD);
+      fftwf_free(in);
+      fftwf_free(out);
+    }
+    assert(p->plan != NULL);
+  }
+  p->next = Plans;
+  Plans = p;
+  p->refs++;
+  pthread_mutex_unlock(&Cache_lock);
+  return p->plan;
+}
+
+static void release_plan(fftwf_plan *plan){
+  if(plan == NULL || *plan == NULL)
+    return;
+  pthread_mutex_lock(&Cache_lock);
+  for(struct cached_plan *p = Plans; p != NULL; p = p->next){
+    if(p->plan == *plan){
+      assert(p->refs > 0);
+      if(--p->refs == 0)
+	trim_cache();
+      break;
+    }
+  }
+  pthread_mutex_unlock(&Cache_lock);
+  *plan = NULL;
 }
 
 // Direct Wideband mode. Setup FFT to work on raw A/D input
@@ -618,18 +1821,15 @@ static void setup_wideband(chan_t *chan){
     fprintf(stderr,"%s wide spectrum: center %'.3lf Hz bin count %u, rbw %.1lf Hz, samprate %u Hz fft size %u\n",
 	    chan->name,chan->tune.freq,chan->spectrum.bin_count,chan->spectrum.rbw,chan->output.samprate,chan->spectrum.fft_n);
 
-  FREE(chan->spectrum.ring); // not needed
+  mirror_free((void **)&chan->spectrum.ring,chan->spectrum.ring_size * sizeof *chan->spectrum.ring); // not needed
   chan->spectrum.ring_size = 0;
   // Dummy just so downconvert() will block on each frame
   delete_filter_output(&chan->filter.out);
   int r = create_filter_output(&chan->filter.out,&chan->frontend->in,0,SPECTRUM);
   assert(r == 0);
   (void)r;
-  // Wideband mode with real front end; use real->complex FFT
-  if(chan->frontend->isreal)
-    setup_real_fft(chan);
-  else
-    setup_complex_fft(chan);
+  // The FFTs are done by a shared engine
+  release_plan(&chan->spectrum.plan);
 }
 // Set up narrow band (downconvert) mode
 static void setup_narrowband(chan_t *chan){
@@ -673,112 +1873,12 @@ static void setup_narrowband(chan_t *chan){
   chan->filter.bin_shift = 1010101010; // Unlikely - but a kludge, force init of phase rotator
   setup_complex_fft(chan);
 }
-// Wideband mode with real front end
-static void setup_real_fft(chan_t *chan){
-  assert(chan != NULL);
-  if(chan->spectrum.fft_n < 1)
-    return; // Can't do it yet
-  destroy_plan(&chan->spectrum.plan);
-  float *in = fftwf_alloc_real(chan->spectrum.fft_n);
-  assert(in != NULL);
-  float complex *out = fftwf_alloc_complex(chan->spectrum.fft_n/2+1); // N/2 + 1 output points for real->complex
-  assert(out != NULL);
-  chan->spectrum.plan = plan_r2c(chan->spectrum.fft_n, in, out);
-  fftwf_free(in);
-  fftwf_free(out);
-  assert(chan->spectrum.plan != NULL);
-}
-// Wideband mode with complex front end, or narrowband mode with either front end
+// Narrowband mode with either front end
 static void setup_complex_fft(chan_t *chan){
   assert(chan != NULL);
   if(chan->spectrum.fft_n < 1)
     return; // Can't do anything yet
-  destroy_plan(&chan->spectrum.plan);
-  float complex *in = fftwf_alloc_complex(chan->spectrum.fft_n);
-  assert(in != NULL);
-  float complex *out = fftwf_alloc_complex(chan->spectrum.fft_n);
-  assert(out != NULL);
-  chan->spectrum.plan = plan_complex(chan->spectrum.fft_n, in, out, FFTW_FORWARD);
-  fftwf_free(in);
-  fftwf_free(out);
+  release_plan(&chan->spectrum.plan);
+  chan->spectrum.plan = attach_plan(chan->spectrum.fft_n,false);
   assert(chan->spectrum.plan != NULL);
 }
-
-#if RICE
-// Experiment with rice coding of delta values in bin data
-static void rice(chan_t *chan){
-  assert(chan != NULL);
-  if(chan->spectrum.step == 0 || chan->spectrum.bin_count)
-    return;
-
-  // make vector of quantized measurements
-  int const bin_count = chan->spectrum.bin_count;
-  double scale = 1./chan->spectrum.step;
-  int data[bin_count];
-  int wbin = bin_count/2; // nyquist freq is most negative
-  for(int i=0; i < bin_count; i++){
-    double x = scale * (power2dB(chan->spectrum.bin_data[wbin++]) - chan->spectrum.base);
-    if(x < 0)
-      x = 0;
-    data[i] = llrint(x);
-    if(wbin == bin_count)
-      wbin = 0;  // Continuing through dc and positive frequencies
-  }
-  int best_k = -1;
-  int best_bits = 8 * bin_count;
-  bool delta = false;
-
-  // Test non-delta encoding
-  for(int k=1;k < 6; k++){
-    int bits = 0;
-    int M = 1 << k;
-
-    for(int i=0;i < bin_count; i++){
-      int value = data[i]; // values are non-negative, no sign bit needed
-
-      // Rice encode
-      int q = value / M;
-      int r = value % M;
-      (void)r;
-
-      // emit q 0-bits and a 1 bit
-      bits += q + 1;
-      // Emit r using k bits
-      bits += k;
-    }
-    if(bits < best_bits){
-      best_bits = bits;
-      best_k = k;
-    }
-  }
-  // Now test delta encoding
-  for(int k=1;k < 6; k++){
-    int bits = 0;
-    int M = 1 << k;
-    int prev = 0;
-
-    for(int i=0;i < bin_count; i++){
-      int delta = data[i] - prev;
-      prev = data[i];
-      int value = (abs(delta) << 1) | (delta < 0); // zig-zag encoding
-
-      // Rice encode
-      int q = value / M;
-      int r = value % M;
-      (void)r;
-
-      // emit q 0-bits and a 1 bit
-      bits += q + 1;
-      // Emit r using k bits
-      bits += k;
-    }
-    if(bits < best_bits){
-      best_bits = bits;
-      best_k = k;
-      delta = true;
-    }
-  }
-  fprintf(stderr,"rice encoding, delta %d,  k=%d: %d bits (%d bytes), %.1lf%%\n",delta,best_k,best_bits,best_bits/8,
-	  100. * best_bits / (8 * bin_count));
-}
-#endif
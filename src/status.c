@@ -185,7 +185,192 @@ size_t encode_vector(uint8_t **bp,enum status_type type,float const *array,size_
   return cp - orig_bp;
 }
 
+/* Spectrum levels (the 8-bit quantities in BIN_BYTE_DATA) compressed with Rice codes
+   Payload: one byte with the Rice parameter k for level differences in the low nibble and for run lengths in the high nibble
+   (RICE_NORUN if there's no run-length coding), the number of levels (4 bytes, big endian), the first level,
+   then an MSB-first bit stream of the differences between adjacent levels, zigzag mapped 0,-1,1,-2... -> 0,1,2,3...
+   Each value v is sent as (v >> k) zeroes, a one, and the low k bits of v
+   With run-length coding, each zero difference is followed by the number of zero differences right after it
+   Noise floor regions are mostly small differences, so this usually takes 2-4 bits per bin
+*/
+#define RICE_KMAX 8
+#define RICE_NORUN 15
+
+struct bitbuf {
+  uint8_t *p;
+  uint8_t const *end; // decoding only
+  uint64_t acc;
+  int n;
+};
+
+static inline unsigned int zigzag(int d){
+  return (unsigned int)((d << 1) ^ (d >> 31));
+}
+static inline int unzigzag(unsigned int v){
+  return (int)(v >> 1) ^ -(int)(v & 1);
+}
+static inline void put_bits(struct bitbuf *b,uint32_t x,int nbits){
+  b->acc = (b->acc << nbits) | x;
+  b->n += nbits;
+  while(b->n >= 8){
+    b->n -= 8;
+    *b->p++ = (uint8_t)(b->acc >> b->n);
+  }
+}
+static void put_rice(struct bitbuf *b,unsigned int v,int k){
+  unsigned int q = v >> k;
+  for(; q >= 32; q -= 32)
+    put_bits(b,0,32);
+  put_bits(b,1,q+1);
+  if(k > 0)
+    put_bits(b,v & ((1u << k) - 1),k);
+}
+static inline int get_bit(struct bitbuf *b){
+  if(b->n == 0){
+    if(b->p >= b->end)
+      return -1;
+    b->acc = *b->p++;
+    b->n = 8;
+  }
+  return (b->acc >> --b->n) & 1;
+}
+// Values larger than 'limit' can't be valid, so the zero bits are bounded by it rather than by a constant
+static int get_rice(struct bitbuf *b,int k,int limit){
+  int q = 0;
+  int bit;
+  while((bit = get_bit(b)) == 0){
+    if(++q > (limit >> k))
+      return -1;
+  }
+  if(bit < 0)
+    return -1;
+  int v = q << k;
+  for(int i=k-1; i >= 0; i--){
+    if((bit = get_bit(b)) < 0)
+      return -1;
+    v |= bit << i;
+  }
+  return v;
+}
+
+// Encode 'count' levels as a Rice-coded TLV, choosing whichever parameters give the fewest bits
+// Returns the TLV length, or 0 without encoding anything if it wouldn't be smaller than the levels themselves
+size_t encode_rice_bins(uint8_t **bp,enum status_type type,uint8_t const *levels,int count){
+  if(count < 2)
+    return 0;
 
+  // Bits needed by each k, for every difference (plain) or with run-length coding (runs, lengths)
+  // Tally the differences first so the cost of each k doesn't need another pass over the levels
+  uint32_t hist[512] = {0};
+  uint32_t nruns = 0;
+  uint64_t lengths[RICE_KMAX] = {0};
+  for(int i=1; i < count;){
+    unsigned int const v = zigzag(levels[i] - levels[i-1]);
+    hist[v]++;
+    i++;
+    if(v == 0){
+      int r = 0;
+      while(i + r < count && levels[i + r] == levels[i + r - 1])
+	r++;
+      hist[0] += r;
+      nruns++;
+      for(int k=0; k < RICE_KMAX; k++)
+	lengths[k] += (r >> k) + 1 + k;
+      i += r;
+    }
+  }
+  uint64_t plain[RICE_KMAX] = {0};
+  uint64_t runs[RICE_KMAX] = {0};
+  for(int k=0; k < RICE_KMAX; k++){
+    for(unsigned int v=1; v < 512; v++)
+      runs[k] += (uint64_t)hist[v] * ((v >> k) + 1 + k);
+    plain[k] = runs[k] + (uint64_t)hist[0] * (1 + k);
+    runs[k] += (uint64_t)nruns * (1 + k);
+  }
+  int k = 0, kr = 0, kp = 0;
+  for(int i=1; i < RICE_KMAX; i++){
+    if(plain[i] < plain[kp])
+      kp = i;
+    if(runs[i] < runs[k])
+      k = i;
+    if(lengths[i] < lengths[kr])
+      kr = i;
+  }
+  uint64_t bits = runs[k] + lengths[kr];
+  if(plain[kp] <= bits){
+    bits = plain[kp];
+    k = kp;
+    kr = RICE_NORUN;
+  }
+  size_t const bytes = 6 + (bits + 7) / 8;
+  if(bytes >= (size_t)count)
+    return 0;
+
+  uint8_t * const payload = malloc(bytes);
+  if(payload == NULL)
+    return 0;
+  payload[0] = (uint8_t)(kr << 4 | k);
+  payload[1] = (uint8_t)(count >> 24);
+  payload[2] = (uint8_t)(count >> 16);
+  payload[3] = (uint8_t)(count >> 8);
+  payload[4] = (uint8_t)count;
+  payload[5] = levels[0];
+  struct bitbuf b = {.p = payload + 6};
+  for(int i=1; i < count;){
+    unsigned int const v = zigzag(levels[i] - levels[i-1]);
+    put_rice(&b,v,k);
+    i++;
+    if(v == 0 && kr != RICE_NORUN){
+      int r = 0;
+      while(i + r < count && levels[i + r] == levels[i + r - 1])
+	r++;
+      put_rice(&b,r,kr);
+      i += r;
+    }
+  }
+  if(b.n > 0)
+    *b.p++ = (uint8_t)(b.acc << (8 - b.n));
+  assert(b.p == payload + bytes);
+  size_t const r = encode_string(bp,type,payload,bytes);
+  free(payload);
+  return r;
+}
+
+// Decode Rice-coded levels into levels[], if there's room for them (size)
+// Returns the number of levels in the TLV (whether or not they fit), -1 if it's malformed
+int decode_rice_bins(uint8_t const *cp,int optlen,uint8_t *levels,int size){
+  if(optlen < 6)
+    return -1;
+  int const k = cp[0] & 0xf;
+  int const kr = cp[0] >> 4;
+  if(k >= RICE_KMAX || (kr >= RICE_KMAX && kr != RICE_NORUN))
+    return -1;
+  uint32_t const count = (uint32_t)cp[1] << 24 | cp[2] << 16 | cp[3] << 8 | cp[4];
+  if(count == 0 || count > INT32_MAX)
+    return -1;
+  if(levels == NULL || (int)count > size)
+    return count;
+
+  levels[0] = cp[5];
+  struct bitbuf b = {.p = (uint8_t *)cp + 6, .end = cp + optlen};
+  for(int i=1; i < (int)count;){
+    int const v = get_rice(&b,k,2*255); // Largest zigzagged difference
+    if(v < 0)
+      return -1;
+    int const x = levels[i-1] + unzigzag(v);
+    if(x < 0 || x > 255)
+      return -1;
+    levels[i++] = (uint8_t)x;
+    if(v == 0 && kr != RICE_NORUN){
+      int const r = get_rice(&b,kr,(int)count - i);
+      if(r < 0 || r > (int)count - i)
+	return -1;
+      memset(levels + i,x,r);
+      i += r;
+    }
+  }
+  return count;
+}
 
 // Decode byte string without byte swapping
 // NB! optlen has already been 'fixed' by the caller in case it's >= 128
@@ -13,6 +13,25 @@
 enum pkt_type {
   STATUS = 0,
   CMD,
+  STATUS_DELTA,  // Only the entries that changed since the last STATUS or STATUS_DELTA from the same channel and stream
+  HISTORY,       // Past spectrum rows requested with HISTORY_START (spectrum.c)
+  SIGNALS,       // Signals found by a spectrum channel's occupancy scans (spectrum.c)
+};
+
+// Values of BIN_COMPRESSION
+enum bin_compression {
+  BIN_UNCOMPRESSED = 0,
+  BIN_RICE,
+};
+
+// Values of SPECTRUM_DETECTOR: how the FFTs behind each spectrum bin are combined
+enum spectrum_detector {
+  DETECT_AVERAGE = 0, // Mean power of the FFTs in each response
+  DETECT_PEAK,        // Highest power in any FFT, held across responses
+  DETECT_MIN,         // Lowest power in any FFT, held across responses
+  DETECT_PERCENTILE,  // SPECTRUM_PERCENTILE'th percentile of the FFT powers, running estimate
+  DETECT_MAX_AVERAGE, // Highest DETECT_AVERAGE response, held
+  N_DETECTOR,
 };
 
 // I try not to delete or rearrange these entries since that makes the different programs incompatible
@@ -162,6 +181,37 @@ enum status_type {
   SPECTRUM_STEP,  // size of byte spectrum data level step, dB
   SPECTRUM_OVERLAP,   // Overlap of FFT windows when averaging (0-1)
   LIFETIME,           // frames until channel goes away
+  FE_XFER_QUEUE,      // Front end transfers kept in flight (e.g., rx888 USB)
+  FE_XFER_SIZE,       // Front end bytes per transfer
+  FE_XFER_FAILURES,   // Count of failed front end transfers
+  FE_XFER_LATENCY,    // Vector: transfer completion interval median, 99th percentile, max; max callback time (sec)
+  OUTPUT_DROPS,       // Output packets dropped for lack of buffer space (EAGAIN or full output queue)
+  OPUS_LATENCY,       // Average delay through the Opus encoder pool, sec
+  OPUS_BACKLOG,       // Blocks waiting for the Opus encoder pool
+  STATUS_REFRESH,     // Send STATUS_DELTA packets, with a full STATUS every this many; 0 = always full
+  COMMAND_DROPS,      // Commands dropped because the channel's mailbox was full
+  COMMANDS_COALESCED, // Commands skipped because the next one set the same things
+  BIN_COMPRESSION,    // Spectrum level format in v2 responses: BIN_UNCOMPRESSED (BIN_BYTE_DATA) or BIN_RICE (BIN_RICE_DATA)
+  BIN_RICE_DATA,      // Rice-coded differences of 1-byte spectrum levels (see status.c)
+  SPECTRUM_LATENCY,   // Time taken to compute the last spectrum response, sec
+  SPECTRUM_TAP,       // Wideband spectrum summed from the front end's forward FFT (RBW >= its bin spacing)
+  SPECTRUM_HISTORY,   // Spectrum rows kept for backfill; 0 = none
+  HISTORY_START,      // Command: send the kept rows from this GPS time (ns) in HISTORY packets
+  HISTORY_END,        // Command: ...through this GPS time (ns); default now
+  HISTORY_REMAINING,  // Rows still to come after this HISTORY packet
+  SPECTRUM_DETECTOR,  // enum spectrum_detector; sending it again restarts a hold
+  SPECTRUM_PERCENTILE, // Percentile for DETECT_PERCENTILE, 0-100
+  BIN_SEQUENCE,       // Response number shared by the fragments of a spectrum response too big for one packet
+  BIN_OFFSET,         // Index of the first bin in this fragment
+  SPECTRUM_DIRECT,    // Narrowband FFTs straight from the downconverter's output blocks when they're big enough
+  OCCUPANCY_THRESHOLD, // Report signals this many dB over the noise floor; 0 = off
+  OCCUPANCY_INTERVAL, // Also scan for signals this often when not polled, sec; 0 = only when polled
+  SIGNAL_COUNT,       // Signals listed in this SIGNALS update (possibly over several packets)
+  SIGNAL_FREQUENCY,   // Center of a signal, Hz; starts each one in a SIGNALS packet
+  SIGNAL_BANDWIDTH,   // Hz
+  SIGNAL_SNR,         // Strongest bin over the noise floor, dB
+  SIGNAL_FIRST,       // GPS time first seen, ns
+  SIGNAL_LAST,        // GPS time last seen, ns; before the packet's GPS_TIME when it has ended
 };
 
 size_t encode_string(uint8_t **bp,enum status_type type,void const *buf,size_t buflen);
@@ -176,6 +226,7 @@ int encode_float(uint8_t **buf,enum status_type type,double x);
 int encode_double(uint8_t **buf,enum status_type type,double x);
 int encode_socket(uint8_t **buf,enum status_type type,void const *sock);
 size_t encode_vector(uint8_t **buf,enum status_type type,float const *array,size_t size);
+size_t encode_rice_bins(uint8_t **bp,enum status_type type,uint8_t const *levels,int count);
 
 uint64_t decode_int64(uint8_t const *,int);
 uint32_t decode_int32(uint8_t const *,int);
@@ -187,6 +238,7 @@ int decode_int(uint8_t const *,int);
 double decode_float(uint8_t const *,int);
 double decode_double(uint8_t const *,int);
 struct sockaddr *decode_socket(void *,uint8_t const *,int);
+int decode_rice_bins(uint8_t const *cp,int optlen,uint8_t *levels,int size);
 struct sockaddr *decode_local_socket(void *,uint8_t const *,int);
 char *decode_string(uint8_t const *,int);
 uint32_t get_ssrc(uint8_t const *buffer,int length);